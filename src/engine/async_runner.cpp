@@ -0,0 +1,182 @@
+// async_runner.h的实现
+
+#include "async_runner.h"
+
+#include <string.h>
+
+#include "engine/engine.h"
+#include "utils/logging.h"
+
+AsyncRunner::AsyncRunner(NNEngine *engine) : engine_(engine), next_handle_(0), stop_(false)
+{
+    for (int i = 0; i < kMaxInflight; i++)
+    {
+        jobs_[i].handle = -1;
+        jobs_[i].state = JOB_FREE;
+    }
+    thread_ = std::thread(&AsyncRunner::worker, this);
+}
+
+AsyncRunner::~AsyncRunner()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_job_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+// 按模型输出属性准备输出内存，只在第一次使用该槽位时分配
+void AsyncRunner::PrepareOutputs(Job &job)
+{
+    auto &output_shapes = engine_->GetOutputShapes();
+    if (job.outputs.size() == output_shapes.size() && job.storage.size() == output_shapes.size())
+    {
+        bool same = true;
+        for (size_t i = 0; i < output_shapes.size(); i++)
+        {
+            tensor_datatype_e type = job.want_float ? NN_TENSOR_FLOAT : output_shapes[i].type;
+            same = same && job.outputs[i].attr.type == type;
+        }
+        if (same)
+        {
+            return;
+        }
+    }
+    job.outputs.resize(output_shapes.size());
+    job.storage.resize(output_shapes.size());
+    for (size_t i = 0; i < output_shapes.size(); i++)
+    {
+        tensor_data_s &tensor = job.outputs[i];
+        tensor.attr = output_shapes[i];
+        tensor.attr.type = job.want_float ? NN_TENSOR_FLOAT : output_shapes[i].type;
+        tensor.attr.size = tensor.attr.n_elems * nn_tensor_type_to_size(tensor.attr.type);
+        job.storage[i].resize(tensor.attr.size);
+        tensor.data = job.storage[i].data();
+    }
+}
+
+/**
+ * @brief 提交一次推理到辅助线程
+ * @param inputs 输入张量
+ * @param want_float 是否需要float类型的输出
+ * @param handle 返回的异步句柄
+ * @return nn_error_e 错误码
+ */
+nn_error_e AsyncRunner::RunAsync(std::vector<tensor_data_s> &inputs, bool want_float, int &handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Job *job = nullptr;
+        for (int i = 0; i < kMaxInflight; i++)
+        {
+            if (jobs_[i].state == JOB_FREE)
+            {
+                job = &jobs_[i];
+                break;
+            }
+        }
+        if (job == nullptr)
+        {
+            NN_LOG_ERROR("too many inflight async runs, max=%d", kMaxInflight);
+            return NN_ASYNC_HANDLE_INVALID;
+        }
+        job->want_float = want_float;
+        PrepareOutputs(*job);
+        job->inputs = inputs;
+        job->handle = next_handle_++;
+        job->state = JOB_QUEUED;
+        handle = job->handle;
+    }
+    cv_job_.notify_one();
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 等待异步推理完成
+ * @param handle RunAsync返回的句柄
+ * @param outputs 输出张量，结果会拷贝到outputs[i].data
+ * @return nn_error_e 错误码
+ */
+nn_error_e AsyncRunner::Wait(int handle, std::vector<tensor_data_s> &outputs)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    Job *job = nullptr;
+    for (int i = 0; i < kMaxInflight; i++)
+    {
+        if (jobs_[i].state != JOB_FREE && jobs_[i].handle == handle)
+        {
+            job = &jobs_[i];
+            break;
+        }
+    }
+    if (job == nullptr)
+    {
+        NN_LOG_ERROR("invalid async handle: %d", handle);
+        return NN_ASYNC_HANDLE_INVALID;
+    }
+    cv_done_.wait(lock, [&]
+                  { return job->state == JOB_DONE; });
+    nn_error_e ret = job->ret;
+    if (ret == NN_SUCCESS)
+    {
+        if (outputs.size() != job->outputs.size())
+        {
+            ret = NN_IO_NUM_NOT_MATCH;
+        }
+        for (size_t i = 0; ret == NN_SUCCESS && i < outputs.size(); i++)
+        {
+            if (outputs[i].attr.size < job->outputs[i].attr.size)
+            {
+                NN_LOG_ERROR("async output %ld size not match! %d < %d", i, outputs[i].attr.size, job->outputs[i].attr.size);
+                ret = NN_RKNN_OUTPUT_ATTR_ERROR;
+                break;
+            }
+            memcpy(outputs[i].data, job->outputs[i].data, job->outputs[i].attr.size);
+        }
+    }
+    job->state = JOB_FREE;
+    return ret;
+}
+
+// 辅助线程：按提交顺序依次执行推理
+void AsyncRunner::worker()
+{
+    while (true)
+    {
+        Job *job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_job_.wait(lock, [&]
+                         {
+                             if (stop_)
+                             {
+                                 return true;
+                             }
+                             for (int i = 0; i < kMaxInflight; i++)
+                             {
+                                 if (jobs_[i].state == JOB_QUEUED && (job == nullptr || jobs_[i].handle < job->handle))
+                                 {
+                                     job = &jobs_[i];
+                                 }
+                             }
+                             return job != nullptr; });
+            if (stop_)
+            {
+                return;
+            }
+        }
+        // 推理过程中不持有锁，Wait/RunAsync不会被阻塞
+        nn_error_e ret = engine_->Run(job->inputs, job->outputs, job->want_float);
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            job->ret = ret;
+            job->state = JOB_DONE;
+        }
+        cv_done_.notify_all();
+    }
+}
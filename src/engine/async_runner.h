@@ -0,0 +1,60 @@
+// 通用异步推理：在辅助线程上调用NNEngine::Run，用于没有原生异步接口的引擎
+
+#ifndef RK3588_DEMO_ASYNC_RUNNER_H
+#define RK3588_DEMO_ASYNC_RUNNER_H
+
+#include "types/error.h"
+#include "types/datatype.h"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class NNEngine;
+
+class AsyncRunner
+{
+public:
+    explicit AsyncRunner(NNEngine *engine);
+    ~AsyncRunner();
+
+    // 提交一次推理，立即返回句柄；inputs[i].data在Wait返回前不能被修改
+    nn_error_e RunAsync(std::vector<tensor_data_s> &inputs, bool want_float, int &handle);
+    // 等待句柄对应的推理完成，结果拷贝到outputs
+    nn_error_e Wait(int handle, std::vector<tensor_data_s> &outputs);
+
+private:
+    static const int kMaxInflight = 2; // 同时在途的推理数量
+
+    enum job_state_e
+    {
+        JOB_FREE = 0,
+        JOB_QUEUED = 1,
+        JOB_DONE = 2,
+    };
+
+    struct Job
+    {
+        int handle;
+        job_state_e state;
+        bool want_float;
+        nn_error_e ret;
+        std::vector<tensor_data_s> inputs;
+        std::vector<tensor_data_s> outputs;      // 指向storage中的内存
+        std::vector<std::vector<uint8_t>> storage; // 输出内存，第一次使用时分配，之后复用
+    };
+
+    void worker();
+    void PrepareOutputs(Job &job);
+
+    NNEngine *engine_;
+    Job jobs_[kMaxInflight];
+    int next_handle_;
+    bool stop_;
+    std::mutex mtx_;
+    std::condition_variable cv_job_, cv_done_;
+    std::thread thread_;
+};
+
+#endif // RK3588_DEMO_ASYNC_RUNNER_H
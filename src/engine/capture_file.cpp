@@ -0,0 +1,125 @@
+// capture_file.h的实现
+
+#include "capture_file.h"
+
+#include <string.h>
+
+#include "utils/logging.h"
+
+static const char g_capture_magic[8] = {'N', 'N', 'C', 'A', 'P', '0', '0', '1'};
+
+CaptureWriter::~CaptureWriter()
+{
+    if (fp_ != nullptr)
+    {
+        fclose(fp_);
+        NN_LOG_INFO("capture closed, %u frames", frame_count_);
+    }
+}
+
+/**
+ * @brief 创建录制文件并写入文件头
+ * @param path 文件路径
+ * @param in_shapes 模型输入属性
+ * @param out_shapes 模型输出属性，每帧按outputs[i].size写入
+ * @return nn_error_e 错误码
+ */
+nn_error_e CaptureWriter::Open(const std::string &path, const std::vector<tensor_attr_s> &in_shapes,
+                               const std::vector<tensor_attr_s> &out_shapes)
+{
+    fp_ = fopen(path.c_str(), "wb");
+    if (fp_ == nullptr)
+    {
+        NN_LOG_ERROR("open capture file %s fail!", path.c_str());
+        return NN_FILE_WRITE_FAIL;
+    }
+    uint32_t n_inputs = in_shapes.size();
+    uint32_t n_outputs = out_shapes.size();
+    fwrite(g_capture_magic, 1, sizeof(g_capture_magic), fp_);
+    fwrite(&n_inputs, sizeof(n_inputs), 1, fp_);
+    fwrite(&n_outputs, sizeof(n_outputs), 1, fp_);
+    fwrite(in_shapes.data(), sizeof(tensor_attr_s), n_inputs, fp_);
+    if (fwrite(out_shapes.data(), sizeof(tensor_attr_s), n_outputs, fp_) != n_outputs)
+    {
+        NN_LOG_ERROR("write capture header %s fail!", path.c_str());
+        return NN_FILE_WRITE_FAIL;
+    }
+    out_shapes_ = out_shapes;
+    NN_LOG_INFO("capture to %s", path.c_str());
+    return NN_SUCCESS;
+}
+
+nn_error_e CaptureWriter::WriteFrame(const std::vector<tensor_data_s> &outputs)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (fp_ == nullptr || outputs.size() != out_shapes_.size())
+    {
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        if (fwrite(outputs[i].data, 1, out_shapes_[i].size, fp_) != out_shapes_[i].size)
+        {
+            NN_LOG_ERROR("write capture frame fail!");
+            return NN_FILE_WRITE_FAIL;
+        }
+    }
+    frame_count_++;
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 打开录制文件，文件只读映射，多个回放引擎共享
+ * @param path 文件路径
+ * @return nn_error_e 错误码
+ */
+nn_error_e CaptureReader::Open(const std::string &path)
+{
+    blob_ = ModelBlobCache::Instance().Acquire(path);
+    if (blob_ == nullptr)
+    {
+        return NN_LOAD_MODEL_FAIL;
+    }
+    const uint8_t *data = (const uint8_t *)blob_->Data();
+    size_t size = blob_->Size();
+    uint32_t n_inputs = 0, n_outputs = 0;
+    size_t fixed_size = sizeof(g_capture_magic) + sizeof(n_inputs) + sizeof(n_outputs);
+    if (size < fixed_size || memcmp(data, g_capture_magic, sizeof(g_capture_magic)) != 0)
+    {
+        NN_LOG_ERROR("%s is not a capture file!", path.c_str());
+        return NN_LOAD_MODEL_FAIL;
+    }
+    memcpy(&n_inputs, data + sizeof(g_capture_magic), sizeof(n_inputs));
+    memcpy(&n_outputs, data + sizeof(g_capture_magic) + sizeof(n_inputs), sizeof(n_outputs));
+    header_size_ = fixed_size + (size_t)(n_inputs + n_outputs) * sizeof(tensor_attr_s);
+    if (size < header_size_)
+    {
+        NN_LOG_ERROR("capture file %s header truncated!", path.c_str());
+        return NN_LOAD_MODEL_FAIL;
+    }
+    in_shapes_.resize(n_inputs);
+    out_shapes_.resize(n_outputs);
+    memcpy(in_shapes_.data(), data + fixed_size, n_inputs * sizeof(tensor_attr_s));
+    memcpy(out_shapes_.data(), data + fixed_size + n_inputs * sizeof(tensor_attr_s), n_outputs * sizeof(tensor_attr_s));
+
+    frame_size_ = 0;
+    out_offsets_.clear();
+    for (auto &shape : out_shapes_)
+    {
+        out_offsets_.push_back(frame_size_);
+        frame_size_ += shape.size;
+    }
+    frame_count_ = frame_size_ > 0 ? (size - header_size_) / frame_size_ : 0;
+    if (frame_count_ == 0)
+    {
+        NN_LOG_ERROR("capture file %s has no frames!", path.c_str());
+        return NN_LOAD_MODEL_FAIL;
+    }
+    NN_LOG_INFO("capture %s: inputs: %u, outputs: %u, frames: %u", path.c_str(), n_inputs, n_outputs, frame_count_);
+    return NN_SUCCESS;
+}
+
+const uint8_t *CaptureReader::Output(uint32_t frame, uint32_t index) const
+{
+    return (const uint8_t *)blob_->Data() + header_size_ + frame_size_ * frame + out_offsets_[index];
+}
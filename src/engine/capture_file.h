@@ -0,0 +1,64 @@
+// 推理输出录制文件：记录模型的输入输出属性和每帧的输出张量，用于在没有NPU的机器上回放
+//
+// 文件格式（小端，结构体按原样写入，aarch64和x86_64的布局一致）：
+//   char magic[8] = "NNCAP001"
+//   uint32_t n_inputs, n_outputs
+//   tensor_attr_s inputs[n_inputs]
+//   tensor_attr_s outputs[n_outputs]
+//   之后每帧依次为outputs[0..n_outputs)的数据，每个输出outputs[i].size字节，直到文件结束
+
+#ifndef RK3588_DEMO_CAPTURE_FILE_H
+#define RK3588_DEMO_CAPTURE_FILE_H
+
+#include "types/error.h"
+#include "types/datatype.h"
+#include "utils/model_cache.h"
+
+#include <stdio.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 录制：Open写入文件头，之后每次推理调用WriteFrame
+class CaptureWriter
+{
+public:
+    CaptureWriter() : fp_(nullptr), frame_count_(0){};
+    ~CaptureWriter();
+
+    nn_error_e Open(const std::string &path, const std::vector<tensor_attr_s> &in_shapes,
+                    const std::vector<tensor_attr_s> &out_shapes);
+    nn_error_e WriteFrame(const std::vector<tensor_data_s> &outputs); // 写入一帧的输出，可以在多个线程中调用
+    uint32_t FrameCount() const { return frame_count_; }
+
+private:
+    FILE *fp_;
+    std::mutex mtx_;
+    std::vector<tensor_attr_s> out_shapes_;
+    uint32_t frame_count_;
+};
+
+// 回放：只读映射录制文件，按帧序号取出输出数据
+class CaptureReader
+{
+public:
+    nn_error_e Open(const std::string &path);
+
+    const std::vector<tensor_attr_s> &InputShapes() const { return in_shapes_; }
+    const std::vector<tensor_attr_s> &OutputShapes() const { return out_shapes_; }
+    uint32_t FrameCount() const { return frame_count_; }
+    const uint8_t *Output(uint32_t frame, uint32_t index) const; // 第frame帧的第index个输出
+
+private:
+    std::shared_ptr<ModelBlob> blob_;
+    std::vector<tensor_attr_s> in_shapes_;
+    std::vector<tensor_attr_s> out_shapes_;
+    std::vector<size_t> out_offsets_; // 每个输出在一帧中的偏移
+    size_t header_size_{0};
+    size_t frame_size_{0};
+    uint32_t frame_count_{0};
+};
+
+#endif // RK3588_DEMO_CAPTURE_FILE_H
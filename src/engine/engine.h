@@ -5,10 +5,43 @@
 
 #include "types/error.h"
 #include "types/datatype.h"
+#include "engine/memory_provider.h"
+#include "engine/async_runner.h"
+#include "engine/perf_profiler.h"
 
 #include <vector>
 #include <memory>
 
+// NPU核心掩码，取值和rknn_core_mask一致
+typedef enum
+{
+    NN_NPU_CORE_AUTO = 0,    // 由驱动自动选择核心
+    NN_NPU_CORE_0 = 1,       // 核心0
+    NN_NPU_CORE_1 = 2,       // 核心1
+    NN_NPU_CORE_2 = 4,       // 核心2
+    NN_NPU_CORE_0_1 = 3,     // 核心0和1联合
+    NN_NPU_CORE_0_1_2 = 7,   // 三核联合（延迟优先）
+} nn_core_mask_e;
+
+// 推理后端
+typedef enum
+{
+    NN_BACKEND_RKNN = 0,       // RK3588 NPU
+    NN_BACKEND_REPLAY = 1,     // 回放录制文件，不需要NPU
+    NN_BACKEND_OPENCV_DNN = 2, // OpenCV DNN在CPU上运行ONNX模型
+} nn_backend_e;
+
+static const int g_npu_core_num = 3; // RK3588的NPU核心数
+
+// NPU核心使用统计（进程内所有引擎累计）
+typedef struct
+{
+    uint64_t run_count[g_npu_core_num]; // 每个核心参与的推理次数
+    uint64_t busy_us[g_npu_core_num];   // 每个核心的推理耗时（微秒）
+    uint64_t auto_run_count;            // 未绑定核心（AUTO）的推理次数，无法归到具体核心
+    uint64_t auto_busy_us;              // 未绑定核心（AUTO）的推理耗时（微秒）
+} nn_npu_usage_s;
+
 class NNEngine
 {
 public:
@@ -20,9 +53,49 @@ public:
     virtual const std::vector<tensor_attr_s> &GetInputShapes() = 0;                                                      // 获取输入张量的形状
     virtual const std::vector<tensor_attr_s> &GetOutputShapes() = 0;                                                     // 获取输出张量的形状
     virtual nn_error_e Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outpus, bool want_float) = 0; // 运行模型
-    
+
+    // 以下为可选功能，引擎不支持时返回NN_NOT_SUPPORTED
+    virtual nn_error_e EnableZeroCopy(std::shared_ptr<MemoryProvider> /*provider*/) { return NN_NOT_SUPPORTED; } // 开启零拷贝，provider为空时使用引擎自带的实现
+    virtual std::shared_ptr<ZeroCopyIO> GetZeroCopyIO() { return nullptr; }                                 // 获取零拷贝输入输出，未开启时为空
+    virtual nn_error_e SetOutputPrealloc(bool /*enable*/) { return NN_NOT_SUPPORTED; }                          // 输出直接写入调用者的outputs[i].data，不再分配临时内存
+    virtual nn_error_e SetNativeOutputLayout(bool /*enable*/) { return NN_NOT_SUPPORTED; }                      // 输出使用NPU原生的NHWC布局，省去驱动的转置；需要在EnableZeroCopy之前调用，只在零拷贝模式下有效
+    virtual nn_error_e GetDynamicInputShapes(uint32_t /*index*/, std::vector<tensor_attr_s> & /*shapes*/) { return NN_NOT_SUPPORTED; } // 动态输入模型支持的输入形状
+    virtual nn_error_e SetInputShapes(const std::vector<tensor_attr_s> & /*shapes*/) { return NN_NOT_SUPPORTED; }                 // 设置动态输入模型的输入形状，之后GetInputShapes/GetOutputShapes返回当前形状
+    virtual nn_error_e SetAsyncMode(bool /*enable*/) { return NN_NOT_SUPPORTED; }                               // 使用引擎原生的异步推理，需要在LoadModelFile之前调用
+    virtual nn_error_e SetCoreMask(nn_core_mask_e /*core_mask*/) { return NN_NOT_SUPPORTED; }                   // 绑定运行的NPU核心
+    virtual nn_error_e SetBatchCoreNum(int /*core_num*/) { return NN_NOT_SUPPORTED; }                           // 批量模型的一批图像分到几个NPU核心上并行
+    virtual nn_error_e Clone(std::shared_ptr<NNEngine> & /*engine*/) { return NN_NOT_SUPPORTED; }                // 从已加载的引擎复制出一个共享权重的新引擎
+    virtual uint64_t GetWeightSize() { return 0; }                                                          // 模型权重占用的内存（字节），未知时为0
+    virtual nn_error_e EnableProfiling(const char * /*report_path*/) { return NN_NOT_SUPPORTED; }                 // 逐层性能统计，需要在LoadModelFile之前调用；引擎销毁时写出<report_path>.csv/.json
+    virtual std::shared_ptr<PerfProfiler> GetProfiler() { return nullptr; }                                 // 获取逐层性能统计，未开启时为空
+    virtual nn_error_e EnableCapture(const char * /*capture_path*/) { return NN_NOT_SUPPORTED; }                  // 把之后每次推理的输出录制到文件，供回放引擎使用
+
+    // 异步推理：RunAsync提交后立即返回句柄，Wait等待完成并取回输出
+    // 默认实现在辅助线程上调用Run，inputs[i].data在Wait返回前不能被修改
+    virtual nn_error_e RunAsync(std::vector<tensor_data_s> &inputs, bool want_float, int &handle)
+    {
+        if (async_runner_ == nullptr)
+        {
+            async_runner_ = std::make_shared<AsyncRunner>(this);
+        }
+        return async_runner_->RunAsync(inputs, want_float, handle);
+    }
+    virtual nn_error_e Wait(int handle, std::vector<tensor_data_s> &outputs)
+    {
+        if (async_runner_ == nullptr)
+        {
+            return NN_ASYNC_HANDLE_INVALID;
+        }
+        return async_runner_->Wait(handle, outputs);
+    }
+
+protected:
+    std::shared_ptr<AsyncRunner> async_runner_; // 通用异步推理的辅助线程，子类析构时需要先释放
 };
 
-std::shared_ptr<NNEngine> CreateRKNNEngine(); // 创建RKNN引擎
+std::shared_ptr<NNEngine> CreateRKNNEngine();                                               // 创建RKNN引擎，编译时关闭RKNN后返回空
+std::shared_ptr<NNEngine> CreateReplayEngine(uint32_t latency_us = 0);                     // 创建回放引擎，latency_us为模拟的推理耗时
+std::shared_ptr<NNEngine> CreateOpenCVDnnEngine(int input_width = 640, int input_height = 640); // 创建OpenCV DNN引擎（CPU）
+nn_npu_usage_s GetNPUUsage();                 // 获取NPU核心使用统计
 
 #endif // RK3588_DEMO_ENGINE_H
@@ -0,0 +1,22 @@
+// 编译时关闭RKNN（ENABLE_RKNN=OFF）时代替rknn_engine.cpp，只能使用回放引擎
+
+#include "engine.h"
+
+#include <string.h>
+
+#include "utils/logging.h"
+
+// 创建RKNN引擎：没有编译RKNN，返回空
+std::shared_ptr<NNEngine> CreateRKNNEngine()
+{
+    NN_LOG_ERROR("built without rknn, use the replay backend instead");
+    return nullptr;
+}
+
+// 获取NPU核心使用统计：没有NPU，全部为0
+nn_npu_usage_s GetNPUUsage()
+{
+    nn_npu_usage_s usage;
+    memset(&usage, 0, sizeof(usage));
+    return usage;
+}
@@ -0,0 +1,153 @@
+// memory_provider.h的实现
+
+#include "memory_provider.h"
+
+#include <string.h>
+
+#include "utils/logging.h"
+
+// 堆内存提供者：只分配内存，不绑定任何后端，用于在没有NPU的机器上验证零拷贝流程
+class HeapMemoryProvider : public MemoryProvider
+{
+public:
+    nn_error_e AllocInput(const tensor_attr_s &attr, tensor_mem_s &mem) override { return Alloc(attr, mem); }
+    nn_error_e AllocOutput(const tensor_attr_s &attr, tensor_mem_s &mem) override { return Alloc(attr, mem); }
+    void Free(tensor_mem_s &mem) override
+    {
+        free(mem.virt_addr);
+        mem.virt_addr = nullptr;
+    }
+
+private:
+    nn_error_e Alloc(const tensor_attr_s &attr, tensor_mem_s &mem)
+    {
+        mem.virt_addr = malloc(attr.size);
+        if (mem.virt_addr == nullptr)
+        {
+            NN_LOG_ERROR("malloc tensor memory fail! size=%d", attr.size);
+            return NN_MEM_ALLOC_FAIL;
+        }
+        mem.size = attr.size;
+        mem.fd = -1;
+        mem.handle = nullptr;
+        return NN_SUCCESS;
+    }
+};
+
+ZeroCopyIO::~ZeroCopyIO()
+{
+    Release();
+}
+
+/**
+ * @brief 为每个输入输出张量分配内存并绑定到后端
+ * @param in_shapes 模型输入张量属性
+ * @param out_shapes 模型输出张量属性
+ * @return nn_error_e 错误码
+ */
+nn_error_e ZeroCopyIO::Setup(const std::vector<tensor_attr_s> &in_shapes, const std::vector<tensor_attr_s> &out_shapes)
+{
+    Release();
+    for (size_t i = 0; i < in_shapes.size(); i++)
+    {
+        // 输入统一使用uint8图像数据，由后端完成量化
+        tensor_data_s tensor;
+        tensor.attr = in_shapes[i];
+        tensor.attr.type = NN_TENSOR_UINT8;
+        tensor.attr.size = tensor.attr.n_elems * nn_tensor_type_to_size(NN_TENSOR_UINT8);
+        tensor_mem_s mem;
+        auto ret = provider_->AllocInput(tensor.attr, mem);
+        if (ret != NN_SUCCESS)
+        {
+            NN_LOG_ERROR("zero copy alloc input %ld fail!", i);
+            Release();
+            return ret;
+        }
+        tensor.data = mem.virt_addr;
+        in_mems_.push_back(mem);
+        inputs_.push_back(tensor);
+    }
+    for (size_t i = 0; i < out_shapes.size(); i++)
+    {
+        tensor_data_s tensor;
+        tensor.attr = out_shapes[i];
+        tensor_mem_s mem;
+        auto ret = provider_->AllocOutput(tensor.attr, mem);
+        if (ret != NN_SUCCESS)
+        {
+            NN_LOG_ERROR("zero copy alloc output %ld fail!", i);
+            Release();
+            return ret;
+        }
+        tensor.data = mem.virt_addr;
+        out_mems_.push_back(mem);
+        outputs_.push_back(tensor);
+    }
+    NN_LOG_INFO("zero copy io ready, inputs: %ld, outputs: %ld", inputs_.size(), outputs_.size());
+    return NN_SUCCESS;
+}
+
+// 推理前：调用者已经直接写入绑定内存时什么都不做，否则拷贝一次
+nn_error_e ZeroCopyIO::BeforeRun(const std::vector<tensor_data_s> &inputs)
+{
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        if (inputs[i].data == inputs_[i].data)
+        {
+            continue;
+        }
+        if (inputs[i].attr.size > inputs_[i].attr.size)
+        {
+            NN_LOG_ERROR("zero copy input %ld size not match! %d > %d", i, inputs[i].attr.size, inputs_[i].attr.size);
+            return NN_RKNN_INPUT_ATTR_ERROR;
+        }
+        memcpy(inputs_[i].data, inputs[i].data, inputs[i].attr.size);
+    }
+    return NN_SUCCESS;
+}
+
+// 推理后：调用者直接读取绑定内存时什么都不做，否则拷贝一次；绑定内存中是量化输出，不能转为float
+nn_error_e ZeroCopyIO::AfterRun(std::vector<tensor_data_s> &outputs, bool want_float)
+{
+    if (want_float)
+    {
+        NN_LOG_ERROR("zero copy outputs are quantized, want_float is not supported!");
+        return NN_NOT_SUPPORTED;
+    }
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        if (outputs[i].data == outputs_[i].data)
+        {
+            continue;
+        }
+        if (outputs[i].attr.size < outputs_[i].attr.size)
+        {
+            NN_LOG_ERROR("zero copy output %ld size not match! %d < %d", i, outputs[i].attr.size, outputs_[i].attr.size);
+            return NN_RKNN_OUTPUT_ATTR_ERROR;
+        }
+        memcpy(outputs[i].data, outputs_[i].data, outputs_[i].attr.size);
+    }
+    return NN_SUCCESS;
+}
+
+void ZeroCopyIO::Release()
+{
+    for (auto &mem : in_mems_)
+    {
+        provider_->Free(mem);
+    }
+    for (auto &mem : out_mems_)
+    {
+        provider_->Free(mem);
+    }
+    in_mems_.clear();
+    out_mems_.clear();
+    inputs_.clear();
+    outputs_.clear();
+}
+
+// 创建堆内存提供者
+std::shared_ptr<MemoryProvider> CreateHeapMemoryProvider()
+{
+    return std::make_shared<HeapMemoryProvider>();
+}
@@ -0,0 +1,59 @@
+// 零拷贝输入输出内存接口定义
+
+#ifndef RK3588_DEMO_MEMORY_PROVIDER_H
+#define RK3588_DEMO_MEMORY_PROVIDER_H
+
+#include "types/error.h"
+#include "types/datatype.h"
+
+#include <vector>
+#include <memory>
+
+// 一块可以直接被推理后端访问的张量内存
+typedef struct
+{
+    void *virt_addr; // 虚拟地址，CPU直接读写
+    uint32_t size;   // 内存大小（字节）
+    int32_t fd;      // dma-buf fd，没有则为-1
+    void *handle;    // 后端私有句柄（如rknn_tensor_mem*）
+} tensor_mem_s;
+
+// 内存提供者：负责分配张量内存并绑定到推理后端
+// RKEngine使用rknn_create_mem/rknn_set_io_mem实现；没有NPU的环境下可以用堆内存实现替代，方便测试零拷贝流程
+class MemoryProvider
+{
+public:
+    virtual ~MemoryProvider(){};
+    virtual nn_error_e AllocInput(const tensor_attr_s &attr, tensor_mem_s &mem) = 0;  // 分配并绑定输入张量内存
+    virtual nn_error_e AllocOutput(const tensor_attr_s &attr, tensor_mem_s &mem) = 0; // 分配并绑定输出张量内存
+    virtual void Free(tensor_mem_s &mem) = 0;                                         // 释放张量内存
+};
+
+// 零拷贝输入输出：模型加载后一次性分配并绑定输入输出内存，之后每帧直接在这些内存上读写
+class ZeroCopyIO
+{
+public:
+    explicit ZeroCopyIO(std::shared_ptr<MemoryProvider> provider) : provider_(provider){};
+    ~ZeroCopyIO();
+
+    nn_error_e Setup(const std::vector<tensor_attr_s> &in_shapes, const std::vector<tensor_attr_s> &out_shapes); // 分配并绑定内存
+    std::vector<tensor_data_s> &Inputs() { return inputs_; };                                                   // 输入张量（data指向绑定的内存）
+    std::vector<tensor_data_s> &Outputs() { return outputs_; };                                                 // 输出张量（data指向绑定的内存）
+    const std::vector<tensor_mem_s> &InputMems() const { return in_mems_; };                                   // 输入张量的内存（包含dma-buf fd）
+
+    nn_error_e BeforeRun(const std::vector<tensor_data_s> &inputs);            // 推理前：调用者传入的不是绑定内存时拷贝进来
+    nn_error_e AfterRun(std::vector<tensor_data_s> &outputs, bool want_float); // 推理后：调用者传入的不是绑定内存时拷贝出去，不支持want_float
+
+private:
+    void Release();
+
+    std::shared_ptr<MemoryProvider> provider_;
+    std::vector<tensor_mem_s> in_mems_;
+    std::vector<tensor_mem_s> out_mems_;
+    std::vector<tensor_data_s> inputs_;
+    std::vector<tensor_data_s> outputs_;
+};
+
+std::shared_ptr<MemoryProvider> CreateHeapMemoryProvider(); // 创建堆内存提供者（不依赖NPU）
+
+#endif // RK3588_DEMO_MEMORY_PROVIDER_H
@@ -0,0 +1,233 @@
+// opencv_dnn_engine.h的实现
+
+#include "opencv_dnn_engine.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/logging.h"
+
+// 输出量化参数：范围[-16, 16)足以覆盖YOLOv5检测头的logits（sigmoid(16)已接近1）
+static const float g_dnn_out_scale = 32.f / 255.f;
+static const int32_t g_dnn_out_zp = 0;
+static const int g_dnn_head_channels = 255; // 3个anchor，每个anchor 4个框坐标、objectness和80个类别
+
+OpenCVDnnEngine::~OpenCVDnnEngine()
+{
+    // 通用异步推理的辅助线程会调用Run，需要先停止
+    async_runner_.reset();
+}
+
+/**
+ * @brief 检查一个输出是否为sigmoid之前的YOLOv5检测头[1, 255, H, W]
+ * @param out 空推理得到的输出
+ * @param name 输出层名称，用于日志
+ * @return nn_error_e 错误码
+ */
+nn_error_e OpenCVDnnEngine::CheckOutput(const cv::Mat &out, const std::string &name)
+{
+    if (out.dims == 3)
+    {
+        // 默认导出的模型把三个检测头解码后合并成[1, N, 85]，后处理无法使用
+        NN_LOG_ERROR("onnx output %s is [%d, %d, %d], a merged and decoded output; export the model with "
+                     "3 raw detection heads [1, 255, H, W] (the same export used for rknn conversion)",
+                     name.c_str(), out.size[0], out.size[1], out.size[2]);
+        return NN_RKNN_OUTPUT_ATTR_ERROR;
+    }
+    if (out.dims != 4 || out.size[1] != g_dnn_head_channels)
+    {
+        NN_LOG_ERROR("onnx output %s is not a yolov5 detection head [1, %d, H, W], dims=%d", name.c_str(),
+                     g_dnn_head_channels, out.dims);
+        return NN_RKNN_OUTPUT_ATTR_ERROR;
+    }
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 输出量化为int8，scale/zp固定，超出[-16, 16)的logits截断到边界
+ * @param src float输出
+ * @param n_elems 元素数量
+ * @param dst int8输出
+ * @return uint32_t 被截断的元素数量
+ */
+uint32_t OpenCVDnnEngine::QuantizeOutput(const float *src, size_t n_elems, int8_t *dst)
+{
+    uint32_t clipped = 0;
+    for (size_t j = 0; j < n_elems; j++)
+    {
+        float q = std::round(src[j] / g_dnn_out_scale) + g_dnn_out_zp;
+        if (q < -128.f || q > 127.f)
+        {
+            clipped++;
+            q = std::max(-128.f, std::min(127.f, q));
+        }
+        dst[j] = (int8_t)q;
+    }
+    return clipped;
+}
+
+/**
+ * @brief 加载ONNX模型，并用一次空推理得到输出形状
+ *        模型需要输出三个sigmoid之前的检测头[1, 255, H, W]，见opencv_dnn_engine.h
+ * @param model_file ONNX模型文件路径
+ * @return nn_error_e 错误码
+ */
+nn_error_e OpenCVDnnEngine::LoadModelFile(const char *model_file)
+{
+    try
+    {
+        net_ = cv::dnn::readNetFromONNX(model_file);
+    }
+    catch (const cv::Exception &e)
+    {
+        NN_LOG_ERROR("load onnx model %s fail! %s", model_file, e.what());
+        return NN_LOAD_MODEL_FAIL;
+    }
+    if (net_.empty())
+    {
+        NN_LOG_ERROR("load onnx model %s fail!", model_file);
+        return NN_LOAD_MODEL_FAIL;
+    }
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+
+    // 输入：和RKNN引擎一致，uint8 NHWC，归一化在Run中完成
+    tensor_attr_s in_shape;
+    memset(&in_shape, 0, sizeof(in_shape));
+    in_shape.index = 0;
+    in_shape.n_dims = 4;
+    in_shape.dims[0] = 1;
+    in_shape.dims[1] = input_height_;
+    in_shape.dims[2] = input_width_;
+    in_shape.dims[3] = 3;
+    in_shape.n_elems = input_width_ * input_height_ * 3;
+    in_shape.size = in_shape.n_elems;
+    in_shape.type = NN_TENSOR_UINT8;
+    in_shape.layout = NN_TENSOR_NHWC;
+    in_shapes_.push_back(in_shape);
+
+    // 空推理得到输出形状
+    std::vector<cv::String> names = net_.getUnconnectedOutLayersNames();
+    const int blob_size[4] = {1, 3, input_height_, input_width_};
+    cv::Mat blob = cv::Mat::zeros(4, blob_size, CV_32F);
+    net_.setInput(blob);
+    std::vector<cv::Mat> outs;
+    net_.forward(outs, names);
+
+    // 按网格从大到小（stride 8/16/32）排列，和后处理的输入顺序一致
+    std::vector<int> order(outs.size());
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+              { return outs[a].total() > outs[b].total(); });
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        const cv::Mat &out = outs[order[i]];
+        auto ret = CheckOutput(out, names[order[i]]);
+        if (ret != NN_SUCCESS)
+        {
+            return ret;
+        }
+        tensor_attr_s shape;
+        memset(&shape, 0, sizeof(shape));
+        shape.index = i;
+        shape.n_dims = 4;
+        for (int j = 0; j < 4; j++)
+        {
+            shape.dims[j] = out.size[j];
+        }
+        shape.n_elems = out.total();
+        shape.size = shape.n_elems * nn_tensor_type_to_size(NN_TENSOR_INT8);
+        shape.type = NN_TENSOR_INT8;
+        shape.layout = NN_TENSOR_NCHW;
+        shape.zp = g_dnn_out_zp;
+        shape.scale = g_dnn_out_scale;
+        out_shapes_.push_back(shape);
+        out_names_.push_back(names[order[i]]);
+        NN_LOG_INFO("onnx output %ld: %s, dims=[%d, %d, %d, %d]", i, out_names_[i].c_str(), shape.dims[0], shape.dims[1],
+                    shape.dims[2], shape.dims[3]);
+    }
+    if (out_shapes_.size() != 3)
+    {
+        NN_LOG_ERROR("onnx model has %ld outputs, yolov5 needs 3 detection heads", out_shapes_.size());
+        return NN_RKNN_OUTPUT_ATTR_ERROR;
+    }
+    loaded_ = true;
+    NN_LOG_INFO("opencv dnn engine ready, input: %dx%d", input_width_, input_height_);
+    return NN_SUCCESS;
+}
+
+const std::vector<tensor_attr_s> &OpenCVDnnEngine::GetInputShapes()
+{
+    return in_shapes_;
+}
+
+const std::vector<tensor_attr_s> &OpenCVDnnEngine::GetOutputShapes()
+{
+    return out_shapes_;
+}
+
+/**
+ * @brief 在CPU上运行模型：输入归一化后推理，输出量化为int8（want_float时直接输出float）
+ * @param inputs 输入张量，uint8 NHWC RGB图像
+ * @param outputs 输出张量
+ * @param want_float 是否需要float类型的输出
+ * @return nn_error_e 错误码
+ */
+nn_error_e OpenCVDnnEngine::Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float)
+{
+    if (!loaded_)
+    {
+        NN_LOG_ERROR("onnx model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    if (inputs.size() != 1 || outputs.size() != out_shapes_.size())
+    {
+        NN_LOG_ERROR("opencv dnn io num not match! inputs: %ld, outputs: %ld/%ld", inputs.size(), outputs.size(),
+                     out_shapes_.size());
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    cv::Mat img(input_height_, input_width_, CV_8UC3, inputs[0].data);
+    // 预处理已经是RGB，不需要再交换通道
+    cv::Mat blob = cv::dnn::blobFromImage(img, 1.0 / 255.0, cv::Size(), cv::Scalar(), false, false);
+    net_.setInput(blob);
+    net_.forward(out_blobs_, out_names_);
+
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        const float *src = (const float *)out_blobs_[i].data;
+        size_t n_elems = out_shapes_[i].n_elems;
+        if (want_float)
+        {
+            if (outputs[i].attr.size < n_elems * sizeof(float))
+            {
+                NN_LOG_ERROR("opencv dnn output %ld buffer too small!", i);
+                return NN_RKNN_OUTPUT_ATTR_ERROR;
+            }
+            memcpy(outputs[i].data, src, n_elems * sizeof(float));
+            continue;
+        }
+        if (outputs[i].attr.size < n_elems)
+        {
+            NN_LOG_ERROR("opencv dnn output %ld buffer too small!", i);
+            return NN_RKNN_OUTPUT_ATTR_ERROR;
+        }
+        uint32_t clipped = QuantizeOutput(src, n_elems, (int8_t *)outputs[i].data);
+        if (clipped > 0 && !clip_warned_)
+        {
+            NN_LOG_WARNING("opencv dnn output %ld: %u logits outside [-16, 16) clipped", i, clipped);
+            clip_warned_ = true;
+        }
+    }
+    return NN_SUCCESS;
+}
+
+// 创建OpenCV DNN引擎
+std::shared_ptr<NNEngine> CreateOpenCVDnnEngine(int input_width, int input_height)
+{
+    return std::make_shared<OpenCVDnnEngine>(input_width, input_height);
+}
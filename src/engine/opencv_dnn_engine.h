@@ -0,0 +1,47 @@
+// OpenCV DNN引擎：在CPU上运行等价的ONNX模型，用于没有NPU的机器，或NPU满载时分担任务
+// 输出按固定的scale/zp量化为int8，和RKNN引擎的输出格式一致，后处理不需要修改
+//
+// 对ONNX模型的要求（和转换RKNN模型时的导出方式相同）：
+//   1. 三个检测头分别输出，形状为[1, 255, H, W]，不能是合并解码后的[1, 25200, 85]（默认导出的yolov5s.onnx就是这种，加载时报错）
+//   2. 输出为sigmoid之前的logits：量化范围固定为[-16, 16)（scale = 32/255，zp = 0），超出的值被截断到边界，
+//      sigmoid(16)已接近1，对检测结果没有影响；sigmoid之后的输出只占[0, 1]，量化后精度很差
+
+#ifndef RK3588_DEMO_OPENCV_DNN_ENGINE_H
+#define RK3588_DEMO_OPENCV_DNN_ENGINE_H
+
+#include "engine.h"
+
+#include <string>
+#include <vector>
+
+#include <opencv2/dnn.hpp>
+
+class OpenCVDnnEngine : public NNEngine
+{
+public:
+    OpenCVDnnEngine(int input_width, int input_height) : input_width_(input_width), input_height_(input_height), loaded_(false){};
+    ~OpenCVDnnEngine() override;
+
+    nn_error_e LoadModelFile(const char *model_file) override;                                                         // 加载ONNX模型
+    const std::vector<tensor_attr_s> &GetInputShapes() override;                                                       // 输入为uint8 NHWC图像
+    const std::vector<tensor_attr_s> &GetOutputShapes() override;                                                      // 输出为int8，按网格从大到小排列
+    nn_error_e Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float) override; // 运行模型
+
+    static nn_error_e CheckOutput(const cv::Mat &out, const std::string &name);  // 检查输出是不是[1, 255, H, W]的检测头
+    static uint32_t QuantizeOutput(const float *src, size_t n_elems, int8_t *dst); // 按固定的scale/zp量化，返回超出范围被截断的数量
+
+private:
+    int input_width_;  // 模型输入宽度，ONNX模型的输入形状无法直接查询，由创建者指定
+    int input_height_; // 模型输入高度
+    bool loaded_;
+    bool clip_warned_{false}; // 输出超出量化范围时只提示一次
+
+    cv::dnn::Net net_;
+    std::vector<cv::String> out_names_;  // 输出层名称，和out_shapes_顺序一致
+    std::vector<cv::Mat> out_blobs_;     // 推理输出，复用以避免每帧分配
+
+    std::vector<tensor_attr_s> in_shapes_;
+    std::vector<tensor_attr_s> out_shapes_;
+};
+
+#endif // RK3588_DEMO_OPENCV_DNN_ENGINE_H
@@ -0,0 +1,360 @@
+// perf_profiler.h的实现
+
+#include "perf_profiler.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "utils/logging.h"
+
+// 按空白切分一行
+static std::vector<std::string> split_tokens(const std::string &line)
+{
+    std::vector<std::string> tokens;
+    std::istringstream iss(line);
+    std::string token;
+    while (iss >> token)
+    {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+// 切分表头："DDR Cycles"、"Task Number"这类列名由两个单词组成，而数据单元格中没有空格，
+// 所以把Cycles/Number合并到前一个单词，保证列名和数据单元格一一对应
+static std::vector<std::string> split_header(const std::string &line)
+{
+    std::vector<std::string> columns;
+    for (auto &token : split_tokens(line))
+    {
+        if ((token == "Cycles" || token == "Number") && !columns.empty())
+        {
+            columns.back() += " " + token;
+            continue;
+        }
+        columns.push_back(token);
+    }
+    return columns;
+}
+
+static int find_column(const std::vector<std::string> &header, const char *name)
+{
+    for (size_t i = 0; i < header.size(); i++)
+    {
+        if (header[i] == name)
+        {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static bool is_number(const std::string &s)
+{
+    if (s.empty())
+    {
+        return false;
+    }
+    for (char c : s)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 单元格的空格数不固定的列：MacUsage(%)在CPU算子上为空，WorkLoad(0/1/2)-ImproveTherical形如"100.0%/0.0%/0.0% - Up:0.0%"
+static bool is_variable_column(const std::string &column)
+{
+    return column.compare(0, 8, "MacUsage") == 0 || column.compare(0, 8, "WorkLoad") == 0;
+}
+
+// 表头中列的位置：不定宽列之前的列从左数，之后的列从右数
+struct perf_columns_s
+{
+    int n_columns;  // 表头的列数
+    int head_end;   // 第一个不定宽列，之前的列按序号取值
+    int tail_start; // 最后一个不定宽列之后的列，按到行尾的距离取值
+};
+
+static perf_columns_s locate_columns(const std::vector<std::string> &header)
+{
+    perf_columns_s columns = {(int)header.size(), (int)header.size(), (int)header.size()};
+    for (int i = 0; i < (int)header.size(); i++)
+    {
+        if (is_variable_column(header[i]))
+        {
+            columns.head_end = std::min(columns.head_end, i);
+            columns.tail_start = i + 1;
+        }
+    }
+    return columns;
+}
+
+// 第col列在一行数据中的token下标，取不到时返回-1
+static int token_index(const perf_columns_s &columns, int col, int n_tokens)
+{
+    if (col < 0)
+    {
+        return -1;
+    }
+    int index = -1;
+    if (col < columns.head_end)
+    {
+        index = col;
+    }
+    else if (col >= columns.tail_start)
+    {
+        index = n_tokens - (columns.n_columns - col);
+        // 从右数的列不能落进从左数的列里
+        if (index < columns.head_end)
+        {
+            return -1;
+        }
+    }
+    return index < n_tokens ? index : -1;
+}
+
+/**
+ * @brief 解析RKNN_QUERY_PERF_DETAIL输出的逐层耗时表
+ *        大多数单元格中没有空格，空单元格用"\"占位，按表头中列的序号取值；
+ *        MacUsage和WorkLoad列例外（可能为空或者包含空格），它们之后的列（FullName等）从行尾往前数；
+ *        ID列不是数字的行（分隔线、汇总行、后面的算子排名表）都会被跳过
+ * @param text perf detail文本
+ * @param layers 解析出的逐层耗时
+ * @return int 解析出的层数，找不到表头时返回-1
+ */
+int PerfProfiler::ParsePerfDetail(const std::string &text, std::vector<perf_layer_s> &layers)
+{
+    layers.clear();
+    std::istringstream iss(text);
+    std::string line;
+    int id_col = -1, op_col = -1, target_col = -1, name_col = -1, time_col = -1;
+    perf_columns_s columns = {0, 0, 0};
+    bool in_table = false;
+    while (std::getline(iss, line))
+    {
+        auto tokens = split_tokens(line);
+        if (tokens.empty())
+        {
+            continue;
+        }
+        if (!in_table)
+        {
+            auto header = split_header(line);
+            id_col = find_column(header, "ID");
+            op_col = find_column(header, "OpType");
+            time_col = find_column(header, "Time(us)");
+            if (id_col >= 0 && op_col >= 0 && time_col >= 0)
+            {
+                target_col = find_column(header, "Target");
+                name_col = find_column(header, "FullName");
+                columns = locate_columns(header);
+                in_table = true;
+            }
+            continue;
+        }
+        // 逐层表之后是汇总行，后面的内容不再属于逐层表
+        if (tokens[0] == "Total")
+        {
+            break;
+        }
+        int n_tokens = (int)tokens.size();
+        int id_index = token_index(columns, id_col, n_tokens);
+        int op_index = token_index(columns, op_col, n_tokens);
+        int time_index = token_index(columns, time_col, n_tokens);
+        if (id_index < 0 || op_index < 0 || time_index < 0 || !is_number(tokens[id_index]))
+        {
+            continue;
+        }
+        int target_index = token_index(columns, target_col, n_tokens);
+        int name_index = token_index(columns, name_col, n_tokens);
+        perf_layer_s layer;
+        layer.id = atoi(tokens[id_index].c_str());
+        layer.op_type = tokens[op_index];
+        layer.target = target_index >= 0 ? tokens[target_index] : "";
+        layer.name = name_index >= 0 ? tokens[name_index] : "";
+        layer.time_us = (uint32_t)strtoul(tokens[time_index].c_str(), nullptr, 10);
+        layers.push_back(layer);
+    }
+    return in_table ? (int)layers.size() : -1;
+}
+
+// 记录一帧的逐层耗时，层按ID对应
+void PerfProfiler::AddFrame(const std::vector<perf_layer_s> &layers, int64_t run_us)
+{
+    for (auto &layer : layers)
+    {
+        auto &samples = layers_[layer.id];
+        if (samples.samples.empty())
+        {
+            samples.op_type = layer.op_type;
+            samples.target = layer.target;
+            samples.name = layer.name;
+        }
+        samples.samples.push_back(layer.time_us);
+    }
+    if (run_us >= 0)
+    {
+        run_samples_.push_back((uint32_t)run_us);
+    }
+    frame_count_++;
+}
+
+// 解析并记录一帧
+nn_error_e PerfProfiler::AddFrame(const std::string &perf_detail, int64_t run_us)
+{
+    std::vector<perf_layer_s> layers;
+    if (ParsePerfDetail(perf_detail, layers) < 0)
+    {
+        NN_LOG_WARNING("perf detail has no layer table");
+        return NN_RKNN_QUERY_FAIL;
+    }
+    AddFrame(layers, run_us);
+    return NN_SUCCESS;
+}
+
+// 计算一组样本的min/mean/p99/max，p99取最近秩
+perf_layer_stat_s PerfProfiler::Summarize(std::vector<uint32_t> samples)
+{
+    perf_layer_stat_s stat;
+    stat.id = 0;
+    stat.count = (uint32_t)samples.size();
+    stat.min_us = stat.mean_us = stat.p99_us = stat.max_us = 0;
+    if (samples.empty())
+    {
+        return stat;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (auto v : samples)
+    {
+        sum += v;
+    }
+    size_t p99_rank = (size_t)std::ceil(samples.size() * 0.99);
+    stat.min_us = samples.front();
+    stat.max_us = samples.back();
+    stat.mean_us = sum / samples.size();
+    stat.p99_us = samples[std::max<size_t>(p99_rank, 1) - 1];
+    return stat;
+}
+
+std::vector<perf_layer_stat_s> PerfProfiler::LayerStats() const
+{
+    std::vector<perf_layer_stat_s> stats;
+    for (auto &item : layers_)
+    {
+        perf_layer_stat_s stat = Summarize(item.second.samples);
+        stat.id = item.first;
+        stat.op_type = item.second.op_type;
+        stat.target = item.second.target;
+        stat.name = item.second.name;
+        stats.push_back(stat);
+    }
+    return stats;
+}
+
+perf_layer_stat_s PerfProfiler::RunStats() const
+{
+    perf_layer_stat_s stat = Summarize(run_samples_);
+    stat.op_type = "Run";
+    return stat;
+}
+
+// CSV字段中有逗号或引号时加引号
+static std::string csv_field(const std::string &s)
+{
+    if (s.find_first_of(",\"") == std::string::npos)
+    {
+        return s;
+    }
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"')
+        {
+            out += '"';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string json_string(const std::string &s)
+{
+    std::string out = "\"";
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string PerfProfiler::ToCSV() const
+{
+    std::ostringstream oss;
+    oss << "id,op_type,target,name,count,min_us,mean_us,p99_us,max_us\n";
+    for (auto &stat : LayerStats())
+    {
+        oss << stat.id << "," << csv_field(stat.op_type) << "," << csv_field(stat.target) << ","
+            << csv_field(stat.name) << "," << stat.count << "," << stat.min_us << "," << stat.mean_us << ","
+            << stat.p99_us << "," << stat.max_us << "\n";
+    }
+    return oss.str();
+}
+
+static void write_stat_json(std::ostringstream &oss, const perf_layer_stat_s &stat)
+{
+    oss << "\"count\":" << stat.count << ",\"min_us\":" << stat.min_us << ",\"mean_us\":" << stat.mean_us
+        << ",\"p99_us\":" << stat.p99_us << ",\"max_us\":" << stat.max_us;
+}
+
+std::string PerfProfiler::ToJSON() const
+{
+    std::ostringstream oss;
+    oss << "{\"frames\":" << frame_count_ << ",\"run\":{";
+    write_stat_json(oss, RunStats());
+    oss << "},\"layers\":[";
+    auto stats = LayerStats();
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        auto &stat = stats[i];
+        oss << (i == 0 ? "" : ",") << "\n{\"id\":" << stat.id << ",\"op_type\":" << json_string(stat.op_type)
+            << ",\"target\":" << json_string(stat.target) << ",\"name\":" << json_string(stat.name) << ",";
+        write_stat_json(oss, stat);
+        oss << "}";
+    }
+    oss << "]}\n";
+    return oss.str();
+}
+
+/**
+ * @brief 写出统计结果
+ * @param path_prefix 文件路径前缀，写出<path_prefix>.csv和<path_prefix>.json
+ * @return nn_error_e 错误码
+ */
+nn_error_e PerfProfiler::Dump(const std::string &path_prefix) const
+{
+    std::ofstream csv(path_prefix + ".csv");
+    std::ofstream json(path_prefix + ".json");
+    if (!csv.is_open() || !json.is_open())
+    {
+        NN_LOG_ERROR("open perf report %s fail!", path_prefix.c_str());
+        return NN_FILE_WRITE_FAIL;
+    }
+    csv << ToCSV();
+    json << ToJSON();
+    NN_LOG_INFO("perf report of %u frames, %ld layers saved to %s.csv/.json", frame_count_, layers_.size(),
+                path_prefix.c_str());
+    return NN_SUCCESS;
+}
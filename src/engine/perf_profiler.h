@@ -0,0 +1,74 @@
+// 逐层性能统计：解析RKNN_QUERY_PERF_DETAIL输出的逐层耗时表，跨帧汇总后导出CSV/JSON
+// 解析和汇总不依赖rknn，可以直接用保存下来的perf detail文本验证
+
+#ifndef RK3588_DEMO_PERF_PROFILER_H
+#define RK3588_DEMO_PERF_PROFILER_H
+
+#include "types/error.h"
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// perf detail表中的一层
+typedef struct
+{
+    int id;              // 层序号（ID列）
+    std::string op_type; // 算子类型（OpType列）
+    std::string target;  // 运行单元（Target列，NPU/CPU等），没有该列时为空
+    std::string name;    // 层名称（FullName列），没有该列时为空
+    uint32_t time_us;    // 本帧耗时（Time(us)列）
+} perf_layer_s;
+
+// 一层跨帧的耗时统计
+typedef struct
+{
+    int id;
+    std::string op_type;
+    std::string target;
+    std::string name;
+    uint32_t count;  // 样本数
+    double min_us;   // 最小耗时
+    double mean_us;  // 平均耗时
+    double p99_us;   // 99分位耗时
+    double max_us;   // 最大耗时
+} perf_layer_stat_s;
+
+class PerfProfiler
+{
+public:
+    PerfProfiler(){};
+
+    // 解析一帧的perf detail文本，表头中必须有ID、OpType和Time(us)列；返回解析出的层数，表头不完整时返回-1
+    static int ParsePerfDetail(const std::string &text, std::vector<perf_layer_s> &layers);
+
+    void AddFrame(const std::vector<perf_layer_s> &layers, int64_t run_us); // 记录一帧的逐层耗时和整帧推理耗时（RKNN_QUERY_PERF_RUN）
+    nn_error_e AddFrame(const std::string &perf_detail, int64_t run_us);  // 解析并记录一帧
+
+    uint32_t FrameCount() const { return frame_count_; }
+    std::vector<perf_layer_stat_s> LayerStats() const; // 按层序号排列的统计结果
+    perf_layer_stat_s RunStats() const;                // 整帧推理耗时的统计结果
+
+    std::string ToCSV() const;  // 每层一行：id,op_type,target,name,count,min_us,mean_us,p99_us,max_us
+    std::string ToJSON() const; // {"frames":N,"run":{...},"layers":[{...}]}
+    nn_error_e Dump(const std::string &path_prefix) const; // 写出<path_prefix>.csv和<path_prefix>.json
+
+private:
+    struct LayerSamples
+    {
+        std::string op_type;
+        std::string target;
+        std::string name;
+        std::vector<uint32_t> samples;
+    };
+
+    static perf_layer_stat_s Summarize(std::vector<uint32_t> samples);
+
+    uint32_t frame_count_{0};
+    std::map<int, LayerSamples> layers_; // 层序号 -> 各帧耗时
+    std::vector<uint32_t> run_samples_;  // 各帧整帧推理耗时
+};
+
+#endif // RK3588_DEMO_PERF_PROFILER_H
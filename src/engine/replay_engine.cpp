@@ -0,0 +1,106 @@
+// replay_engine.h的实现
+
+#include "replay_engine.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "utils/logging.h"
+
+ReplayEngine::~ReplayEngine()
+{
+    // 通用异步推理的辅助线程会调用Run，需要先停止
+    async_runner_.reset();
+}
+
+// 加载录制文件，文件路径代替模型文件路径
+nn_error_e ReplayEngine::LoadModelFile(const char *model_file)
+{
+    auto reader = std::make_shared<CaptureReader>();
+    auto ret = reader->Open(model_file);
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("load capture file %s fail!", model_file);
+        return ret;
+    }
+    reader_ = reader;
+    NN_LOG_INFO("replay engine ready, simulated latency: %uus", latency_us_);
+    return NN_SUCCESS;
+}
+
+const std::vector<tensor_attr_s> &ReplayEngine::GetInputShapes()
+{
+    return reader_ != nullptr ? reader_->InputShapes() : empty_shapes_;
+}
+
+const std::vector<tensor_attr_s> &ReplayEngine::GetOutputShapes()
+{
+    return reader_ != nullptr ? reader_->OutputShapes() : empty_shapes_;
+}
+
+/**
+ * @brief 回放一帧：等待模拟的推理耗时后，把录制的下一帧输出拷贝到outputs，录制的帧用完后从头开始
+ * @param inputs 输入张量，只检查数量
+ * @param outputs 输出张量
+ * @param want_float 录制的是量化输出，不支持float
+ * @return nn_error_e 错误码
+ */
+nn_error_e ReplayEngine::Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float)
+{
+    if (reader_ == nullptr)
+    {
+        NN_LOG_ERROR("replay capture not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    auto &in_shapes = reader_->InputShapes();
+    auto &out_shapes = reader_->OutputShapes();
+    if (inputs.size() != in_shapes.size() || outputs.size() != out_shapes.size())
+    {
+        NN_LOG_ERROR("replay io num not match! inputs: %ld/%ld, outputs: %ld/%ld", inputs.size(), in_shapes.size(),
+                     outputs.size(), out_shapes.size());
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    if (want_float)
+    {
+        NN_LOG_ERROR("replay only supports quantized outputs!");
+        return NN_NOT_SUPPORTED;
+    }
+    if (latency_us_ > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(latency_us_));
+    }
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        if (outputs[i].attr.size < out_shapes[i].n_elems * nn_tensor_type_to_size(out_shapes[i].type))
+        {
+            NN_LOG_ERROR("replay output %ld size not match! %d < %d", i, outputs[i].attr.size, out_shapes[i].size);
+            return NN_RKNN_OUTPUT_ATTR_ERROR;
+        }
+        memcpy(outputs[i].data, reader_->Output(next_frame_, i), std::min(outputs[i].attr.size, out_shapes[i].size));
+    }
+    next_frame_ = (next_frame_ + 1) % reader_->FrameCount();
+    return NN_SUCCESS;
+}
+
+// 复制出的引擎共享同一个录制文件，从第一帧开始回放
+nn_error_e ReplayEngine::Clone(std::shared_ptr<NNEngine> &engine)
+{
+    if (reader_ == nullptr)
+    {
+        NN_LOG_ERROR("replay capture not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    auto clone = std::make_shared<ReplayEngine>(latency_us_);
+    clone->reader_ = reader_;
+    engine = clone;
+    return NN_SUCCESS;
+}
+
+// 创建回放引擎
+std::shared_ptr<NNEngine> CreateReplayEngine(uint32_t latency_us)
+{
+    return std::make_shared<ReplayEngine>(latency_us);
+}
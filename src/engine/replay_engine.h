@@ -0,0 +1,31 @@
+// 回放引擎：从录制文件中按顺序取出每帧的输出，不需要NPU，用于在开发机上运行和测试整个流程
+
+#ifndef RK3588_DEMO_REPLAY_ENGINE_H
+#define RK3588_DEMO_REPLAY_ENGINE_H
+
+#include "engine.h"
+#include "capture_file.h"
+
+#include <memory>
+#include <vector>
+
+class ReplayEngine : public NNEngine
+{
+public:
+    explicit ReplayEngine(uint32_t latency_us) : latency_us_(latency_us), next_frame_(0){};
+    ~ReplayEngine() override;
+
+    nn_error_e LoadModelFile(const char *model_file) override;                                                         // 加载录制文件
+    const std::vector<tensor_attr_s> &GetInputShapes() override;                                                       // 录制时的输入属性
+    const std::vector<tensor_attr_s> &GetOutputShapes() override;                                                      // 录制时的输出属性
+    nn_error_e Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float) override; // 按顺序回放一帧输出
+    nn_error_e Clone(std::shared_ptr<NNEngine> &engine) override;                                                      // 共享同一个录制文件
+
+private:
+    uint32_t latency_us_; // 模拟的NPU推理耗时（微秒）
+    uint32_t next_frame_; // 下一次回放的帧
+    std::shared_ptr<CaptureReader> reader_;
+    std::vector<tensor_attr_s> empty_shapes_;
+};
+
+#endif // RK3588_DEMO_REPLAY_ENGINE_H
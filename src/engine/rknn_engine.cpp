@@ -4,11 +4,117 @@
 
 #include <string.h>
 
+#include <atomic>
+#include <chrono>
+
 #include "utils/engine_helper.h"
 #include "utils/logging.h"
+#include "utils/model_cache.h"
 
 static const int g_max_io_num = 10; // 最大输入输出张量的数量
 
+// NPU核心使用统计，所有RKEngine共享
+static std::atomic<uint64_t> g_core_run_count[g_npu_core_num];
+static std::atomic<uint64_t> g_core_busy_us[g_npu_core_num];
+static std::atomic<uint64_t> g_auto_run_count(0);
+static std::atomic<uint64_t> g_auto_busy_us(0);
+
+static uint64_t now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 把一次推理的耗时记到掩码包含的每个核心上
+static void record_core_usage(nn_core_mask_e core_mask, uint64_t elapsed_us)
+{
+    if (core_mask == NN_NPU_CORE_AUTO)
+    {
+        g_auto_run_count++;
+        g_auto_busy_us += elapsed_us;
+        return;
+    }
+    for (int i = 0; i < g_npu_core_num; i++)
+    {
+        if (core_mask & (1 << i))
+        {
+            g_core_run_count[i]++;
+            g_core_busy_us[i] += elapsed_us;
+        }
+    }
+}
+
+// 基于rknn_create_mem/rknn_set_io_mem的内存提供者，分配的内存由NPU直接读写
+class RKMemoryProvider : public MemoryProvider
+{
+public:
+    RKMemoryProvider(rknn_context ctx, const std::vector<rknn_tensor_attr> &in_attrs, const std::vector<rknn_tensor_attr> &out_attrs)
+        : ctx_(ctx), in_attrs_(in_attrs), out_attrs_(out_attrs){};
+
+    nn_error_e AllocInput(const tensor_attr_s &attr, tensor_mem_s &mem) override
+    {
+        // 输入为uint8 NHWC图像，由NPU完成归一化和量化
+        rknn_tensor_attr rknn_attr = in_attrs_[attr.index];
+        rknn_attr.type = RKNN_TENSOR_UINT8;
+        rknn_attr.fmt = RKNN_TENSOR_NHWC;
+        rknn_attr.pass_through = 0;
+        // Yolov5按紧凑的行写入输入，宽度方向有对齐时每行的起始位置对不上，这种模型退回拷贝模式
+        uint32_t width = in_attrs_[attr.index].fmt == RKNN_TENSOR_NCHW ? rknn_attr.dims[3] : rknn_attr.dims[2];
+        if (rknn_attr.w_stride != 0 && rknn_attr.w_stride != width)
+        {
+            NN_LOG_ERROR("zero copy input w_stride %d != width %d, not supported!", rknn_attr.w_stride, width);
+            return NN_RKNN_INPUT_ATTR_ERROR;
+        }
+        return Bind(rknn_attr, rknn_attr.size_with_stride, mem);
+    }
+
+    nn_error_e AllocOutput(const tensor_attr_s &attr, tensor_mem_s &mem) override
+    {
+        rknn_tensor_attr rknn_attr = out_attrs_[attr.index];
+        // 原生布局的输出可能带有通道对齐，按size_with_stride分配
+        uint32_t size = rknn_attr.n_elems * nn_tensor_type_to_size(attr.type);
+        return Bind(rknn_attr, size > rknn_attr.size_with_stride ? size : rknn_attr.size_with_stride, mem);
+    }
+
+    void Free(tensor_mem_s &mem) override
+    {
+        if (mem.handle != nullptr)
+        {
+            rknn_destroy_mem(ctx_, (rknn_tensor_mem *)mem.handle);
+            mem.handle = nullptr;
+            mem.virt_addr = nullptr;
+        }
+    }
+
+private:
+    nn_error_e Bind(rknn_tensor_attr &rknn_attr, uint32_t size, tensor_mem_s &mem)
+    {
+        rknn_tensor_mem *rknn_mem = rknn_create_mem(ctx_, size);
+        if (rknn_mem == nullptr)
+        {
+            NN_LOG_ERROR("rknn_create_mem fail! size=%d", size);
+            return NN_MEM_ALLOC_FAIL;
+        }
+        int ret = rknn_set_io_mem(ctx_, rknn_mem, &rknn_attr);
+        if (ret < 0)
+        {
+            NN_LOG_ERROR("rknn_set_io_mem fail! index=%d, ret=%d", rknn_attr.index, ret);
+            rknn_destroy_mem(ctx_, rknn_mem);
+            return NN_RKNN_INPUT_SET_FAIL;
+        }
+        mem.virt_addr = rknn_mem->virt_addr;
+        mem.size = rknn_mem->size;
+        mem.fd = rknn_mem->fd;
+        mem.handle = rknn_mem;
+        return NN_SUCCESS;
+    }
+
+    rknn_context ctx_;
+    const std::vector<rknn_tensor_attr> &in_attrs_;
+    const std::vector<rknn_tensor_attr> &out_attrs_;
+};
+
 /**
  * @brief 加载模型文件、初始化rknn context、获取rknn版本信息、获取输入输出张量的信息
  * @param model_file 模型文件路径
@@ -16,14 +122,19 @@ static const int g_max_io_num = 10; // 最大输入输出张量的数量
  */
 nn_error_e RKEngine::LoadModelFile(const char *model_file)
 {
-    int model_len = 0;                               // 模型文件大小
-    auto model = load_model(model_file, &model_len); // 加载模型文件
+    // 加载模型文件：只读映射，同一模型的多个引擎共享映射，初始化完成后释放引用
+    auto model = ModelBlobCache::Instance().Acquire(model_file);
     if (model == nullptr)
     {
         NN_LOG_ERROR("load model file %s fail!", model_file);
         return NN_LOAD_MODEL_FAIL; // 返回错误码：加载模型文件失败
     }
-    int ret = rknn_init(&rknn_ctx_, model, model_len, 0, NULL); // 初始化rknn context
+    uint32_t flag = async_mode_ ? RKNN_FLAG_ASYNC_MASK : 0; // 异步模式需要在初始化时指定
+    if (profiler_ != nullptr)
+    {
+        flag |= RKNN_FLAG_COLLECT_PERF_MASK; // 逐层性能统计也需要在初始化时指定，会降低帧率
+    }
+    int ret = rknn_init(&rknn_ctx_, model->Data(), model->Size(), flag, NULL); // 初始化rknn context
     if (ret < 0)
     {
         NN_LOG_ERROR("rknn_init fail! ret=%d", ret);
@@ -32,6 +143,7 @@ nn_error_e RKEngine::LoadModelFile(const char *model_file)
     // 打印初始化成功信息
     NN_LOG_INFO("rknn_init success!");
     ctx_created_ = true;
+    perf_flag_ = profiler_ != nullptr;
 
     // 获取rknn版本信息
     rknn_sdk_version version;
@@ -55,6 +167,17 @@ nn_error_e RKEngine::LoadModelFile(const char *model_file)
     }
     NN_LOG_INFO("model input num: %d, output num: %d", io_num.n_input, io_num.n_output);
 
+    // 获取权重和内部内存大小
+    rknn_mem_size mem_size;
+    memset(&mem_size, 0, sizeof(mem_size));
+    ret = rknn_query(rknn_ctx_, RKNN_QUERY_MEM_SIZE, &mem_size, sizeof(mem_size));
+    if (ret == RKNN_SUCC)
+    {
+        weight_size_ = mem_size.total_weight_size;
+        NN_LOG_INFO("model weight size: %.2fMB, internal size: %.2fMB",
+                    mem_size.total_weight_size / 1024.0 / 1024.0, mem_size.total_internal_size / 1024.0 / 1024.0);
+    }
+
     // 保存输入输出个数
     input_num_ = io_num.n_input;
     output_num_ = io_num.n_output;
@@ -63,7 +186,7 @@ nn_error_e RKEngine::LoadModelFile(const char *model_file)
     NN_LOG_INFO("input tensors:");
     rknn_tensor_attr input_attrs[io_num.n_input];
     memset(input_attrs, 0, sizeof(input_attrs));
-    for (int i = 0; i < io_num.n_input; i++)
+    for (uint32_t i = 0; i < io_num.n_input; i++)
     {
         input_attrs[i].index = i;
         ret = rknn_query(rknn_ctx_, RKNN_QUERY_INPUT_ATTR, &(input_attrs[i]), sizeof(rknn_tensor_attr));
@@ -75,13 +198,14 @@ nn_error_e RKEngine::LoadModelFile(const char *model_file)
         print_tensor_attr(&(input_attrs[i]));
         // set input_shapes_
         in_shapes_.push_back(rknn_tensor_attr_convert(input_attrs[i]));
+        in_attrs_.push_back(input_attrs[i]);
     }
 
     // 输出属性
     NN_LOG_INFO("output tensors:");
     rknn_tensor_attr output_attrs[io_num.n_output];
     memset(output_attrs, 0, sizeof(output_attrs));
-    for (int i = 0; i < io_num.n_output; i++)
+    for (uint32_t i = 0; i < io_num.n_output; i++)
     {
         output_attrs[i].index = i;
         ret = rknn_query(rknn_ctx_, RKNN_QUERY_OUTPUT_ATTR, &(output_attrs[i]), sizeof(rknn_tensor_attr));
@@ -93,6 +217,7 @@ nn_error_e RKEngine::LoadModelFile(const char *model_file)
         print_tensor_attr(&(output_attrs[i]));
         // set output_shapes_
         out_shapes_.push_back(rknn_tensor_attr_convert(output_attrs[i]));
+        out_attrs_.push_back(output_attrs[i]);
     }
 
     return NN_SUCCESS;
@@ -111,29 +236,279 @@ const std::vector<tensor_attr_s> &RKEngine::GetOutputShapes()
 }
 
 /**
- * @brief 运行模型，获得推理结果
- * @param inputs 输入张量
- * @param outputs 输出张量
- * @param want_float 是否需要float类型的输出
+ * @brief 开启零拷贝：一次性分配输入输出内存并绑定到rknn context，之后Run不再调用rknn_inputs_set/rknn_outputs_get
+ * @param provider 内存提供者，为空时使用rknn_create_mem
  * @return nn_error_e 错误码
  */
-nn_error_e RKEngine::Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float)
+nn_error_e RKEngine::EnableZeroCopy(std::shared_ptr<MemoryProvider> provider)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    if (provider == nullptr)
+    {
+        provider = std::make_shared<RKMemoryProvider>(rknn_ctx_, in_attrs_, out_attrs_);
+    }
+    auto zero_copy_io = std::make_shared<ZeroCopyIO>(provider);
+    auto ret = zero_copy_io->Setup(in_shapes_, out_shapes_);
+    if (ret != NN_SUCCESS)
+    {
+        return ret;
+    }
+    zero_copy_io_ = zero_copy_io;
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 用rknn_dup_context从当前context复制一个新的context，新context和当前context共享权重内存，
+ *        不需要重新读取模型文件和rknn_init
+ * @param engine 复制出的新引擎（核心绑定、零拷贝等需要重新设置）
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::Clone(std::shared_ptr<NNEngine> &engine)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    auto clone = std::make_shared<RKEngine>();
+    int ret = rknn_dup_context(&rknn_ctx_, &clone->rknn_ctx_);
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_dup_context fail! ret=%d", ret);
+        return NN_RKNN_INIT_FAIL;
+    }
+    clone->ctx_created_ = true;
+    clone->input_num_ = input_num_;
+    clone->output_num_ = output_num_;
+    clone->in_shapes_ = in_shapes_;
+    clone->out_shapes_ = out_shapes_;
+    clone->in_attrs_ = in_attrs_;
+    clone->out_attrs_ = out_attrs_;
+    clone->prealloc_outputs_ = prealloc_outputs_;
+    clone->async_mode_ = async_mode_; // 复制的context沿用原context的初始化标志
+    clone->weight_size_ = weight_size_;
+    clone->native_output_ = native_output_;
+    clone->perf_flag_ = perf_flag_; // 性能统计需要对复制出的引擎单独开启
+    engine = clone;
+    NN_LOG_INFO("rknn context duplicated, weights shared");
+    return NN_SUCCESS;
+}
+
+// 模型权重大小
+uint64_t RKEngine::GetWeightSize()
+{
+    return weight_size_;
+}
+
+// 获取零拷贝输入输出
+std::shared_ptr<ZeroCopyIO> RKEngine::GetZeroCopyIO()
+{
+    return zero_copy_io_;
+}
+
+// 开启后rknn_outputs_get使用is_prealloc，直接写入outputs[i].data，Run过程中不再有malloc/memcpy/free
+nn_error_e RKEngine::SetOutputPrealloc(bool enable)
+{
+    prealloc_outputs_ = enable;
+    NN_LOG_INFO("rknn output prealloc: %s", enable ? "on" : "off");
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 输出使用NPU原生的NHWC布局：默认的NCHW输出需要驱动从NPU的原生布局转置，
+ *        NHWC布局下每个网格的所有通道连续存放，后处理可以顺序读取
+ *        rknn_outputs_get总是返回NCHW，所以只有零拷贝模式下有效
+ * @param enable 是否使用原生布局
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::SetNativeOutputLayout(bool enable)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    if (zero_copy_io_ != nullptr)
+    {
+        NN_LOG_ERROR("rknn native output layout must be set before EnableZeroCopy!");
+        return NN_NOT_SUPPORTED;
+    }
+    std::vector<tensor_attr_s> out_shapes;
+    std::vector<rknn_tensor_attr> out_attrs;
+    for (uint32_t i = 0; i < output_num_; i++)
+    {
+        rknn_tensor_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.index = i;
+        int ret = rknn_query(rknn_ctx_, enable ? RKNN_QUERY_NATIVE_NHWC_OUTPUT_ATTR : RKNN_QUERY_OUTPUT_ATTR, &attr,
+                             sizeof(rknn_tensor_attr));
+        if (ret != RKNN_SUCC)
+        {
+            NN_LOG_ERROR("rknn_query output attr fail! native=%d, ret=%d", enable, ret);
+            return NN_RKNN_QUERY_FAIL;
+        }
+        print_tensor_attr(&attr);
+        tensor_attr_s shape = rknn_tensor_attr_convert(attr);
+        // 通道有对齐时，size包含对齐后的内存大小，后处理据此计算每个网格的步长
+        shape.size = attr.size_with_stride > attr.size ? attr.size_with_stride : attr.size;
+        out_shapes.push_back(shape);
+        out_attrs.push_back(attr);
+    }
+    out_shapes_ = out_shapes;
+    out_attrs_ = out_attrs;
+    native_output_ = enable;
+    NN_LOG_INFO("rknn native nhwc output: %s", enable ? "on" : "off");
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 获取动态输入模型某个输入支持的所有形状
+ * @param index 输入序号
+ * @param shapes 支持的形状，布局为模型输入的布局
+ * @return nn_error_e 错误码，不是动态输入模型时返回NN_NOT_SUPPORTED
+ */
+nn_error_e RKEngine::GetDynamicInputShapes(uint32_t index, std::vector<tensor_attr_s> &shapes)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    if (index >= input_num_)
+    {
+        NN_LOG_ERROR("input index out of range! index=%d, input_num_=%d", index, input_num_);
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    // rknn_input_range比较大，不放在栈上
+    std::vector<rknn_input_range> range(1);
+    memset(range.data(), 0, sizeof(rknn_input_range));
+    range[0].index = index;
+    int ret = rknn_query(rknn_ctx_, RKNN_QUERY_INPUT_DYNAMIC_RANGE, range.data(), sizeof(rknn_input_range));
+    if (ret != RKNN_SUCC || range[0].shape_number == 0)
+    {
+        return NN_NOT_SUPPORTED;
+    }
+    shapes.clear();
+    for (uint32_t i = 0; i < range[0].shape_number; i++)
+    {
+        tensor_attr_s shape = in_shapes_[index];
+        shape.n_dims = range[0].n_dims;
+        shape.layout = rknn_layout_convert(range[0].fmt);
+        shape.n_elems = 1;
+        for (uint32_t j = 0; j < range[0].n_dims; j++)
+        {
+            shape.dims[j] = range[0].dyn_range[i][j];
+            shape.n_elems *= shape.dims[j];
+        }
+        shape.size = shape.n_elems * nn_tensor_type_to_size(shape.type);
+        shapes.push_back(shape);
+    }
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 设置动态输入模型的输入形状，必须是GetDynamicInputShapes返回的形状之一
+ *        零拷贝的内存按加载时的形状绑定，所以零拷贝模式下不支持
+ * @param shapes 每个输入的形状
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::SetInputShapes(const std::vector<tensor_attr_s> &shapes)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    if (zero_copy_io_ != nullptr)
+    {
+        NN_LOG_ERROR("rknn dynamic input shape is not supported with zero copy!");
+        return NN_NOT_SUPPORTED;
+    }
+    if (capture_ != nullptr)
+    {
+        NN_LOG_ERROR("rknn dynamic input shape is not supported while capturing!");
+        return NN_NOT_SUPPORTED;
+    }
+    if (shapes.size() != input_num_)
+    {
+        NN_LOG_ERROR("input shapes num not match! shapes.size()=%ld, input_num_=%d", shapes.size(), input_num_);
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    std::vector<rknn_tensor_attr> attrs = in_attrs_;
+    for (uint32_t i = 0; i < input_num_; i++)
+    {
+        attrs[i].n_dims = shapes[i].n_dims;
+        for (uint32_t j = 0; j < shapes[i].n_dims; j++)
+        {
+            attrs[i].dims[j] = shapes[i].dims[j];
+        }
+        attrs[i].fmt = rknn_layout_convert(shapes[i].layout);
+    }
+    int ret = rknn_set_input_shapes(rknn_ctx_, input_num_, attrs.data());
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_set_input_shapes fail! ret=%d", ret);
+        return NN_RKNN_INPUT_ATTR_ERROR;
+    }
+    return QueryCurrentShapes();
+}
+
+// 获取当前的输入输出属性（RKNN_QUERY_CURRENT_INPUT_ATTR/RKNN_QUERY_CURRENT_OUTPUT_ATTR）
+nn_error_e RKEngine::QueryCurrentShapes()
+{
+    for (uint32_t i = 0; i < input_num_; i++)
+    {
+        rknn_tensor_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.index = i;
+        int ret = rknn_query(rknn_ctx_, RKNN_QUERY_CURRENT_INPUT_ATTR, &attr, sizeof(rknn_tensor_attr));
+        if (ret != RKNN_SUCC)
+        {
+            NN_LOG_ERROR("rknn_query current input attr fail! ret=%d", ret);
+            return NN_RKNN_QUERY_FAIL;
+        }
+        in_attrs_[i] = attr;
+        in_shapes_[i] = rknn_tensor_attr_convert(attr);
+    }
+    for (uint32_t i = 0; i < output_num_; i++)
+    {
+        rknn_tensor_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.index = i;
+        int ret = rknn_query(rknn_ctx_, RKNN_QUERY_CURRENT_OUTPUT_ATTR, &attr, sizeof(rknn_tensor_attr));
+        if (ret != RKNN_SUCC)
+        {
+            NN_LOG_ERROR("rknn_query current output attr fail! ret=%d", ret);
+            return NN_RKNN_QUERY_FAIL;
+        }
+        out_attrs_[i] = attr;
+        out_shapes_[i] = rknn_tensor_attr_convert(attr);
+    }
+    NN_LOG_DEBUG("rknn input shape: [%d, %d, %d, %d]", in_attrs_[0].dims[0], in_attrs_[0].dims[1], in_attrs_[0].dims[2],
+                 in_attrs_[0].dims[3]);
+    return NN_SUCCESS;
+}
+
+// 检查输入数量并把输入交给rknn：零拷贝模式下写入绑定内存，否则调用rknn_inputs_set
+nn_error_e RKEngine::SetInputs(std::vector<tensor_data_s> &inputs)
 {
-    // 检查输入输出张量的数量是否匹配
     if (inputs.size() != input_num_)
     {
         NN_LOG_ERROR("inputs num not match! inputs.size()=%ld, input_num_=%d", inputs.size(), input_num_);
         return NN_IO_NUM_NOT_MATCH;
     }
-    if (outputs.size() != output_num_)
+    if (zero_copy_io_ != nullptr)
     {
-        NN_LOG_ERROR("outputs num not match! outputs.size()=%ld, output_num_=%d", outputs.size(), output_num_);
-        return NN_IO_NUM_NOT_MATCH;
+        return zero_copy_io_->BeforeRun(inputs);
     }
 
     // 设置rknn inputs
     rknn_input rknn_inputs[g_max_io_num];
-    for (int i = 0; i < inputs.size(); i++)
+    for (size_t i = 0; i < inputs.size(); i++)
     {
         // 将自定义的tensor_data_s转换为rknn_input
         rknn_inputs[i] = tensor_data_to_rknn_input(inputs[i]);
@@ -144,34 +519,74 @@ nn_error_e RKEngine::Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_
         NN_LOG_ERROR("rknn_inputs_set fail! ret=%d", ret);
         return NN_RKNN_INPUT_SET_FAIL;
     }
+    return NN_SUCCESS;
+}
 
-    // 推理
-    NN_LOG_DEBUG("rknn running...");
-    ret = rknn_run(rknn_ctx_, nullptr);
-    if (ret < 0)
+// 推理完成后取回输出：零拷贝模式下直接读取绑定内存，否则调用rknn_outputs_get
+nn_error_e RKEngine::GetOutputs(std::vector<tensor_data_s> &outputs, bool want_float)
+{
+    if (zero_copy_io_ != nullptr)
     {
-        NN_LOG_ERROR("rknn_run fail! ret=%d", ret);
-        return NN_RKNN_RUNTIME_ERROR;
+        return zero_copy_io_->AfterRun(outputs, want_float);
+    }
+    if (native_output_)
+    {
+        NN_LOG_ERROR("rknn native output layout needs zero copy!");
+        return NN_NOT_SUPPORTED;
     }
 
     // 获得输出
     rknn_output rknn_outputs[g_max_io_num];
     memset(rknn_outputs, 0, sizeof(rknn_outputs));
-    for (int i = 0; i < output_num_; ++i)
+    for (uint32_t i = 0; i < output_num_; ++i)
     {
         rknn_outputs[i].want_float = want_float ? 1 : 0;
+        if (prealloc_outputs_)
+        {
+            // 直接写入调用者的内存，省去rknn内部的malloc和后面的memcpy/free
+            // want_float时rknn写出的是float，需要的大小按元素数计算，不是量化输出的attr.size
+            uint32_t needed = want_float ? out_attrs_[i].n_elems * sizeof(float) : out_attrs_[i].size;
+            if (outputs[i].data == nullptr || outputs[i].attr.size < needed)
+            {
+                NN_LOG_ERROR("rknn prealloc output %d too small! %d < %d", i, outputs[i].attr.size, needed);
+                return NN_RKNN_OUTPUT_ATTR_ERROR;
+            }
+            rknn_outputs[i].is_prealloc = 1;
+            rknn_outputs[i].index = i;
+            rknn_outputs[i].buf = outputs[i].data;
+            rknn_outputs[i].size = needed;
+        }
     }
-    ret = rknn_outputs_get(rknn_ctx_, output_num_, rknn_outputs, NULL);
+    rknn_output_extend output_extend;
+    memset(&output_extend, 0, sizeof(output_extend));
+    int ret = rknn_outputs_get(rknn_ctx_, output_num_, rknn_outputs, &output_extend);
     if (ret < 0)
     {
         printf("rknn_outputs_get fail! ret=%d\n", ret);
         NN_LOG_ERROR("rknn_outputs_get fail! ret=%d", ret);
         return NN_RKNN_OUTPUT_GET_FAIL;
     }
+    if (async_mode_ && output_extend.frame_id != async_frame_id_)
+    {
+        NN_LOG_WARNING("rknn async output frame id not match! %lu != %lu",
+                       (unsigned long)output_extend.frame_id, (unsigned long)async_frame_id_);
+    }
+
+    if (prealloc_outputs_)
+    {
+        NN_LOG_DEBUG("output num: %d (prealloc)", output_num_);
+        // is_prealloc的输出不会被释放，这里只结束本次输出
+        rknn_outputs_release(rknn_ctx_, output_num_, rknn_outputs);
+        for (uint32_t i = 0; i < output_num_; ++i)
+        {
+            outputs[i].attr.type = want_float ? NN_TENSOR_FLOAT : out_shapes_[i].type;
+        }
+        return NN_SUCCESS;
+    }
 
     NN_LOG_DEBUG("output num: %d", output_num_);
     // copy rknn outputs to tensor_data_s
-    for (int i = 0; i < output_num_; ++i)
+    for (uint32_t i = 0; i < output_num_; ++i)
     {
         // 将rknn_output转换为自定义的tensor_data_s
         rknn_output_to_tensor_data(rknn_outputs[i], outputs[i]);
@@ -181,9 +596,309 @@ nn_error_e RKEngine::Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_
     return NN_SUCCESS;
 }
 
+/**
+ * @brief 运行模型，获得推理结果
+ * @param inputs 输入张量
+ * @param outputs 输出张量
+ * @param want_float 是否需要float类型的输出
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float)
+{
+    // 检查输出张量的数量是否匹配
+    if (outputs.size() != output_num_)
+    {
+        NN_LOG_ERROR("outputs num not match! outputs.size()=%ld, output_num_=%d", outputs.size(), output_num_);
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    if (async_pending_)
+    {
+        NN_LOG_ERROR("rknn async run pending, call Wait first!");
+        return NN_ASYNC_HANDLE_INVALID;
+    }
+
+    auto err = SetInputs(inputs);
+    if (err != NN_SUCCESS)
+    {
+        return err;
+    }
+
+    // 推理
+    NN_LOG_DEBUG("rknn running...");
+    uint64_t start_us = now_us();
+    rknn_run_extend run_extend;
+    memset(&run_extend, 0, sizeof(run_extend));
+    int ret = rknn_run(rknn_ctx_, &run_extend);
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_run fail! ret=%d", ret);
+        return NN_RKNN_RUNTIME_ERROR;
+    }
+    async_frame_id_ = run_extend.frame_id;
+    if (async_mode_)
+    {
+        // 异步模式下rknn_run不阻塞，等待本帧完成后再取输出
+        ret = rknn_wait(rknn_ctx_, &run_extend);
+        if (ret < 0)
+        {
+            NN_LOG_ERROR("rknn_wait fail! ret=%d", ret);
+            return NN_RKNN_RUNTIME_ERROR;
+        }
+    }
+    record_core_usage(core_mask_, now_us() - start_us);
+
+    err = GetOutputs(outputs, want_float);
+    if (err == NN_SUCCESS)
+    {
+        CollectPerf();
+        CaptureFrame(outputs, want_float);
+    }
+    return err;
+}
+
+// 在rknn_init时加上RKNN_FLAG_ASYNC_MASK，RunAsync/Wait使用rknn_run非阻塞+rknn_wait实现
+nn_error_e RKEngine::SetAsyncMode(bool enable)
+{
+    if (ctx_created_)
+    {
+        NN_LOG_ERROR("rknn async mode must be set before LoadModelFile!");
+        return NN_NOT_SUPPORTED;
+    }
+    async_mode_ = enable;
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 提交一次推理，不等待推理完成
+ * @param inputs 输入张量，rknn_inputs_set返回后即可被修改（零拷贝模式下需要等到Wait返回）
+ * @param want_float 是否需要float类型的输出
+ * @param handle 返回的异步句柄
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::RunAsync(std::vector<tensor_data_s> &inputs, bool want_float, int &handle)
+{
+    // 没有以异步模式初始化时使用通用实现
+    if (!async_mode_)
+    {
+        return NNEngine::RunAsync(inputs, want_float, handle);
+    }
+    if (async_pending_)
+    {
+        NN_LOG_ERROR("rknn async run pending, call Wait first!");
+        return NN_ASYNC_HANDLE_INVALID;
+    }
+    auto err = SetInputs(inputs);
+    if (err != NN_SUCCESS)
+    {
+        return err;
+    }
+    async_start_us_ = now_us();
+    rknn_run_extend run_extend;
+    memset(&run_extend, 0, sizeof(run_extend));
+    run_extend.non_block = 1;
+    int ret = rknn_run(rknn_ctx_, &run_extend);
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_run fail! ret=%d", ret);
+        return NN_RKNN_RUNTIME_ERROR;
+    }
+    async_pending_ = true;
+    async_want_float_ = want_float;
+    async_frame_id_ = run_extend.frame_id;
+    handle = (int)run_extend.frame_id;
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 等待异步推理完成并获取输出
+ * @param handle RunAsync返回的句柄
+ * @param outputs 输出张量
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::Wait(int handle, std::vector<tensor_data_s> &outputs)
+{
+    if (!async_mode_)
+    {
+        return NNEngine::Wait(handle, outputs);
+    }
+    if (!async_pending_ || handle != (int)async_frame_id_)
+    {
+        NN_LOG_ERROR("invalid rknn async handle: %d", handle);
+        return NN_ASYNC_HANDLE_INVALID;
+    }
+    if (outputs.size() != output_num_)
+    {
+        NN_LOG_ERROR("outputs num not match! outputs.size()=%ld, output_num_=%d", outputs.size(), output_num_);
+        return NN_IO_NUM_NOT_MATCH;
+    }
+    rknn_run_extend run_extend;
+    memset(&run_extend, 0, sizeof(run_extend));
+    run_extend.frame_id = async_frame_id_;
+    int ret = rknn_wait(rknn_ctx_, &run_extend);
+    async_pending_ = false;
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_wait fail! ret=%d", ret);
+        return NN_RKNN_RUNTIME_ERROR;
+    }
+    // 包含提交到Wait之间的时间，是核心占用时间的上界
+    record_core_usage(core_mask_, now_us() - async_start_us_);
+    auto err = GetOutputs(outputs, async_want_float_);
+    if (err == NN_SUCCESS)
+    {
+        CollectPerf();
+        CaptureFrame(outputs, async_want_float_);
+    }
+    return err;
+}
+
+/**
+ * @brief 绑定运行的NPU核心，RK3588有3个核心，多实例时分别绑定可以避免挤在同一个核心上
+ * @param core_mask 核心掩码
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::SetCoreMask(nn_core_mask_e core_mask)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    int ret = rknn_set_core_mask(rknn_ctx_, (rknn_core_mask)core_mask);
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_set_core_mask fail! mask=%d, ret=%d", core_mask, ret);
+        return NN_RKNN_RUNTIME_ERROR;
+    }
+    core_mask_ = core_mask;
+    NN_LOG_INFO("rknn core mask: %d", core_mask);
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 开启逐层性能统计：rknn_init时加上RKNN_FLAG_COLLECT_PERF_MASK，每帧取回输出后查询
+ *        RKNN_QUERY_PERF_DETAIL和RKNN_QUERY_PERF_RUN，引擎销毁时写出统计结果
+ * @param report_path 统计结果的路径前缀，写出<report_path>.csv和<report_path>.json
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::EnableProfiling(const char *report_path)
+{
+    // 已经初始化的context只有带着性能统计标志时才能开启（如从开启了性能统计的引擎复制而来）
+    if (ctx_created_ && !perf_flag_)
+    {
+        NN_LOG_ERROR("rknn profiling must be enabled before LoadModelFile!");
+        return NN_NOT_SUPPORTED;
+    }
+    profiler_ = std::make_shared<PerfProfiler>();
+    profile_report_ = report_path;
+    NN_LOG_INFO("rknn profiling on, report: %s", report_path);
+    return NN_SUCCESS;
+}
+
+// 获取逐层性能统计
+std::shared_ptr<PerfProfiler> RKEngine::GetProfiler()
+{
+    return profiler_;
+}
+
+// 取回一帧的逐层耗时，需要在rknn_outputs_get之后调用
+void RKEngine::CollectPerf()
+{
+    if (profiler_ == nullptr)
+    {
+        return;
+    }
+    rknn_perf_run perf_run;
+    memset(&perf_run, 0, sizeof(perf_run));
+    int ret = rknn_query(rknn_ctx_, RKNN_QUERY_PERF_RUN, &perf_run, sizeof(perf_run));
+    int64_t run_us = ret == RKNN_SUCC ? perf_run.run_duration : -1;
+    rknn_perf_detail perf_detail;
+    memset(&perf_detail, 0, sizeof(perf_detail));
+    ret = rknn_query(rknn_ctx_, RKNN_QUERY_PERF_DETAIL, &perf_detail, sizeof(perf_detail));
+    if (ret != RKNN_SUCC || perf_detail.perf_data == nullptr)
+    {
+        NN_LOG_WARNING("rknn_query perf detail fail! ret=%d", ret);
+        return;
+    }
+    profiler_->AddFrame(std::string(perf_detail.perf_data, perf_detail.data_len), run_us);
+}
+
+/**
+ * @brief 批量模型（输入的N>1）一次推理N张图像，rknn_set_batch_core_num把这N张图像分到多个NPU核心上并行，
+ *        不需要额外的context
+ * @param core_num 使用的核心数
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::SetBatchCoreNum(int core_num)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    int ret = rknn_set_batch_core_num(rknn_ctx_, core_num);
+    if (ret < 0)
+    {
+        NN_LOG_ERROR("rknn_set_batch_core_num fail! core_num=%d, ret=%d", core_num, ret);
+        return NN_RKNN_RUNTIME_ERROR;
+    }
+    NN_LOG_INFO("rknn batch core num: %d", core_num);
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 录制之后每次推理的输出，录制文件可以用回放引擎在没有NPU的机器上运行
+ *        录制的是量化输出，want_float的推理不会被录制；原生NHWC输出和动态输入形状不支持录制
+ * @param capture_path 录制文件路径
+ * @return nn_error_e 错误码
+ */
+nn_error_e RKEngine::EnableCapture(const char *capture_path)
+{
+    if (!ctx_created_)
+    {
+        NN_LOG_ERROR("rknn model not loaded!");
+        return NN_RKNN_MODEL_NOT_LOAD;
+    }
+    if (native_output_)
+    {
+        NN_LOG_ERROR("rknn capture does not support native output layout!");
+        return NN_NOT_SUPPORTED;
+    }
+    auto capture = std::make_shared<CaptureWriter>();
+    auto ret = capture->Open(capture_path, in_shapes_, out_shapes_);
+    if (ret != NN_SUCCESS)
+    {
+        return ret;
+    }
+    capture_ = capture;
+    return NN_SUCCESS;
+}
+
+// 录制一帧的输出
+void RKEngine::CaptureFrame(std::vector<tensor_data_s> &outputs, bool want_float)
+{
+    if (capture_ == nullptr || want_float)
+    {
+        return;
+    }
+    if (capture_->WriteFrame(outputs) != NN_SUCCESS)
+    {
+        NN_LOG_WARNING("rknn capture frame fail, capture stopped");
+        capture_.reset();
+    }
+}
+
 // 析构函数
 RKEngine::~RKEngine()
 {
+    // 通用异步推理的辅助线程会调用Run，需要先停止
+    async_runner_.reset();
+    // 零拷贝内存需要在context销毁前释放
+    zero_copy_io_.reset();
+    if (profiler_ != nullptr && profiler_->FrameCount() > 0)
+    {
+        profiler_->Dump(profile_report_);
+    }
     if (ctx_created_)
     {
         rknn_destroy(rknn_ctx_);
@@ -196,3 +911,17 @@ std::shared_ptr<NNEngine> CreateRKNNEngine()
 {
     return std::make_shared<RKEngine>();
 }
+
+// 获取NPU核心使用统计
+nn_npu_usage_s GetNPUUsage()
+{
+    nn_npu_usage_s usage;
+    for (int i = 0; i < g_npu_core_num; i++)
+    {
+        usage.run_count[i] = g_core_run_count[i];
+        usage.busy_us[i] = g_core_busy_us[i];
+    }
+    usage.auto_run_count = g_auto_run_count;
+    usage.auto_busy_us = g_auto_busy_us;
+    return usage;
+}
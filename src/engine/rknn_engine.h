@@ -4,7 +4,9 @@
 #define RK3588_DEMO_RKNN_ENGINE_H
 
 #include "engine.h"
+#include "capture_file.h"
 
+#include <string>
 #include <vector>
 
 #include <rknn_api.h>
@@ -13,13 +15,31 @@
 class RKEngine : public NNEngine
 {
 public:
-    RKEngine() : rknn_ctx_(0), ctx_created_(false), input_num_(0), output_num_(0){}; // 构造函数，初始化
-    ~RKEngine() override;                                                            // 析构函数
+    RKEngine() : rknn_ctx_(0), ctx_created_(false), input_num_(0), output_num_(0), prealloc_outputs_(false),
+                 async_mode_(false), async_pending_(false), async_want_float_(false), async_frame_id_(0),
+                 core_mask_(NN_NPU_CORE_AUTO), async_start_us_(0), weight_size_(0), perf_flag_(false), native_output_(false){}; // 构造函数，初始化
+    ~RKEngine() override;                                                                               // 析构函数
 
     nn_error_e LoadModelFile(const char *model_file) override;                                                         // 加载模型文件
     const std::vector<tensor_attr_s> &GetInputShapes() override;                                                       // 获取输入张量的形状
     const std::vector<tensor_attr_s> &GetOutputShapes() override;                                                      // 获取输出张量的形状
     nn_error_e Run(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs, bool want_float) override; // 运行模型
+    nn_error_e EnableZeroCopy(std::shared_ptr<MemoryProvider> provider) override;                                      // 开启零拷贝
+    std::shared_ptr<ZeroCopyIO> GetZeroCopyIO() override;                                                              // 获取零拷贝输入输出
+    nn_error_e SetOutputPrealloc(bool enable) override;                                                                // 输出使用调用者预分配的内存
+    nn_error_e SetNativeOutputLayout(bool enable) override;                                                            // 输出使用RKNN_QUERY_NATIVE_NHWC_OUTPUT_ATTR
+    nn_error_e GetDynamicInputShapes(uint32_t index, std::vector<tensor_attr_s> &shapes) override;                     // RKNN_QUERY_INPUT_DYNAMIC_RANGE
+    nn_error_e SetInputShapes(const std::vector<tensor_attr_s> &shapes) override;                                      // rknn_set_input_shapes
+    nn_error_e SetAsyncMode(bool enable) override;                                                                     // 使用RKNN_FLAG_ASYNC_MASK初始化
+    nn_error_e RunAsync(std::vector<tensor_data_s> &inputs, bool want_float, int &handle) override;                    // 提交推理，不等待
+    nn_error_e Wait(int handle, std::vector<tensor_data_s> &outputs) override;                                         // 等待推理完成并获取输出
+    nn_error_e SetCoreMask(nn_core_mask_e core_mask) override;                                                         // 绑定NPU核心
+    nn_error_e SetBatchCoreNum(int core_num) override;                                                                 // rknn_set_batch_core_num
+    nn_error_e Clone(std::shared_ptr<NNEngine> &engine) override;                                                      // 用rknn_dup_context复制context，共享权重
+    uint64_t GetWeightSize() override;                                                                                 // 模型权重大小
+    nn_error_e EnableProfiling(const char *report_path) override;                                                      // 使用RKNN_FLAG_COLLECT_PERF_MASK初始化，统计逐层耗时
+    std::shared_ptr<PerfProfiler> GetProfiler() override;                                                              // 获取逐层性能统计
+    nn_error_e EnableCapture(const char *capture_path) override;                                                       // 录制每帧的输出
 
 private:
     // rknn context
@@ -29,8 +49,40 @@ private:
     uint32_t input_num_;  // 输入的数量
     uint32_t output_num_; // 输出的数量
 
+    bool prealloc_outputs_; // rknn_outputs_get是否直接写入调用者的内存（is_prealloc）
+
     std::vector<tensor_attr_s> in_shapes_;  // 输入张量的形状
     std::vector<tensor_attr_s> out_shapes_; // 输出张量的形状
+
+    std::vector<rknn_tensor_attr> in_attrs_;  // rknn原始输入属性，绑定零拷贝内存时使用
+    std::vector<rknn_tensor_attr> out_attrs_; // rknn原始输出属性，绑定零拷贝内存时使用
+
+    std::shared_ptr<ZeroCopyIO> zero_copy_io_; // 零拷贝输入输出，为空表示使用rknn_inputs_set/rknn_outputs_get
+
+    nn_error_e SetInputs(std::vector<tensor_data_s> &inputs);                     // 检查并设置输入
+    nn_error_e GetOutputs(std::vector<tensor_data_s> &outputs, bool want_float); // 获取输出
+
+    bool async_mode_;        // 是否以RKNN_FLAG_ASYNC_MASK初始化
+    bool async_pending_;     // 是否有在途的异步推理（一个context同时只能有一帧在途）
+    bool async_want_float_;  // 在途推理是否需要float输出
+    uint64_t async_frame_id_; // 在途推理的frame id
+
+    nn_core_mask_e core_mask_; // 绑定的NPU核心
+    uint64_t async_start_us_;  // 在途推理的提交时间，用于统计核心使用
+
+    uint64_t weight_size_; // 模型权重大小（RKNN_QUERY_MEM_SIZE）
+
+    bool perf_flag_;                         // 是否以RKNN_FLAG_COLLECT_PERF_MASK初始化
+    std::shared_ptr<PerfProfiler> profiler_; // 逐层性能统计，为空表示不统计
+    std::string profile_report_;             // 性能统计的输出路径前缀
+    void CollectPerf();                      // 取回一帧的逐层耗时
+
+    bool native_output_; // 输出是否为NPU原生的NHWC布局
+
+    nn_error_e QueryCurrentShapes(); // 切换输入形状后重新获取当前的输入输出属性
+
+    std::shared_ptr<CaptureWriter> capture_;                               // 输出录制，为空表示不录制
+    void CaptureFrame(std::vector<tensor_data_s> &outputs, bool want_float); // 录制一帧的输出
 };
 
 #endif // RK3588_DEMO_RKNN_ENGINE_H
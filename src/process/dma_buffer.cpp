@@ -0,0 +1,102 @@
+// dma_buffer.h的实现
+
+#include "dma_buffer.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
+
+#include "utils/logging.h"
+
+// 按顺序尝试的heap：RGA2只能访问4G以内的地址，优先使用dma32
+static const char *g_dma_heaps[] = {
+    "/dev/dma_heap/system-dma32",
+    "/dev/dma_heap/system",
+};
+
+DmaBuffer::~DmaBuffer()
+{
+    Free();
+}
+
+/**
+ * @brief 从DMA heap分配内存并映射
+ * @param size 内存大小（字节）
+ * @return nn_error_e 错误码
+ */
+nn_error_e DmaBuffer::Alloc(size_t size)
+{
+    Free();
+    for (const char *heap_path : g_dma_heaps)
+    {
+        int heap_fd = open(heap_path, O_RDWR | O_CLOEXEC);
+        if (heap_fd < 0)
+        {
+            continue;
+        }
+        struct dma_heap_allocation_data alloc_data;
+        memset(&alloc_data, 0, sizeof(alloc_data));
+        alloc_data.len = size;
+        alloc_data.fd_flags = O_RDWR | O_CLOEXEC;
+        int ret = ioctl(heap_fd, DMA_HEAP_IOCTL_ALLOC, &alloc_data);
+        close(heap_fd);
+        if (ret < 0)
+        {
+            NN_LOG_WARNING("dma heap %s alloc %ld bytes fail", heap_path, size);
+            continue;
+        }
+        void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, alloc_data.fd, 0);
+        if (data == MAP_FAILED)
+        {
+            NN_LOG_ERROR("mmap dma buffer fail");
+            close(alloc_data.fd);
+            return NN_MEM_ALLOC_FAIL;
+        }
+        fd_ = alloc_data.fd;
+        data_ = data;
+        size_ = size;
+        return NN_SUCCESS;
+    }
+    NN_LOG_ERROR("no dma heap available for %ld bytes", size);
+    return NN_MEM_ALLOC_FAIL;
+}
+
+void DmaBuffer::Free()
+{
+    if (data_ != nullptr)
+    {
+        munmap(data_, size_);
+        data_ = nullptr;
+    }
+    if (fd_ >= 0)
+    {
+        close(fd_);
+        fd_ = -1;
+    }
+    size_ = 0;
+}
+
+// CPU开始访问：使设备写入的内容对CPU可见
+void DmaBuffer::SyncBegin(bool write)
+{
+    dma_buf_sync(fd_, true, write);
+}
+
+// CPU结束访问：把CPU写入的内容刷到内存，供设备读取
+void DmaBuffer::SyncEnd(bool write)
+{
+    dma_buf_sync(fd_, false, write);
+}
+
+void dma_buf_sync(int fd, bool begin, bool write)
+{
+    struct dma_buf_sync sync;
+    sync.flags = (begin ? DMA_BUF_SYNC_START : DMA_BUF_SYNC_END) | (write ? DMA_BUF_SYNC_WRITE : DMA_BUF_SYNC_READ);
+    ioctl(fd, DMA_BUF_IOCTL_SYNC, &sync);
+}
@@ -0,0 +1,38 @@
+// DMA-heap内存：RGA可以直接通过fd访问，不需要逐帧建立页表
+
+#ifndef RK3588_DEMO_DMA_BUFFER_H
+#define RK3588_DEMO_DMA_BUFFER_H
+
+#include <stddef.h>
+
+#include "types/error.h"
+
+// 一块从/dev/dma_heap分配的内存，映射到进程中供CPU读写
+// CPU访问前后需要调用SyncBegin/SyncEnd保证和设备之间的缓存一致
+class DmaBuffer
+{
+public:
+    DmaBuffer() : fd_(-1), data_(nullptr), size_(0){};
+    ~DmaBuffer();
+    DmaBuffer(const DmaBuffer &) = delete;
+    DmaBuffer &operator=(const DmaBuffer &) = delete;
+
+    nn_error_e Alloc(size_t size); // 分配内存，已分配时先释放
+    void Free();                   // 释放内存
+    void SyncBegin(bool write);    // CPU开始访问
+    void SyncEnd(bool write);      // CPU结束访问
+
+    int Fd() const { return fd_; }         // dma-buf fd
+    void *Data() const { return data_; }   // CPU地址
+    size_t Size() const { return size_; }  // 内存大小（字节）
+
+private:
+    int fd_;
+    void *data_;
+    size_t size_;
+};
+
+// 对任意dma-buf（例如NPU的张量内存）做CPU访问前后的缓存同步，begin为true时开始访问
+void dma_buf_sync(int fd, bool begin, bool write);
+
+#endif // RK3588_DEMO_DMA_BUFFER_H
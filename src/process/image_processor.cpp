@@ -0,0 +1,48 @@
+// image_processor.h的实现：CPU实现和工厂函数
+
+#include "image_processor.h"
+
+#include "utils/logging.h"
+
+// CPU实现：融合的letterbox，一次遍历完成缩放、BGR转RGB和补边
+class SoftwareImageProcessor : public ImageProcessor
+{
+public:
+    const char *Name() override { return "software"; }
+    nn_error_e Letterbox(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                         LetterBoxInfo &info) override
+    {
+        info = letterbox_fused(img, width, height, tensor, LETTERBOX_RESIZE_PAD, &scratch_);
+        return NN_SUCCESS;
+    }
+    nn_error_e LetterboxYuv(const yuv_frame_s &frame, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                            LetterBoxInfo &info) override
+    {
+        info = letterbox_fused_yuv(frame, width, height, tensor, &scratch_);
+        return NN_SUCCESS;
+    }
+
+private:
+    ScratchArena scratch_; // 插值表和行缓存，尺寸不变时复用
+};
+
+// 创建CPU实现
+std::shared_ptr<ImageProcessor> CreateSoftwareImageProcessor()
+{
+    return std::make_shared<SoftwareImageProcessor>();
+}
+
+// 优先使用RGA，不可用时退回CPU实现
+std::shared_ptr<ImageProcessor> CreateImageProcessor(bool prefer_rga, bool rga_import_src)
+{
+    std::shared_ptr<ImageProcessor> processor = prefer_rga ? CreateRGAImageProcessor(rga_import_src) : nullptr;
+    if (processor == nullptr)
+    {
+        if (prefer_rga)
+        {
+            NN_LOG_WARNING("rga preprocessing not available, use software");
+        }
+        processor = CreateSoftwareImageProcessor();
+    }
+    return processor;
+}
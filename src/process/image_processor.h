@@ -0,0 +1,36 @@
+// 预处理接口：把BGR原图letterbox到模型输入（缩放、BGR转RGB、补边），可以由RGA或CPU实现
+
+#ifndef RK3588_DEMO_IMAGE_PROCESSOR_H
+#define RK3588_DEMO_IMAGE_PROCESSOR_H
+
+#include "preprocess.h"
+#include "types/error.h"
+
+#include <memory>
+
+// 使用先缩放再补边（LETTERBOX_RESIZE_PAD）的方式，各个实现的几何和边界完全相同；
+// 内容区域的像素值不要求逐位相同：RGA的插值精度和CPU实现不同，平滑图像上每个通道的平均误差不超过1.5、
+// 单个像素不超过8个灰度级（tests/test_image_processor.cpp）
+class ImageProcessor
+{
+public:
+    virtual ~ImageProcessor(){};
+    virtual const char *Name() = 0; // 实现名称，用于日志
+    // 把img letterbox到width x height的tensor中，info返回缩放比例和偏移
+    virtual nn_error_e Letterbox(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                                 LetterBoxInfo &info) = 0;
+    // 把YUV420帧letterbox到width x height的tensor中，颜色转换和缩放一起完成
+    virtual nn_error_e LetterboxYuv(const yuv_frame_s &frame, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                                    LetterBoxInfo &info) = 0;
+    // 张量内存是dma-buf（零拷贝的NPU输入）时登记fd和CPU地址范围，之后tensor.data落在该范围内时由设备直接写入；
+    // fd为-1时取消登记。CPU实现直接写tensor.data，不需要登记
+    virtual void SetTensorDma(int /*fd*/, void * /*base*/, size_t /*size*/) {}
+};
+
+std::shared_ptr<ImageProcessor> CreateSoftwareImageProcessor(); // CPU实现（融合的SIMD letterbox）
+// RGA实现，不可用时返回空；import_src为true时连续的原图每帧导入虚拟地址由RGA直接读取，
+// 否则拷贝到复用的DMA-heap内存（默认，不需要每帧映射页表，见bench_preprocess.cpp的对比）
+std::shared_ptr<ImageProcessor> CreateRGAImageProcessor(bool import_src = false);
+std::shared_ptr<ImageProcessor> CreateImageProcessor(bool prefer_rga, bool rga_import_src = false); // 优先使用RGA，不可用时退回CPU实现
+
+#endif // RK3588_DEMO_IMAGE_PROCESSOR_H
@@ -0,0 +1,411 @@
+// 融合的letterbox预处理：padding、缩放、BGR转RGB在一次遍历中完成，结果直接写入输入张量
+// 不生成原图大小的padding图像，也没有中间的RGB、缩放图像和拷贝
+
+#include "preprocess.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NN_PREPROCESS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NN_PREPROCESS_SSE2 1
+#endif
+
+#include "utils/logging.h"
+
+// 插值权重的定点位数，和cv::resize的INTER_LINEAR一致
+static const int g_coef_bits = 11;
+static const int g_coef_scale = 1 << g_coef_bits;
+
+// 是否使用NEON/SSE2实现，关闭后只用标量实现（测试两者结果一致、对比性能）
+static bool g_simd_enabled = true;
+
+void letterbox_fused_enable_simd(bool enable)
+{
+    g_simd_enabled = enable;
+}
+
+// 一个输出坐标在源图像上的两个采样点和权重，落在padding区域的采样点权重为0（padding的值为0）
+struct AxisTap
+{
+    int src0;
+    int src1;
+    short w0;
+    short w1;
+};
+
+/**
+ * @brief 计算一个轴上的插值表，坐标按像素中心对齐，边界处理和cv::resize的INTER_LINEAR一致
+ * @param dst_len 输出长度
+ * @param padded_len padding后的长度
+ * @param pad_before 起始一侧的padding
+ * @param real_len 原图长度
+ * @param taps 插值表，dst_len个
+ */
+static void build_axis_taps(int dst_len, int padded_len, int pad_before, int real_len, AxisTap *taps)
+{
+    double scale = (double)padded_len / dst_len;
+    for (int d = 0; d < dst_len; d++)
+    {
+        float f = (float)((d + 0.5) * scale - 0.5);
+        int s = (int)floorf(f);
+        f -= s;
+        if (s < 0)
+        {
+            s = 0;
+            f = 0;
+        }
+        if (s >= padded_len - 1)
+        {
+            s = padded_len - 1;
+            f = 0;
+        }
+        int w1 = (int)lrintf(f * g_coef_scale);
+        int w0 = g_coef_scale - w1;
+        int r0 = s - pad_before;
+        int r1 = s + 1 - pad_before;
+        AxisTap &tap = taps[d];
+        tap.src0 = std::min(std::max(r0, 0), real_len - 1);
+        tap.src1 = std::min(std::max(r1, 0), real_len - 1);
+        tap.w0 = (r0 >= 0 && r0 < real_len) ? w0 : 0;
+        tap.w1 = (w1 > 0 && r1 >= 0 && r1 < real_len) ? w1 : 0;
+    }
+}
+
+// 水平插值一行，同时交换通道（BGR->RGB），结果右移4位存为int16，供垂直插值使用
+static void hresize_row(const uint8_t *src, const AxisTap *taps, int dst_w, short *row)
+{
+    for (int x = 0; x < dst_w; x++)
+    {
+        const AxisTap &tap = taps[x];
+        const uint8_t *p0 = src + tap.src0 * 3;
+        const uint8_t *p1 = src + tap.src1 * 3;
+        row[0] = (short)((p0[2] * tap.w0 + p1[2] * tap.w1) >> 4);
+        row[1] = (short)((p0[1] * tap.w0 + p1[1] * tap.w1) >> 4);
+        row[2] = (short)((p0[0] * tap.w0 + p1[0] * tap.w1) >> 4);
+        row += 3;
+    }
+}
+
+// 垂直插值：dst = ((r0 * b0) >> 16 + (r1 * b1) >> 16 + 2) >> 2，各个指令集的实现结果完全一致
+static void vresize_row(const short *row0, const short *row1, short b0, short b1, uint8_t *dst, int n)
+{
+    int i = 0;
+#if defined(NN_PREPROCESS_NEON)
+    const int simd_n = g_simd_enabled ? n : 0;
+    int16x4_t vb0 = vdup_n_s16(b0);
+    int16x4_t vb1 = vdup_n_s16(b1);
+    for (; i + 8 <= simd_n; i += 8)
+    {
+        int16x8_t r0 = vld1q_s16(row0 + i);
+        int16x8_t r1 = vld1q_s16(row1 + i);
+        int16x8_t v0 = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(r0), vb0), 16),
+                                    vshrn_n_s32(vmull_s16(vget_high_s16(r0), vb0), 16));
+        int16x8_t v1 = vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(r1), vb1), 16),
+                                    vshrn_n_s32(vmull_s16(vget_high_s16(r1), vb1), 16));
+        vst1_u8(dst + i, vqmovun_s16(vrshrq_n_s16(vaddq_s16(v0, v1), 2)));
+    }
+#elif defined(NN_PREPROCESS_SSE2)
+    const int simd_n = g_simd_enabled ? n : 0;
+    __m128i vb0 = _mm_set1_epi16(b0);
+    __m128i vb1 = _mm_set1_epi16(b1);
+    __m128i delta = _mm_set1_epi16(2);
+    for (; i + 8 <= simd_n; i += 8)
+    {
+        __m128i r0 = _mm_loadu_si128((const __m128i *)(row0 + i));
+        __m128i r1 = _mm_loadu_si128((const __m128i *)(row1 + i));
+        __m128i v = _mm_add_epi16(_mm_mulhi_epi16(r0, vb0), _mm_mulhi_epi16(r1, vb1));
+        v = _mm_srai_epi16(_mm_add_epi16(v, delta), 2);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(v, v));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        int v = (((row0[i] * b0) >> 16) + ((row1[i] * b1) >> 16) + 2) >> 2;
+        dst[i] = (uint8_t)std::min(std::max(v, 0), 255);
+    }
+}
+
+/**
+ * @brief 融合的letterbox：读取一次BGR原图，直接在张量中写出缩放并转为RGB、带padding的图像
+ *        LETTERBOX_PAD_RESIZE和letterbox + cvimg2tensor一致（每个像素误差不超过1）；
+ *        LETTERBOX_RESIZE_PAD只缩放原图内容到子区域，边界填0
+ * @param img 原图，BGR
+ * @param width 张量宽度
+ * @param height 张量高度
+ * @param tensor 输入张量，uint8 NHWC
+ * @param mode letterbox方式
+ * @param scratch 插值表和行缓存从中获取，为空时每次分配
+ * @return LetterBoxInfo 缩放比例和偏移
+ */
+LetterBoxInfo letterbox_fused(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                              letterbox_mode_e mode, ScratchArena *scratch)
+{
+    // img has to be 3 channels
+    if (img.channels() != 3 || img.depth() != CV_8U)
+    {
+        NN_LOG_ERROR("img has to be 3 channels");
+        exit(-1);
+    }
+    LetterBoxInfo info = letterbox_info(img.cols, img.rows, width, height, mode);
+
+    // 输出区域：先补边方式写满整个张量，先缩放方式只写内容区域
+    cv::Rect content(0, 0, width, height);
+    int pad_hor = 0;
+    int pad_ver = 0;
+    if (mode == LETTERBOX_PAD_RESIZE)
+    {
+        letterbox_padding(img.cols, img.rows, (float)width / height, pad_hor, pad_ver);
+    }
+    else
+    {
+        content = letterbox_content_rect(info, img.cols, img.rows);
+        letterbox_fill_border(tensor, width, height, content);
+    }
+
+    // 插值表和两行的行缓存；插值表只由几何参数决定，同一分辨率的视频流只在第一帧计算
+    const int row_len = content.width * 3;
+    size_t taps_size = sizeof(AxisTap) * (content.width + content.height);
+    size_t rows_size = sizeof(short) * row_len * 2;
+    std::vector<uint8_t> local_buf;
+    uint8_t *taps_buf = nullptr;
+    uint8_t *rows_buf = nullptr;
+    bool taps_valid = false;
+    if (scratch != nullptr)
+    {
+        ScratchKey key = {{img.cols, img.rows, (int)width, (int)height, (int)mode, 0}};
+        taps_buf = (uint8_t *)scratch->GetTable(key, taps_size, taps_valid);
+        rows_buf = (uint8_t *)scratch->GetBuffer(SCRATCH_ROWS, rows_size);
+    }
+    else
+    {
+        local_buf.resize(taps_size + rows_size);
+        taps_buf = local_buf.data();
+        rows_buf = local_buf.data() + taps_size;
+    }
+
+    // 先补边方式在虚拟的补边图像上插值，先缩放方式只在原图上插值
+    AxisTap *x_taps = (AxisTap *)taps_buf;
+    AxisTap *y_taps = x_taps + content.width;
+    if (!taps_valid)
+    {
+        build_axis_taps(content.width, img.cols + pad_hor * 2, pad_hor, img.cols, x_taps);
+        build_axis_taps(content.height, img.rows + pad_ver * 2, pad_ver, img.rows, y_taps);
+    }
+
+    // 最近水平插值过的两行源图像，放大时相邻输出行会复用
+    short *rows[2] = {(short *)rows_buf, (short *)rows_buf + row_len};
+    int row_y[2] = {-1, -1};
+    auto fetch_row = [&](int y, int keep) -> const short *
+    {
+        for (int k = 0; k < 2; k++)
+        {
+            if (row_y[k] == y)
+            {
+                return rows[k];
+            }
+        }
+        int k = row_y[0] == keep ? 1 : 0;
+        hresize_row(img.ptr<uint8_t>(y), x_taps, content.width, rows[k]);
+        row_y[k] = y;
+        return rows[k];
+    };
+
+    uint8_t *dst = (uint8_t *)tensor.data + ((size_t)content.y * width + content.x) * 3;
+    const size_t dst_stride = (size_t)width * 3;
+    for (int y = 0; y < content.height; y++)
+    {
+        const AxisTap &tap = y_taps[y];
+        uint8_t *dst_row = dst + y * dst_stride;
+        if (tap.w0 == 0 && tap.w1 == 0)
+        {
+            // 整行都在padding区域
+            memset(dst_row, 0, row_len);
+            continue;
+        }
+        const short *r0 = tap.w0 != 0 ? fetch_row(tap.src0, -1) : nullptr;
+        const short *r1 = tap.w1 != 0 ? fetch_row(tap.src1, tap.w0 != 0 ? tap.src0 : -1) : nullptr;
+        // 权重为0的一行不需要计算，用另一行代替
+        vresize_row(r0 != nullptr ? r0 : r1, r1 != nullptr ? r1 : r0, tap.w0, tap.w1, dst_row, row_len);
+    }
+    return info;
+}
+
+// 水平插值一行单通道数据，step为相邻像素的间隔（NV12交错的UV平面为2）
+static void hresize_plane_row(const uint8_t *src, int step, const AxisTap *taps, int dst_w, short *row)
+{
+    for (int x = 0; x < dst_w; x++)
+    {
+        const AxisTap &tap = taps[x];
+        row[x] = (short)((src[tap.src0 * step] * tap.w0 + src[tap.src1 * step] * tap.w1) >> 4);
+    }
+}
+
+// 对一个平面插值出一行输出，rows为两行的行缓存
+static void resize_plane_line(const uint8_t *plane, int stride, int step, const AxisTap *x_taps, const AxisTap &y_tap,
+                              int dst_w, short *rows, uint8_t *line)
+{
+    short *r0 = rows;
+    short *r1 = rows + dst_w;
+    if (y_tap.w0 != 0)
+    {
+        hresize_plane_row(plane + (size_t)y_tap.src0 * stride, step, x_taps, dst_w, r0);
+    }
+    if (y_tap.w1 != 0)
+    {
+        hresize_plane_row(plane + (size_t)y_tap.src1 * stride, step, x_taps, dst_w, r1);
+    }
+    vresize_row(y_tap.w0 != 0 ? r0 : r1, y_tap.w1 != 0 ? r1 : r0, y_tap.w0, y_tap.w1, line, dst_w);
+}
+
+// YUV转RGB的定点系数（BT.601 limited range），和cv::COLOR_YUV2RGB_NV12一致
+static const int g_yuv_shift = 20;
+static const int g_yuv_cy = 1220542;
+static const int g_yuv_cub = 2116026;
+static const int g_yuv_cug = -409993;
+static const int g_yuv_cvg = -852492;
+static const int g_yuv_cvr = 1673527;
+
+#if defined(NN_PREPROCESS_NEON)
+// 8个像素的一个颜色通道：(y * cy + a * ca + b * cb + round) >> shift，饱和到uint8
+static inline uint8x8_t yuv_channel_neon(int16x8_t y, int16x8_t a, int32_t ca, int16x8_t b, int32_t cb)
+{
+    int32x4_t round = vdupq_n_s32(1 << (g_yuv_shift - 1));
+    int32x4_t lo = vmlaq_n_s32(round, vmovl_s16(vget_low_s16(y)), g_yuv_cy);
+    int32x4_t hi = vmlaq_n_s32(round, vmovl_s16(vget_high_s16(y)), g_yuv_cy);
+    lo = vmlaq_n_s32(vmlaq_n_s32(lo, vmovl_s16(vget_low_s16(a)), ca), vmovl_s16(vget_low_s16(b)), cb);
+    hi = vmlaq_n_s32(vmlaq_n_s32(hi, vmovl_s16(vget_high_s16(a)), ca), vmovl_s16(vget_high_s16(b)), cb);
+    int16x8_t v = vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, g_yuv_shift)), vqmovn_s32(vshrq_n_s32(hi, g_yuv_shift)));
+    return vqmovun_s16(v);
+}
+#endif
+
+// 一行YUV转为交错的RGB
+static void yuv_to_rgb_row(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *rgb, int n)
+{
+    int i = 0;
+#if defined(NN_PREPROCESS_NEON)
+    const int simd_n = g_simd_enabled ? n : 0;
+    int16x8_t y_off = vdupq_n_s16(16);
+    int16x8_t uv_off = vdupq_n_s16(128);
+    int16x8_t zero = vdupq_n_s16(0);
+    for (; i + 8 <= simd_n; i += 8)
+    {
+        int16x8_t yy = vmaxq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(y + i))), y_off), zero);
+        int16x8_t uu = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u + i))), uv_off);
+        int16x8_t vv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v + i))), uv_off);
+        uint8x8x3_t out;
+        out.val[0] = yuv_channel_neon(yy, vv, g_yuv_cvr, uu, 0);
+        out.val[1] = yuv_channel_neon(yy, uu, g_yuv_cug, vv, g_yuv_cvg);
+        out.val[2] = yuv_channel_neon(yy, uu, g_yuv_cub, vv, 0);
+        vst3_u8(rgb + i * 3, out);
+    }
+#endif
+    const int round = 1 << (g_yuv_shift - 1);
+    for (; i < n; i++)
+    {
+        int yy = std::max(0, y[i] - 16) * g_yuv_cy + round;
+        int uu = u[i] - 128;
+        int vv = v[i] - 128;
+        int r = (yy + g_yuv_cvr * vv) >> g_yuv_shift;
+        int g = (yy + g_yuv_cug * uu + g_yuv_cvg * vv) >> g_yuv_shift;
+        int b = (yy + g_yuv_cub * uu) >> g_yuv_shift;
+        rgb[i * 3 + 0] = (uint8_t)std::min(std::max(r, 0), 255);
+        rgb[i * 3 + 1] = (uint8_t)std::min(std::max(g, 0), 255);
+        rgb[i * 3 + 2] = (uint8_t)std::min(std::max(b, 0), 255);
+    }
+}
+
+/**
+ * @brief 融合的YUV letterbox：Y、U、V平面分别插值到内容区域后直接转为RGB写入张量，不生成BGR图像
+ *        使用先缩放再补边的方式，边界填0
+ * @param frame YUV420帧（NV12或I420）
+ * @param width 张量宽度
+ * @param height 张量高度
+ * @param tensor 输入张量，uint8 NHWC
+ * @param scratch 插值表和行缓存从中获取，为空时每次分配
+ * @return LetterBoxInfo 缩放比例和偏移
+ */
+LetterBoxInfo letterbox_fused_yuv(const yuv_frame_s &frame, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                                  ScratchArena *scratch)
+{
+    LetterBoxInfo info = letterbox_info(frame.width, frame.height, width, height, LETTERBOX_RESIZE_PAD);
+    cv::Rect content = letterbox_content_rect(info, frame.width, frame.height);
+    letterbox_fill_border(tensor, width, height, content);
+
+    // 插值表：亮度和色度各一套；行缓存：两行插值中间结果 + Y/U/V各一行
+    const int cw = content.width;
+    const int ch = content.height;
+    size_t taps_size = sizeof(AxisTap) * (cw + ch) * 2;
+    size_t rows_size = sizeof(short) * cw * 2 + cw * 3;
+    std::vector<uint8_t> local_buf;
+    uint8_t *taps_buf = nullptr;
+    uint8_t *rows_buf = nullptr;
+    bool taps_valid = false;
+    if (scratch != nullptr)
+    {
+        // 最后一项区分YUV和BGR的插值表
+        ScratchKey key = {{frame.width, frame.height, (int)width, (int)height, LETTERBOX_RESIZE_PAD, 1}};
+        taps_buf = (uint8_t *)scratch->GetTable(key, taps_size, taps_valid);
+        rows_buf = (uint8_t *)scratch->GetBuffer(SCRATCH_ROWS, rows_size);
+    }
+    else
+    {
+        local_buf.resize(taps_size + rows_size);
+        taps_buf = local_buf.data();
+        rows_buf = local_buf.data() + taps_size;
+    }
+    const int uv_width = (frame.width + 1) / 2;
+    const int uv_height = (frame.height + 1) / 2;
+    AxisTap *x_taps = (AxisTap *)taps_buf;
+    AxisTap *y_taps = x_taps + cw;
+    AxisTap *uv_x_taps = y_taps + ch;
+    AxisTap *uv_y_taps = uv_x_taps + cw;
+    if (!taps_valid)
+    {
+        build_axis_taps(cw, frame.width, 0, frame.width, x_taps);
+        build_axis_taps(ch, frame.height, 0, frame.height, y_taps);
+        build_axis_taps(cw, uv_width, 0, uv_width, uv_x_taps);
+        build_axis_taps(ch, uv_height, 0, uv_height, uv_y_taps);
+    }
+    short *rows = (short *)rows_buf;
+    uint8_t *y_line = rows_buf + sizeof(short) * cw * 2;
+    uint8_t *u_line = y_line + cw;
+    uint8_t *v_line = u_line + cw;
+
+    // 各平面的地址：NV12的U/V交错存放，I420的U/V平面宽高都是Y平面的一半
+    const uint8_t *y_plane = frame.data;
+    const uint8_t *u_plane = frame.data + (size_t)frame.hor_stride * frame.ver_stride;
+    const uint8_t *v_plane = nullptr;
+    int uv_stride = 0;
+    int uv_step = 0;
+    if (frame.format == NN_YUV_NV12)
+    {
+        v_plane = u_plane + 1;
+        uv_stride = frame.hor_stride;
+        uv_step = 2;
+    }
+    else
+    {
+        v_plane = u_plane + (size_t)(frame.hor_stride / 2) * (frame.ver_stride / 2);
+        uv_stride = frame.hor_stride / 2;
+        uv_step = 1;
+    }
+
+    uint8_t *dst = (uint8_t *)tensor.data + ((size_t)content.y * width + content.x) * 3;
+    const size_t dst_stride = (size_t)width * 3;
+    for (int y = 0; y < ch; y++)
+    {
+        resize_plane_line(y_plane, frame.hor_stride, 1, x_taps, y_taps[y], cw, rows, y_line);
+        resize_plane_line(u_plane, uv_stride, uv_step, uv_x_taps, uv_y_taps[y], cw, rows, u_line);
+        resize_plane_line(v_plane, uv_stride, uv_step, uv_x_taps, uv_y_taps[y], cw, rows, v_line);
+        yuv_to_rgb_row(y_line, u_line, v_line, dst + y * dst_stride, cw);
+    }
+    return info;
+}
@@ -0,0 +1,116 @@
+// motion_gate.h的实现
+
+#include "motion_gate.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NN_MOTION_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NN_MOTION_SSE2 1
+#endif
+
+/**
+ * @brief 统计差值绝对值大于thresh的字节数，各个指令集的实现结果一致
+ * @param a 数据a
+ * @param b 数据b
+ * @param n 字节数
+ * @param thresh 差值阈值
+ * @return int 差值大于thresh的字节数
+ */
+int count_diff_over(const uint8_t *a, const uint8_t *b, int n, uint8_t thresh)
+{
+    int i = 0;
+    int count = 0;
+#if defined(NN_MOTION_NEON)
+    uint8x16_t vt = vdupq_n_u8(thresh);
+    uint32x4_t total = vdupq_n_u32(0);
+    while (i + 16 <= n)
+    {
+        // 每个通道的8位计数最多累加255次
+        uint8x16_t acc = vdupq_n_u8(0);
+        for (int k = 0; k < 255 && i + 16 <= n; k++, i += 16)
+        {
+            uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+            acc = vsubq_u8(acc, vcgtq_u8(d, vt));
+        }
+        total = vaddq_u32(total, vpaddlq_u16(vpaddlq_u8(acc)));
+    }
+    count = vgetq_lane_u32(total, 0) + vgetq_lane_u32(total, 1) + vgetq_lane_u32(total, 2) + vgetq_lane_u32(total, 3);
+#elif defined(NN_MOTION_SSE2)
+    __m128i vt = _mm_set1_epi8((char)thresh);
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+        // d <= thresh时饱和减为0
+        int same = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(d, vt), zero));
+        count += 16 - __builtin_popcount(same);
+    }
+#endif
+    for (; i < n; i++)
+    {
+        count += abs(a[i] - b[i]) > thresh;
+    }
+    return count;
+}
+
+MotionGate::MotionGate(int width, int pixel_thresh, float motion_ratio, int max_skip, float bg_alpha)
+    : width_(width), pixel_thresh_(pixel_thresh), motion_ratio_(motion_ratio), max_skip_(max_skip),
+      bg_alpha_(bg_alpha), skip_run_(0), frames_(0), skipped_(0), cost_us_(0)
+{
+}
+
+/**
+ * @brief 检查一帧是否需要推理：缩小到width宽的灰度图，和背景比较后更新背景
+ * @param img BGR图像或单通道灰度图像
+ * @return true 有运动、没有背景或连续跳过已达上限，需要推理
+ * @return false 画面静止，可以沿用上一次的检测结果
+ */
+bool MotionGate::Check(const cv::Mat &img)
+{
+    auto start = std::chrono::steady_clock::now();
+    int height = std::max(1, img.rows * width_ / std::max(1, img.cols));
+    cv::resize(img, small_, cv::Size(width_, height), 0, 0, cv::INTER_AREA);
+    if (small_.channels() == 3)
+    {
+        cv::cvtColor(small_, gray_, cv::COLOR_BGR2GRAY);
+    }
+    else
+    {
+        small_.copyTo(gray_);
+    }
+
+    bool motion = true;
+    if (background_.size() == gray_.size())
+    {
+        int changed = count_diff_over(gray_.data, background_.data, (int)gray_.total(), (uint8_t)pixel_thresh_);
+        motion = changed > motion_ratio_ * gray_.total() || skip_run_ >= max_skip_;
+        // 背景的滑动平均，静止后停下的车辆会逐渐并入背景
+        cv::addWeighted(background_, 1.0 - bg_alpha_, gray_, bg_alpha_, 0, background_);
+    }
+    else
+    {
+        gray_.copyTo(background_);
+    }
+
+    frames_++;
+    if (motion)
+    {
+        skip_run_ = 0;
+    }
+    else
+    {
+        skip_run_++;
+        skipped_++;
+    }
+    cost_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    return motion;
+}
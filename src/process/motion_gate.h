@@ -0,0 +1,49 @@
+// 运动门限：固定机位的静止画面不需要每帧都送NPU，和背景相比变化很小的帧直接沿用上一次的检测结果
+
+#ifndef RK3588_DEMO_MOTION_GATE_H
+#define RK3588_DEMO_MOTION_GATE_H
+
+#include <stdint.h>
+
+#include <opencv2/opencv.hpp>
+
+// 统计两块数据中差值绝对值大于thresh的字节数
+int count_diff_over(const uint8_t *a, const uint8_t *b, int n, uint8_t thresh);
+
+// 在缩小的灰度图上和滑动平均的背景做差，变化像素的比例低于阈值时认为画面静止
+// 不是线程安全的，由提交帧的线程使用
+class MotionGate
+{
+public:
+    /**
+     * @param width 缩小后的宽度，高度按原图比例
+     * @param pixel_thresh 单个像素的灰度差超过该值算作变化
+     * @param motion_ratio 变化像素的比例超过该值认为有运动
+     * @param max_skip 连续跳过的最大帧数，之后强制推理一次，避免结果长时间不更新
+     * @param bg_alpha 背景的更新速度，吸收光照等缓慢变化
+     */
+    MotionGate(int width = 160, int pixel_thresh = 25, float motion_ratio = 0.002f, int max_skip = 30,
+               float bg_alpha = 0.05f);
+
+    bool Check(const cv::Mat &img); // 返回true表示需要推理；img为BGR或单通道灰度（如YUV的Y平面）
+
+    uint64_t Frames() const { return frames_; }   // 检查的帧数
+    uint64_t Skipped() const { return skipped_; } // 跳过推理的帧数
+    uint64_t CostUs() const { return cost_us_; }  // 检查的总耗时（微秒）
+
+private:
+    int width_;
+    int pixel_thresh_;
+    float motion_ratio_;
+    int max_skip_;
+    float bg_alpha_;
+    int skip_run_;       // 当前连续跳过的帧数
+    cv::Mat small_;      // 缩小的当前帧
+    cv::Mat gray_;       // 缩小的当前帧（灰度）
+    cv::Mat background_; // 背景（灰度）
+    uint64_t frames_;
+    uint64_t skipped_;
+    uint64_t cost_us_;
+};
+
+#endif // RK3588_DEMO_MOTION_GATE_H
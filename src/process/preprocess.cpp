@@ -2,13 +2,100 @@
 
 #include "preprocess.h"
 
+#include <math.h>
+
+#include <algorithm>
+
 #include "utils/logging.h"
+#ifndef NN_DISABLE_RKNN
 #include "im2d.h"
 #include "rga.h"
+#endif
+
+
+/**
+ * @brief 先补边方式下，把原图补成wh_ratio的宽高比需要的每一侧padding
+ * @param img_width 原图宽度
+ * @param img_height 原图高度
+ * @param wh_ratio 目标宽高比
+ * @param pad_hor 左右两侧各自的padding
+ * @param pad_ver 上下两侧各自的padding
+ */
+void letterbox_padding(int img_width, int img_height, float wh_ratio, int &pad_hor, int &pad_ver)
+{
+    if ((float)img_width / img_height > wh_ratio)
+    {
+        int letterbox_height = img_width / wh_ratio;
+        pad_hor = 0;
+        pad_ver = (letterbox_height - img_height) / 2.f;
+    }
+    else
+    {
+        int letterbox_width = img_height * wh_ratio;
+        pad_hor = (letterbox_width - img_width) / 2.f;
+        pad_ver = 0;
+    }
+}
 
+/**
+ * @brief 计算原图到模型输入的映射
+ * @param img_width 原图宽度
+ * @param img_height 原图高度
+ * @param width 模型输入宽度
+ * @param height 模型输入高度
+ * @param mode letterbox方式
+ * @return LetterBoxInfo 缩放比例和偏移
+ */
+LetterBoxInfo letterbox_info(int img_width, int img_height, uint32_t width, uint32_t height, letterbox_mode_e mode)
+{
+    LetterBoxInfo info;
+    if (mode == LETTERBOX_PAD_RESIZE)
+    {
+        // 补边后的图像整体缩放到模型输入
+        int pad_hor = 0;
+        int pad_ver = 0;
+        letterbox_padding(img_width, img_height, (float)width / height, pad_hor, pad_ver);
+        info.scale_x = (float)width / (img_width + pad_hor * 2);
+        info.scale_y = (float)height / (img_height + pad_ver * 2);
+        info.x_pad = pad_hor * info.scale_x;
+        info.y_pad = pad_ver * info.scale_y;
+        return info;
+    }
+    // 按较小的比例缩放，内容区域居中
+    float scale = std::min((float)width / img_width, (float)height / img_height);
+    int content_width = std::max(1, std::min((int)width, (int)lroundf(img_width * scale)));
+    int content_height = std::max(1, std::min((int)height, (int)lroundf(img_height * scale)));
+    info.scale_x = (float)content_width / img_width;
+    info.scale_y = (float)content_height / img_height;
+    info.x_pad = (width - content_width) / 2;
+    info.y_pad = (height - content_height) / 2;
+    return info;
+}
+
+// 原图内容在模型输入中的区域
+cv::Rect letterbox_content_rect(const LetterBoxInfo &info, int img_width, int img_height)
+{
+    return cv::Rect(lroundf(info.x_pad), lroundf(info.y_pad), lroundf(img_width * info.scale_x),
+                    lroundf(img_height * info.scale_y));
+}
+
+// 把模型输入中content以外的区域填0
+void letterbox_fill_border(tensor_data_s &tensor, uint32_t width, uint32_t height, const cv::Rect &content)
+{
+    uint8_t *data = (uint8_t *)tensor.data;
+    size_t row_size = width * 3;
+    memset(data, 0, content.y * row_size);
+    for (int y = content.y; y < content.y + content.height; y++)
+    {
+        uint8_t *row = data + y * row_size;
+        memset(row, 0, content.x * 3);
+        memset(row + (content.x + content.width) * 3, 0, (width - content.x - content.width) * 3);
+    }
+    memset(data + (content.y + content.height) * row_size, 0, (height - content.y - content.height) * row_size);
+}
 
 // opencv 版本的 letterbox
-LetterBoxInfo letterbox(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio)
+LetterBoxInfo letterbox(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio, ScratchArena *scratch)
 {
     // img has to be 3 channels
     if (img.channels() != 3)
@@ -16,34 +103,14 @@ LetterBoxInfo letterbox(const cv::Mat &img, cv::Mat &img_letterbox, float wh_rat
         NN_LOG_ERROR("img has to be 3 channels");
         exit(-1);
     }
-    float img_width = img.cols;
-    float img_height = img.rows;
-
-    int letterbox_width = 0;
-    int letterbox_height = 0;
-
-    LetterBoxInfo info;
     int padding_hor = 0;
     int padding_ver = 0;
-
-    if (img_width / img_height > wh_ratio)
+    letterbox_padding(img.cols, img.rows, wh_ratio, padding_hor, padding_ver);
+    LetterBoxInfo info = {1.f, 1.f, (float)padding_hor, (float)padding_ver};
+    if (scratch != nullptr)
     {
-        info.hor = false;
-        letterbox_width = img_width;
-        letterbox_height = img_width / wh_ratio;
-        info.pad = (letterbox_height - img_height) / 2.f;
-        padding_hor = 0;
-        padding_ver = info.pad;
-        
-    }
-    else
-    {
-        info.hor = true;
-        letterbox_width = img_height * wh_ratio;
-        letterbox_height = img_height;
-        info.pad = (letterbox_width - img_width) / 2.f;
-        padding_hor = info.pad;
-        padding_ver = 0;
+        // 尺寸不变时copyMakeBorder直接写入复用的图像
+        img_letterbox = scratch->GetMat(SCRATCH_LETTERBOX, img.rows + padding_ver * 2, img.cols + padding_hor * 2, CV_8UC3);
     }
     // 使用cv::copyMakeBorder函数进行填充边界
     cv::copyMakeBorder(img, img_letterbox, padding_ver, padding_ver, padding_hor, padding_hor, cv::BORDER_CONSTANT, cv::Scalar(0, 0, 0));
@@ -51,7 +118,7 @@ LetterBoxInfo letterbox(const cv::Mat &img, cv::Mat &img_letterbox, float wh_rat
 }
 
 // opencv resize
-void cvimg2tensor(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor)
+void cvimg2tensor(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor, ScratchArena *scratch)
 {
     // img has to be 3 channels
     if (img.channels() != 3)
@@ -61,15 +128,44 @@ void cvimg2tensor(const cv::Mat &img, uint32_t width, uint32_t height, tensor_da
     }
     // BGR to RGB
     cv::Mat img_rgb;
+    if (scratch != nullptr)
+    {
+        img_rgb = scratch->GetMat(SCRATCH_RGB, img.rows, img.cols, CV_8UC3);
+    }
     cv::cvtColor(img, img_rgb, cv::COLOR_BGR2RGB);
-    // resize img
-    cv::Mat img_resized;
-    // resize img
+    // resize img，直接写入tensor，不再经过中间图像和拷贝
+    cv::Mat img_resized(height, width, CV_8UC3, tensor.data);
     cv::resize(img_rgb, img_resized, cv::Size(width, height), 0, 0, cv::INTER_LINEAR);
-    // BGR to RGB
-    memcpy(tensor.data, img_resized.data, tensor.attr.size);
 }
 
+/**
+ * @brief opencv 版本的先缩放再补边：只缩放原图内容到tensor的子区域，不生成原图大小的补边图像
+ * @param img 原图，BGR
+ * @param width 模型输入宽度
+ * @param height 模型输入高度
+ * @param tensor 输入张量，uint8 NHWC
+ * @return LetterBoxInfo 缩放比例和偏移
+ */
+LetterBoxInfo letterbox_resize(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor)
+{
+    // img has to be 3 channels
+    if (img.channels() != 3)
+    {
+        NN_LOG_ERROR("img has to be 3 channels");
+        exit(-1);
+    }
+    LetterBoxInfo info = letterbox_info(img.cols, img.rows, width, height, LETTERBOX_RESIZE_PAD);
+    cv::Rect content = letterbox_content_rect(info, img.cols, img.rows);
+    // 直接在tensor内存上操作，resize写入子区域后原地转为RGB
+    cv::Mat dst(height, width, CV_8UC3, tensor.data);
+    cv::Mat dst_content = dst(content);
+    cv::resize(img, dst_content, content.size(), 0, 0, cv::INTER_LINEAR);
+    cv::cvtColor(dst_content, dst_content, cv::COLOR_BGR2RGB);
+    letterbox_fill_border(tensor, width, height, content);
+    return info;
+}
+
+#ifndef NN_DISABLE_RKNN
 // rga 版本的 resize
 void cvimg2tensor_rga(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor)
 {
@@ -80,14 +176,12 @@ void cvimg2tensor_rga(const cv::Mat &img, uint32_t width, uint32_t height, tenso
         exit(-1);
     }
 
-    cv::Mat img_rgb;
-    cv::cvtColor(img, img_rgb, cv::COLOR_BGR2RGB);
-
+    // BGR到RGB由RGA在缩放的同时完成
     im_rect src_rect;
     im_rect dst_rect;
     memset(&src_rect, 0, sizeof(src_rect));
     memset(&dst_rect, 0, sizeof(dst_rect));
-    rga_buffer_t src = wrapbuffer_virtualaddr((void *)img_rgb.data, img.cols, img.rows, RK_FORMAT_RGB_888);
+    rga_buffer_t src = wrapbuffer_virtualaddr((void *)img.data, img.cols, img.rows, RK_FORMAT_BGR_888);
     rga_buffer_t dst = wrapbuffer_virtualaddr((void *)tensor.data, width, height, RK_FORMAT_RGB_888);
     int ret = imcheck(src, dst, src_rect, dst_rect);
     if (IM_STATUS_NOERROR != ret)
@@ -99,7 +193,7 @@ void cvimg2tensor_rga(const cv::Mat &img, uint32_t width, uint32_t height, tenso
 }
 
 // rga 版本的 letterbox
-LetterBoxInfo letterbox_rga(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio)
+LetterBoxInfo letterbox_rga(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio, ScratchArena *scratch)
 {
     // img has to be 3 channels
     if (img.channels() != 3)
@@ -107,36 +201,19 @@ LetterBoxInfo letterbox_rga(const cv::Mat &img, cv::Mat &img_letterbox, float wh
         NN_LOG_ERROR("img has to be 3 channels");
         exit(-1);
     }
-    float img_width = img.cols;
-    float img_height = img.rows;
-
-    int letterbox_width = 0;
-    int letterbox_height = 0;
-
-    LetterBoxInfo info;
     int padding_hor = 0;
     int padding_ver = 0;
-
-    if (img_width / img_height > wh_ratio)
+    letterbox_padding(img.cols, img.rows, wh_ratio, padding_hor, padding_ver);
+    LetterBoxInfo info = {1.f, 1.f, (float)padding_hor, (float)padding_ver};
+    // rga add border，immakeBorder会写满整张图像，复用的图像不需要清零
+    if (scratch != nullptr)
     {
-        info.hor = false;
-        letterbox_width = img_width;
-        letterbox_height = img_width / wh_ratio;
-        info.pad = (letterbox_height - img_height) / 2.f;
-        padding_hor = 0;
-        padding_ver = info.pad;
+        img_letterbox = scratch->GetMat(SCRATCH_LETTERBOX, img.rows + padding_ver * 2, img.cols + padding_hor * 2, CV_8UC3);
     }
     else
     {
-        info.hor = true;
-        letterbox_width = img_height * wh_ratio;
-        letterbox_height = img_height;
-        info.pad = (letterbox_width - img_width) / 2.f;
-        padding_hor = info.pad;
-        padding_ver = 0;
+        img_letterbox = cv::Mat::zeros(img.rows + padding_ver * 2, img.cols + padding_hor * 2, CV_8UC3);
     }
-    // rga add border
-    img_letterbox = cv::Mat::zeros(letterbox_height, letterbox_width, CV_8UC3);
 
     im_rect src_rect;
     im_rect dst_rect;
@@ -157,4 +234,16 @@ LetterBoxInfo letterbox_rga(const cv::Mat &img, cv::Mat &img_letterbox, float wh
     immakeBorder(src, dst, padding_ver, padding_ver, padding_hor, padding_hor, 0, 0, 0);
 
     return info;
-}
\ No newline at end of file
+}
+#else
+// 编译时关闭了RKNN和RGA，使用opencv版本
+void cvimg2tensor_rga(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor)
+{
+    cvimg2tensor(img, width, height, tensor);
+}
+
+LetterBoxInfo letterbox_rga(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio, ScratchArena *scratch)
+{
+    return letterbox(img, img_letterbox, wh_ratio, scratch);
+}
+#endif // NN_DISABLE_RKNN
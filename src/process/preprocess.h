@@ -5,16 +5,44 @@
 
 #include <opencv2/opencv.hpp>
 #include "types/datatype.h"
+#include "scratch_arena.h"
 
+// letterbox的方式
+typedef enum
+{
+    LETTERBOX_PAD_RESIZE = 0, // 先在原图分辨率下补边再缩放，需要一张原图大小的补边图像
+    LETTERBOX_RESIZE_PAD = 1, // 只把原图内容缩放到模型输入的子区域，再填充边界
+} letterbox_mode_e;
+
+// 原图到模型输入的映射：模型输入坐标 = 原图坐标 * scale + pad
 struct LetterBoxInfo
 {
-    bool hor;
-    int pad;
+    float scale_x; // 原图到模型输入的缩放比例（x方向）
+    float scale_y; // 原图到模型输入的缩放比例（y方向），和scale_x只有取整误差
+    float x_pad;   // 原图内容在模型输入中的左侧偏移（模型输入像素）
+    float y_pad;   // 原图内容在模型输入中的上侧偏移（模型输入像素）
 };
 
-LetterBoxInfo letterbox(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio);
-LetterBoxInfo letterbox_rga(const cv::Mat& img, cv::Mat& img_letterbox, float wh_ratio);
-void cvimg2tensor(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor);
+void letterbox_padding(int img_width, int img_height, float wh_ratio, int &pad_hor, int &pad_ver); // 先补边方式下每一侧的padding
+LetterBoxInfo letterbox_info(int img_width, int img_height, uint32_t width, uint32_t height,
+                             letterbox_mode_e mode);                                             // 原图到width x height模型输入的映射
+cv::Rect letterbox_content_rect(const LetterBoxInfo &info, int img_width, int img_height);         // 原图内容在模型输入中的区域
+void letterbox_fill_border(tensor_data_s &tensor, uint32_t width, uint32_t height, const cv::Rect &content); // 把content以外的区域填0
+// 先补边方式：返回的LetterBoxInfo相对于img_letterbox（scale为1）
+LetterBoxInfo letterbox(const cv::Mat &img, cv::Mat &img_letterbox, float wh_ratio, ScratchArena *scratch = nullptr);
+LetterBoxInfo letterbox_rga(const cv::Mat& img, cv::Mat& img_letterbox, float wh_ratio, ScratchArena *scratch = nullptr);
+// scratch不为空时中间图像从scratch中获取，稳定的视频流不再逐帧分配内存
+void cvimg2tensor(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor, ScratchArena *scratch = nullptr);
 void cvimg2tensor_rga(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor);
+// 先缩放再补边：原图内容直接缩放并转为RGB写入tensor的子区域，边界填0
+LetterBoxInfo letterbox_resize(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor);
+// 融合的letterbox：padding、缩放、BGR转RGB一次完成，直接写入tensor
+LetterBoxInfo letterbox_fused(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                              letterbox_mode_e mode = LETTERBOX_RESIZE_PAD, ScratchArena *scratch = nullptr);
+// 融合的YUV letterbox：NV12/I420直接缩放并转为RGB写入tensor（先缩放再补边），不经过BGR图像
+LetterBoxInfo letterbox_fused_yuv(const yuv_frame_s &frame, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                                  ScratchArena *scratch = nullptr);
+// 融合letterbox是否使用NEON/SSE2（默认开启），关闭后使用结果完全相同的标量实现
+void letterbox_fused_enable_simd(bool enable);
 
 #endif // RK3588_DEMO_PREPROCESS_H
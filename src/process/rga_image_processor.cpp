@@ -0,0 +1,324 @@
+// RGA预处理：BGR转RGB和缩放由一次improcess完成。原图拷贝到按实例分配、重复使用的DMA-heap内存后由RGA读取
+// （可选每帧导入原图的虚拟地址，省去拷贝但每帧要映射一次页表）；登记了dma-buf的张量（零拷贝的NPU输入）
+// 由RGA直接写入，否则经过输出DMA内存中转。边界只在内容区域变化时填充，之后只写入内容区域
+
+#include "image_processor.h"
+
+#include "utils/logging.h"
+
+#ifndef NN_DISABLE_RKNN
+#include <string.h>
+#include <unistd.h>
+
+#include "dma_buffer.h"
+#include "im2d.h"
+#include "rga.h"
+
+class RGAImageProcessor : public ImageProcessor
+{
+public:
+    explicit RGAImageProcessor(bool import_src)
+        : src_handle_(0), dst_handle_(0), dst_width_(0), dst_height_(0), import_src_(import_src),
+          virt_src_failed_(false), tensor_fd_(-1),
+          tensor_base_(nullptr), tensor_size_(0), tensor_handle_(0), tensor_border_offset_(-1){};
+    ~RGAImageProcessor() override
+    {
+        ReleaseHandle(src_handle_);
+        ReleaseHandle(dst_handle_);
+        ReleaseHandle(tensor_handle_);
+    }
+
+    const char *Name() override { return "rga"; }
+
+    void SetTensorDma(int fd, void *base, size_t size) override
+    {
+        ReleaseHandle(tensor_handle_);
+        tensor_fd_ = fd;
+        tensor_base_ = (uint8_t *)base;
+        tensor_size_ = size;
+        tensor_border_offset_ = -1;
+        if (fd >= 0)
+        {
+            tensor_handle_ = importbuffer_fd(fd, size);
+            if (tensor_handle_ == 0)
+            {
+                NN_LOG_WARNING("rga import tensor buffer fail, write through dma buffer");
+            }
+        }
+    }
+
+    /**
+     * @brief RGA一次完成转RGB和缩放到tensor的内容区域；原图先拷贝到输入DMA内存，
+     *        开启import_src且原图连续时RGA直接读取原图内存
+     * @param img 原图，BGR
+     * @param width 模型输入宽度
+     * @param height 模型输入高度
+     * @param tensor 输入张量，uint8 NHWC
+     * @param info 缩放比例和偏移
+     * @return nn_error_e 错误码
+     */
+    nn_error_e Letterbox(const cv::Mat &img, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                         LetterBoxInfo &info) override
+    {
+        if (img.channels() != 3 || img.depth() != CV_8U)
+        {
+            NN_LOG_ERROR("img has to be 3 channels");
+            return NN_RGA_PROCESS_FAIL;
+        }
+        info = letterbox_info(img.cols, img.rows, width, height, LETTERBOX_RESIZE_PAD);
+        cv::Rect content = letterbox_content_rect(info, img.cols, img.rows);
+
+        if (import_src_ && img.isContinuous() && !virt_src_failed_)
+        {
+            // 每帧导入原图的虚拟地址，省去整张原图的拷贝
+            rga_buffer_handle_t handle = importbuffer_virtualaddr(img.data, img.total() * img.elemSize());
+            if (handle != 0)
+            {
+                rga_buffer_t src = wrapbuffer_handle(handle, img.cols, img.rows, RK_FORMAT_BGR_888);
+                auto ret = Process(src, img.cols, img.rows, width, height, content, tensor);
+                releasebuffer_handle(handle);
+                return ret;
+            }
+            // 导入不了原图内存，之后都拷贝到输入DMA内存
+            NN_LOG_WARNING("rga import image memory fail, fallback to copy");
+            virt_src_failed_ = true;
+        }
+
+        auto ret = PrepareSource(img.cols, img.rows, 3);
+        if (ret != NN_SUCCESS)
+        {
+            return ret;
+        }
+        // 原图拷贝到DMA内存（按行拷贝，支持不连续的Mat）
+        src_buf_.SyncBegin(true);
+        size_t src_row = img.cols * 3;
+        for (int y = 0; y < img.rows; y++)
+        {
+            memcpy((uint8_t *)src_buf_.Data() + y * src_row, img.ptr<uint8_t>(y), src_row);
+        }
+        src_buf_.SyncEnd(true);
+
+        rga_buffer_t src = wrapbuffer_handle(src_handle_, img.cols, img.rows, RK_FORMAT_BGR_888);
+        return Process(src, img.cols, img.rows, width, height, content, tensor);
+    }
+
+    /**
+     * @brief YUV420帧：有dma-buf fd时RGA直接读取，否则先拷贝到输入DMA内存；颜色转换和缩放由一次improcess完成
+     * @param frame YUV420帧
+     * @param width 模型输入宽度
+     * @param height 模型输入高度
+     * @param tensor 输入张量，uint8 NHWC
+     * @param info 缩放比例和偏移
+     * @return nn_error_e 错误码
+     */
+    nn_error_e LetterboxYuv(const yuv_frame_s &frame, uint32_t width, uint32_t height, tensor_data_s &tensor,
+                            LetterBoxInfo &info) override
+    {
+        info = letterbox_info(frame.width, frame.height, width, height, LETTERBOX_RESIZE_PAD);
+        cv::Rect content = letterbox_content_rect(info, frame.width, frame.height);
+        int format = frame.format == NN_YUV_NV12 ? RK_FORMAT_YCbCr_420_SP : RK_FORMAT_YCbCr_420_P;
+        size_t frame_size = (size_t)frame.hor_stride * frame.ver_stride * 3 / 2;
+        if (frame.fd >= 0)
+        {
+            // 解码器的dma-buf每帧导入一次，RGA直接读取，不经过CPU
+            rga_buffer_handle_t handle = importbuffer_fd(frame.fd, frame_size);
+            if (handle == 0)
+            {
+                NN_LOG_ERROR("rga import yuv frame fail");
+                return NN_RGA_PROCESS_FAIL;
+            }
+            rga_buffer_t src = wrapbuffer_handle(handle, frame.width, frame.height, format, frame.hor_stride, frame.ver_stride);
+            auto ret = Process(src, frame.width, frame.height, width, height, content, tensor);
+            releasebuffer_handle(handle);
+            return ret;
+        }
+        // 没有fd时按Y平面的尺寸分配输入内存，整帧拷贝
+        auto ret = PrepareSource(frame.hor_stride, frame.ver_stride * 3 / 2, 1);
+        if (ret != NN_SUCCESS)
+        {
+            return ret;
+        }
+        src_buf_.SyncBegin(true);
+        memcpy(src_buf_.Data(), frame.data, frame_size);
+        src_buf_.SyncEnd(true);
+        rga_buffer_t src = wrapbuffer_handle(src_handle_, frame.width, frame.height, format, frame.hor_stride, frame.ver_stride);
+        return Process(src, frame.width, frame.height, width, height, content, tensor);
+    }
+
+private:
+    // RGA一次完成颜色转换和缩放到内容区域：tensor在登记的dma-buf中时直接写入tensor，
+    // 否则写入输出DMA内存再拷贝到tensor
+    nn_error_e Process(rga_buffer_t src, int src_width, int src_height, uint32_t width, uint32_t height,
+                       const cv::Rect &content, tensor_data_s &tensor)
+    {
+        rga_buffer_t dst;
+        im_rect dst_rect = {content.x, content.y, content.width, content.height};
+        int row_offset = TensorRowOffset(tensor, width, height);
+        if (row_offset >= 0)
+        {
+            // 整块张量内存看作width宽的一张图像，批量输入中的第几张由行偏移决定
+            PrepareTensorBorder(tensor, width, height, content, row_offset);
+            dst = wrapbuffer_handle(tensor_handle_, width, tensor_size_ / ((size_t)width * 3), RK_FORMAT_RGB_888);
+            dst_rect.y += row_offset;
+        }
+        else
+        {
+            auto ret = PrepareOutput(width, height, content);
+            if (ret != NN_SUCCESS)
+            {
+                return ret;
+            }
+            dst = wrapbuffer_handle(dst_handle_, width, height, RK_FORMAT_RGB_888);
+        }
+        rga_buffer_t pat;
+        memset(&pat, 0, sizeof(pat));
+        im_rect src_rect = {0, 0, src_width, src_height};
+        im_rect pat_rect;
+        memset(&pat_rect, 0, sizeof(pat_rect));
+        int status = improcess(src, dst, pat, src_rect, dst_rect, pat_rect, -1, NULL, NULL, IM_SYNC);
+        if (status != IM_STATUS_SUCCESS)
+        {
+            NN_LOG_ERROR("rga letterbox fail! %s", imStrError((IM_STATUS)status));
+            return NN_RGA_PROCESS_FAIL;
+        }
+
+        if (row_offset < 0)
+        {
+            dst_buf_.SyncBegin(false);
+            memcpy(tensor.data, dst_buf_.Data(), (size_t)width * height * 3);
+            dst_buf_.SyncEnd(false);
+        }
+        return NN_SUCCESS;
+    }
+
+    // tensor整个落在登记的dma-buf中、且从整行开始时返回它的起始行，否则返回-1
+    int TensorRowOffset(const tensor_data_s &tensor, uint32_t width, uint32_t height)
+    {
+        if (tensor_handle_ == 0 || tensor.data < tensor_base_)
+        {
+            return -1;
+        }
+        size_t row_size = (size_t)width * 3;
+        size_t offset = (uint8_t *)tensor.data - tensor_base_;
+        if (offset % row_size != 0 || offset + row_size * height > tensor_size_)
+        {
+            return -1;
+        }
+        return offset / row_size;
+    }
+
+    // 直接写入tensor时由CPU填充边界，只在内容区域或起始行变化时填充；
+    // 填充后立即刷新缓存，避免和内容区域共享缓存行的脏数据之后覆盖RGA写入的像素
+    void PrepareTensorBorder(tensor_data_s &tensor, uint32_t width, uint32_t height, const cv::Rect &content,
+                             int row_offset)
+    {
+        if (content == tensor_content_ && row_offset == tensor_border_offset_)
+        {
+            return;
+        }
+        dma_buf_sync(tensor_fd_, true, true);
+        letterbox_fill_border(tensor, width, height, content);
+        dma_buf_sync(tensor_fd_, false, true);
+        tensor_content_ = content;
+        tensor_border_offset_ = row_offset;
+    }
+
+    // 原图尺寸变化时重新分配输入DMA内存，稳定的视频流只在第一帧分配；channels为每个像素的字节数
+    nn_error_e PrepareSource(int src_width, int src_height, int channels)
+    {
+        size_t src_size = (size_t)src_width * src_height * channels;
+        if (src_size == src_buf_.Size())
+        {
+            return NN_SUCCESS;
+        }
+        ReleaseHandle(src_handle_);
+        if (src_buf_.Alloc(src_size) != NN_SUCCESS)
+        {
+            return NN_MEM_ALLOC_FAIL;
+        }
+        src_handle_ = importbuffer_fd(src_buf_.Fd(), src_buf_.Size());
+        if (src_handle_ == 0)
+        {
+            NN_LOG_ERROR("rga import src buffer fail");
+            return NN_RGA_PROCESS_FAIL;
+        }
+        return NN_SUCCESS;
+    }
+
+    // 模型输入尺寸变化时重新分配输出DMA内存，内容区域变化时重新填充边界
+    nn_error_e PrepareOutput(uint32_t width, uint32_t height, const cv::Rect &content)
+    {
+        if ((int)width != dst_width_ || (int)height != dst_height_)
+        {
+            ReleaseHandle(dst_handle_);
+            if (dst_buf_.Alloc((size_t)width * height * 3) != NN_SUCCESS)
+            {
+                return NN_MEM_ALLOC_FAIL;
+            }
+            dst_handle_ = importbuffer_fd(dst_buf_.Fd(), dst_buf_.Size());
+            if (dst_handle_ == 0)
+            {
+                NN_LOG_ERROR("rga import dst buffer fail");
+                return NN_RGA_PROCESS_FAIL;
+            }
+            dst_width_ = width;
+            dst_height_ = height;
+            content_ = cv::Rect();
+        }
+        if (content != content_)
+        {
+            // 内容区域变化时重新填充边界，之后每帧只写入内容区域
+            tensor_data_s dst;
+            dst.data = dst_buf_.Data();
+            dst_buf_.SyncBegin(true);
+            letterbox_fill_border(dst, width, height, content);
+            dst_buf_.SyncEnd(true);
+            content_ = content;
+        }
+        return NN_SUCCESS;
+    }
+
+    void ReleaseHandle(rga_buffer_handle_t &handle)
+    {
+        if (handle != 0)
+        {
+            releasebuffer_handle(handle);
+            handle = 0;
+        }
+    }
+
+    DmaBuffer src_buf_;
+    DmaBuffer dst_buf_;
+    rga_buffer_handle_t src_handle_;
+    rga_buffer_handle_t dst_handle_;
+    int dst_width_;
+    int dst_height_;
+    cv::Rect content_;     // 当前输出内存中的内容区域
+    bool import_src_;      // 连续的原图直接导入虚拟地址，不拷贝到输入DMA内存
+    bool virt_src_failed_; // 导入原图内存失败，改为拷贝
+
+    // 登记的张量dma-buf
+    int tensor_fd_;
+    uint8_t *tensor_base_;
+    size_t tensor_size_;
+    rga_buffer_handle_t tensor_handle_;
+    cv::Rect tensor_content_;   // 张量中已经填充好边界的内容区域
+    int tensor_border_offset_; // 填充边界时张量的起始行，-1表示未填充
+};
+
+// 创建RGA实现，没有RGA设备时返回空
+std::shared_ptr<ImageProcessor> CreateRGAImageProcessor(bool import_src)
+{
+    if (access("/dev/rga", F_OK) != 0)
+    {
+        return nullptr;
+    }
+    return std::make_shared<RGAImageProcessor>(import_src);
+}
+#else
+// 编译时关闭了RKNN和RGA
+std::shared_ptr<ImageProcessor> CreateRGAImageProcessor(bool /*import_src*/)
+{
+    return nullptr;
+}
+#endif // NN_DISABLE_RKNN
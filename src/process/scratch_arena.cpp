@@ -0,0 +1,64 @@
+// scratch_arena.h的实现
+
+#include "scratch_arena.h"
+
+// 获取一个rows x cols、type类型的图像，和上次的尺寸、类型相同时不分配内存
+cv::Mat &ScratchArena::GetMat(scratch_slot_e slot, int rows, int cols, int type)
+{
+    cv::Mat &mat = mats_[slot];
+    if (mat.rows == rows && mat.cols == cols && mat.type() == type)
+    {
+        hits_++;
+        return mat;
+    }
+    misses_++;
+    mat.create(rows, cols, type);
+    return mat;
+}
+
+// 获取至少size字节的缓冲区，容量足够时不分配内存
+void *ScratchArena::GetBuffer(scratch_slot_e slot, size_t size)
+{
+    std::vector<uint8_t> &buffer = buffers_[slot];
+    if (buffer.size() >= size)
+    {
+        hits_++;
+        return buffer.data();
+    }
+    misses_++;
+    buffer.resize(size);
+    return buffer.data();
+}
+
+/**
+ * @brief 获取几何参数为key的插值表，命中时内容还是上次计算的结果；未命中时替换最久未使用的一份
+ * @param key 几何参数
+ * @param size 插值表大小（字节），由key决定
+ * @param valid 输出，true表示内容有效，false表示需要调用者重新计算
+ * @return void* 插值表
+ */
+void *ScratchArena::GetTable(const ScratchKey &key, size_t size, bool &valid)
+{
+    table_clock_++;
+    TableEntry *oldest = &tables_[0];
+    for (auto &table : tables_)
+    {
+        if (table.last_use != 0 && table.key == key && table.data.size() == size)
+        {
+            table.last_use = table_clock_;
+            hits_++;
+            valid = true;
+            return table.data.data();
+        }
+        if (table.last_use < oldest->last_use)
+        {
+            oldest = &table;
+        }
+    }
+    misses_++;
+    valid = false;
+    oldest->key = key;
+    oldest->data.resize(size);
+    oldest->last_use = table_clock_;
+    return oldest->data.data();
+}
@@ -0,0 +1,57 @@
+// 预处理的中间缓冲区：按用途分槽保存，尺寸不变时直接复用，避免每帧分配和释放大块内存
+
+#ifndef RK3588_DEMO_SCRATCH_ARENA_H
+#define RK3588_DEMO_SCRATCH_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// 缓冲区的用途
+typedef enum
+{
+    SCRATCH_LETTERBOX = 0, // 先补边方式的原图大小补边图像
+    SCRATCH_RGB = 1,       // 转为RGB的图像
+    SCRATCH_ROWS = 2,      // 融合letterbox的行缓存
+    SCRATCH_SLOT_NUM = 3,
+} scratch_slot_e;
+
+// 插值表的几何参数（原图尺寸、输出尺寸、letterbox方式等），完全相同时插值表可以直接复用
+typedef std::array<int, 6> ScratchKey;
+
+// 每个Yolov5实例持有一个，不能在线程间共享
+class ScratchArena
+{
+public:
+    ScratchArena() : hits_(0), misses_(0){};
+
+    cv::Mat &GetMat(scratch_slot_e slot, int rows, int cols, int type); // 尺寸和类型不变时复用，否则重新分配
+    void *GetBuffer(scratch_slot_e slot, size_t size);                  // 容量足够时复用，否则重新分配
+    void *GetTable(const ScratchKey &key, size_t size, bool &valid);    // 几何参数相同的插值表，valid表示内容无需重新计算
+
+    uint64_t Hits() const { return hits_; }     // 复用的次数
+    uint64_t Misses() const { return misses_; } // 重新分配的次数
+
+private:
+    // 保存最近使用的几份插值表：切片推理的切片和整帧、批量中不同分辨率的图像交替出现时也能命中
+    static const int kTableNum = 4;
+    struct TableEntry
+    {
+        ScratchKey key;
+        std::vector<uint8_t> data;
+        uint64_t last_use{0}; // 0表示未使用
+    };
+
+    cv::Mat mats_[SCRATCH_SLOT_NUM];
+    std::vector<uint8_t> buffers_[SCRATCH_SLOT_NUM];
+    TableEntry tables_[kTableNum];
+    uint64_t table_clock_{0};
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+#endif // RK3588_DEMO_SCRATCH_ARENA_H
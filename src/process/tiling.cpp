@@ -0,0 +1,116 @@
+// tiling.h的实现
+
+#include "tiling.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <numeric>
+
+// 一个方向上的切片起点
+static void axis_tiles(int length, int tile, float overlap, std::vector<int> &starts)
+{
+    starts.clear();
+    if (length <= tile)
+    {
+        starts.push_back(0);
+        return;
+    }
+    int step = std::max(1, tile - (int)lroundf(tile * overlap));
+    for (int pos = 0;; pos += step)
+    {
+        if (pos + tile >= length)
+        {
+            starts.push_back(length - tile);
+            break;
+        }
+        starts.push_back(pos);
+    }
+}
+
+/**
+ * @brief 生成切片区域，按行排列
+ * @param img_width 画面宽度
+ * @param img_height 画面高度
+ * @param tile_width 切片宽度
+ * @param tile_height 切片高度
+ * @param overlap 相邻切片的重叠比例，0~1
+ * @return std::vector<cv::Rect> 切片区域，都在画面内
+ */
+std::vector<cv::Rect> make_tiles(int img_width, int img_height, int tile_width, int tile_height, float overlap)
+{
+    std::vector<cv::Rect> tiles;
+    if (img_width <= 0 || img_height <= 0 || tile_width <= 0 || tile_height <= 0)
+    {
+        return tiles;
+    }
+    overlap = std::min(std::max(overlap, 0.f), 0.9f);
+    std::vector<int> xs, ys;
+    axis_tiles(img_width, tile_width, overlap, xs);
+    axis_tiles(img_height, tile_height, overlap, ys);
+    for (int y : ys)
+    {
+        for (int x : xs)
+        {
+            tiles.push_back(cv::Rect(x, y, std::min(tile_width, img_width), std::min(tile_height, img_height)));
+        }
+    }
+    return tiles;
+}
+
+/**
+ * @brief 按置信度从高到低做一次全局NMS，同时合并被切片边界截断的框
+ * @param objects 所有切片的检测结果（原图坐标），合并后只保留剩下的框
+ * @param tile_ids 每个结果来自的切片
+ * @param nms_thresh IoU阈值
+ * @param merge_thresh 交集占较小框面积的比例阈值，只用于不同切片之间
+ */
+void merge_tile_detections(std::vector<Detection> &objects, const std::vector<int> &tile_ids, float nms_thresh,
+                           float merge_thresh)
+{
+    std::vector<int> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](int a, int b) { return objects[a].confidence > objects[b].confidence; });
+
+    std::vector<bool> removed(objects.size(), false);
+    std::vector<Detection> merged;
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        int n = order[i];
+        if (removed[n])
+        {
+            continue;
+        }
+        Detection keep = objects[n];
+        for (size_t j = i + 1; j < order.size(); j++)
+        {
+            int m = order[j];
+            if (removed[m] || objects[m].class_id != keep.class_id)
+            {
+                continue;
+            }
+            // 和原始框比较，避免扩展后的框越吞越多
+            const cv::Rect &a = objects[n].box;
+            const cv::Rect &b = objects[m].box;
+            float inter = (float)(a & b).area();
+            if (inter <= 0)
+            {
+                continue;
+            }
+            float iou = inter / (a.area() + b.area() - inter);
+            float ios = inter / std::min(a.area(), b.area());
+            if (iou > nms_thresh)
+            {
+                removed[m] = true;
+            }
+            else if (tile_ids[n] != tile_ids[m] && ios > merge_thresh)
+            {
+                keep.box |= b;
+                removed[m] = true;
+            }
+        }
+        merged.push_back(keep);
+    }
+    objects.swap(merged);
+}
@@ -0,0 +1,22 @@
+// 切片推理：高分辨率画面切成相互重叠、模型输入大小的切片分别检测，再把结果合并回原图
+
+#ifndef RK3588_DEMO_TILING_H
+#define RK3588_DEMO_TILING_H
+
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "types/yolo_datatype.h"
+
+// 把img_width x img_height的画面切成tile_width x tile_height的切片，相邻切片重叠overlap（占切片边长的比例）
+// 最后一个切片贴齐画面边缘；画面比切片小的方向只有一个切片
+std::vector<cv::Rect> make_tiles(int img_width, int img_height, int tile_width, int tile_height, float overlap);
+
+// 合并各切片的检测结果（已经换算到原图坐标），tile_ids[i]为objects[i]来自的切片
+// 同类别的框IoU超过nms_thresh时只保留置信度高的；来自不同切片、较小框被覆盖超过merge_thresh时，
+// 认为是被切片边界截断的同一目标，保留的框扩展为两者的并集
+void merge_tile_detections(std::vector<Detection> &objects, const std::vector<int> &tile_ids, float nms_thresh,
+                           float merge_thresh);
+
+#endif // RK3588_DEMO_TILING_H
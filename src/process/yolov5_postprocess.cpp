@@ -21,8 +21,17 @@
 #include <string.h>
 #include <sys/time.h>
 
-#include <set>
+#include <algorithm>
 #include <vector>
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NN_POSTPROCESS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NN_POSTPROCESS_SSE2 1
+#endif
+
 namespace yolov5
 {
 
@@ -42,7 +51,7 @@ namespace yolov5
     const int anchor1[6] = {30, 61, 62, 45, 59, 119};
     const int anchor2[6] = {116, 90, 156, 198, 373, 326};
 
-    inline static int clamp(float val, int min, int max) { return val > min ? (val < max ? val : max) : min; }
+    inline static float clamp(float val, float min, float max) { return val > min ? (val < max ? val : max) : min; }
 
     char *readLine(FILE *fp, char *buffer, int *len)
     {
@@ -122,76 +131,41 @@ namespace yolov5
         return u <= 0.f ? 0.f : (i / u);
     }
 
-    static int
-    nms(int validCount, std::vector<float> &outputLocations, std::vector<int> classIds, std::vector<int> &order,
-        int filterId, float threshold)
+    /**
+     * @brief 一个类别内的NMS：候选框已按置信度排序，只和已保留的框比较，保留数达到max_keep后提前结束
+     * @param cands 同一类别的候选框
+     * @param count 候选框数量
+     * @param boxes 所有候选框，每个为x, y, w, h
+     * @param threshold IoU阈值
+     * @param max_keep 最多保留的数量
+     * @param keep 输出，保留的候选框
+     * @return int 保留的数量
+     */
+    static int nms_bucket(const NmsCandidate *cands, int count, const std::vector<float> &boxes, float threshold,
+                          int max_keep, NmsCandidate *keep)
     {
-        for (int i = 0; i < validCount; ++i)
+        int kept = 0;
+        for (int i = 0; i < count && kept < max_keep; i++)
         {
-            if (order[i] == -1 || classIds[i] != filterId)
-            {
-                continue;
-            }
-            int n = order[i];
-            for (int j = i + 1; j < validCount; ++j)
+            const float *b = &boxes[cands[i].index * 4];
+            bool suppressed = false;
+            for (int k = 0; k < kept; k++)
             {
-                int m = order[j];
-                if (m == -1 || classIds[i] != filterId)
-                {
-                    continue;
-                }
-                float xmin0 = outputLocations[n * 4 + 0];
-                float ymin0 = outputLocations[n * 4 + 1];
-                float xmax0 = outputLocations[n * 4 + 0] + outputLocations[n * 4 + 2];
-                float ymax0 = outputLocations[n * 4 + 1] + outputLocations[n * 4 + 3];
-
-                float xmin1 = outputLocations[m * 4 + 0];
-                float ymin1 = outputLocations[m * 4 + 1];
-                float xmax1 = outputLocations[m * 4 + 0] + outputLocations[m * 4 + 2];
-                float ymax1 = outputLocations[m * 4 + 1] + outputLocations[m * 4 + 3];
-
-                float iou = CalculateOverlap(xmin0, ymin0, xmax0, ymax0, xmin1, ymin1, xmax1, ymax1);
-
+                const float *kb = &boxes[keep[k].index * 4];
+                float iou = CalculateOverlap(kb[0], kb[1], kb[0] + kb[2], kb[1] + kb[3], b[0], b[1], b[0] + b[2],
+                                             b[1] + b[3]);
                 if (iou > threshold)
                 {
-                    order[j] = -1;
+                    suppressed = true;
+                    break;
                 }
             }
-        }
-        return 0;
-    }
-
-    static int quick_sort_indice_inverse(std::vector<float> &input, int left, int right, std::vector<int> &indices)
-    {
-        float key;
-        int key_index;
-        int low = left;
-        int high = right;
-        if (left < right)
-        {
-            key_index = indices[left];
-            key = input[left];
-            while (low < high)
+            if (!suppressed)
             {
-                while (low < high && input[high] <= key)
-                {
-                    high--;
-                }
-                input[low] = input[high];
-                indices[low] = indices[high];
-                while (low < high && input[low] >= key)
-                {
-                    low++;
-                }
-                input[high] = input[low];
-                indices[high] = indices[low];
+                keep[kept++] = cands[i];
             }
-            input[low] = key;
-            indices[low] = key_index;
-            quick_sort_indice_inverse(input, left, low - 1, indices);
-            quick_sort_indice_inverse(input, low + 1, right, indices);
         }
-        return low;
+        return kept;
     }
 
     static float sigmoid(float x) { return 1.0 / (1.0 + expf(-x)); }
@@ -213,70 +187,329 @@ namespace yolov5
 
     static float deqnt_affine_to_f32(int8_t qnt, int32_t zp, float scale) { return ((float)qnt - (float)zp) * scale; }
 
-    static int process(int8_t *input, int *anchor, int grid_h, int grid_w, int height, int width, int stride,
+    /**
+     * @brief 按输出张量的zp/scale计算解码查找表，每一项和逐个调用sigmoid(deqnt_affine_to_f32(...))的结果完全相同
+     * @param zp 量化零点
+     * @param scale 量化比例
+     * @param lut 查找表
+     */
+    void build_decode_lut(int32_t zp, float scale, DECODE_LUT *lut)
+    {
+        for (int q = -128; q <= 127; q++)
+        {
+            float s = sigmoid(deqnt_affine_to_f32((int8_t)q, zp, scale));
+            float wh = s * 2.0;
+            lut->sigmoid[q + 128] = s;
+            lut->xy[q + 128] = s * 2.0 - 0.5;
+            lut->wh[q + 128] = wh * wh;
+        }
+    }
+
+    // 是否使用NEON/SSE2实现，关闭后只用标量实现（测试两者结果一致、对比性能）
+    static bool g_simd_enabled = true;
+
+    void postprocess_enable_simd(bool enable)
+    {
+        g_simd_enabled = enable;
+    }
+
+    /**
+     * @brief 预筛选：在连续存放的objectness平面上找出分数不低于阈值的网格，一次比较64个字节，
+     *        绝大多数网格在这里就被排除；输出的下标按升序排列，和逐个比较的结果完全一致
+     * @param conf objectness平面
+     * @param n 网格数量
+     * @param thres 量化后的阈值
+     * @param indices 输出的候选网格下标，至少n个
+     * @return int 候选网格数量
+     */
+    int prescan_objectness(const int8_t *conf, int n, int8_t thres, int *indices)
+    {
+        int count = 0;
+        int i = 0;
+#if defined(NN_POSTPROCESS_NEON)
+        const int simd_n = g_simd_enabled ? n : 0;
+        int8x16_t vt = vdupq_n_s8(thres);
+        for (; i + 64 <= simd_n; i += 64)
+        {
+            uint8x16_t m0 = vcgeq_s8(vld1q_s8(conf + i), vt);
+            uint8x16_t m1 = vcgeq_s8(vld1q_s8(conf + i + 16), vt);
+            uint8x16_t m2 = vcgeq_s8(vld1q_s8(conf + i + 32), vt);
+            uint8x16_t m3 = vcgeq_s8(vld1q_s8(conf + i + 48), vt);
+            uint64x2_t any = vreinterpretq_u64_u8(vorrq_u8(vorrq_u8(m0, m1), vorrq_u8(m2, m3)));
+            if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) == 0)
+            {
+                continue;
+            }
+            for (int k = i; k < i + 64; k++)
+            {
+                if (conf[k] >= thres)
+                {
+                    indices[count++] = k;
+                }
+            }
+        }
+#elif defined(NN_POSTPROCESS_SSE2)
+        const int simd_n = g_simd_enabled ? n : 0;
+        __m128i vt = _mm_set1_epi8(thres);
+        for (; i + 64 <= simd_n; i += 64)
+        {
+            // 低于阈值的位为1，64位全为1说明没有候选
+            uint64_t below = (uint64_t)(uint16_t)_mm_movemask_epi8(
+                                 _mm_cmpgt_epi8(vt, _mm_loadu_si128((const __m128i *)(conf + i)))) |
+                             (uint64_t)(uint16_t)_mm_movemask_epi8(
+                                 _mm_cmpgt_epi8(vt, _mm_loadu_si128((const __m128i *)(conf + i + 16)))) << 16 |
+                             (uint64_t)(uint16_t)_mm_movemask_epi8(
+                                 _mm_cmpgt_epi8(vt, _mm_loadu_si128((const __m128i *)(conf + i + 32)))) << 32 |
+                             (uint64_t)(uint16_t)_mm_movemask_epi8(
+                                 _mm_cmpgt_epi8(vt, _mm_loadu_si128((const __m128i *)(conf + i + 48)))) << 48;
+            uint64_t hits = ~below;
+            while (hits != 0)
+            {
+                indices[count++] = i + __builtin_ctzll(hits);
+                hits &= hits - 1;
+            }
+        }
+#endif
+        for (; i < n; i++)
+        {
+            if (conf[i] >= thres)
+            {
+                indices[count++] = i;
+            }
+        }
+        return count;
+    }
+
+    static int process(int8_t *input, int *anchor, int grid_h, int grid_w, int stride,
                        std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId,
                        float threshold,
-                       int32_t zp, float scale)
+                       int32_t zp, float scale, const DECODE_LUT &lut, std::vector<int> &candidates)
     {
         int validCount = 0;
         int grid_len = grid_h * grid_w;
         float thres = unsigmoid(threshold);
         int8_t thres_i8 = qnt_f32_to_affine(thres, zp, scale);
+        // 预分配过时不会重新分配
+        candidates.resize(grid_len);
         for (int a = 0; a < 3; a++)
         {
-            for (int i = 0; i < grid_h; i++)
+            // 先筛选出objectness达到阈值的网格，只对它们解码框和求类别最大值
+            int candidate_num = prescan_objectness(input + (PROP_BOX_SIZE * a + 4) * grid_len, grid_len, thres_i8,
+                                                   candidates.data());
+            for (int c = 0; c < candidate_num; c++)
             {
-                for (int j = 0; j < grid_w; j++)
+                int i = candidates[c] / grid_w;
+                int j = candidates[c] % grid_w;
+                int8_t box_confidence = input[(PROP_BOX_SIZE * a + 4) * grid_len + i * grid_w + j];
+                int offset = (PROP_BOX_SIZE * a) * grid_len + i * grid_w + j;
+                int8_t *in_ptr = input + offset;
+                // 查表代替sigmoid：xy为2σ-0.5，wh为(2σ)^2
+                float box_x = lut.xy[in_ptr[0] + 128];
+                float box_y = lut.xy[in_ptr[grid_len] + 128];
+                float box_w = lut.wh[in_ptr[2 * grid_len] + 128];
+                float box_h = lut.wh[in_ptr[3 * grid_len] + 128];
+                box_x = (box_x + j) * (float)stride;
+                box_y = (box_y + i) * (float)stride;
+                box_w = box_w * (float)anchor[a * 2];
+                box_h = box_h * (float)anchor[a * 2 + 1];
+                box_x -= (box_w / 2.0);
+                box_y -= (box_h / 2.0);
+
+                int8_t maxClassProbs = in_ptr[5 * grid_len];
+                int maxClassId = 0;
+                for (int k = 1; k < OBJ_CLASS_NUM; ++k)
                 {
-                    int8_t box_confidence = input[(PROP_BOX_SIZE * a + 4) * grid_len + i * grid_w + j];
-                    if (box_confidence >= thres_i8)
+                    int8_t prob = in_ptr[(5 + k) * grid_len];
+                    if (prob > maxClassProbs)
                     {
-                        int offset = (PROP_BOX_SIZE * a) * grid_len + i * grid_w + j;
-                        int8_t *in_ptr = input + offset;
-                        float box_x = sigmoid(deqnt_affine_to_f32(*in_ptr, zp, scale)) * 2.0 - 0.5;
-                        float box_y = sigmoid(deqnt_affine_to_f32(in_ptr[grid_len], zp, scale)) * 2.0 - 0.5;
-                        float box_w = sigmoid(deqnt_affine_to_f32(in_ptr[2 * grid_len], zp, scale)) * 2.0;
-                        float box_h = sigmoid(deqnt_affine_to_f32(in_ptr[3 * grid_len], zp, scale)) * 2.0;
-                        box_x = (box_x + j) * (float)stride;
-                        box_y = (box_y + i) * (float)stride;
-                        box_w = box_w * box_w * (float)anchor[a * 2];
-                        box_h = box_h * box_h * (float)anchor[a * 2 + 1];
-                        box_x -= (box_w / 2.0);
-                        box_y -= (box_h / 2.0);
-
-                        int8_t maxClassProbs = in_ptr[5 * grid_len];
-                        int maxClassId = 0;
-                        for (int k = 1; k < OBJ_CLASS_NUM; ++k)
-                        {
-                            int8_t prob = in_ptr[(5 + k) * grid_len];
-                            if (prob > maxClassProbs)
-                            {
-                                maxClassId = k;
-                                maxClassProbs = prob;
-                            }
-                        }
-                        if (maxClassProbs > thres_i8)
+                        maxClassId = k;
+                        maxClassProbs = prob;
+                    }
+                }
+                if (maxClassProbs > thres_i8)
+                {
+                    objProbs.push_back(lut.sigmoid[maxClassProbs + 128] * lut.sigmoid[box_confidence + 128]);
+                    classId.push_back(maxClassId);
+                    validCount++;
+                    boxes.push_back(box_x);
+                    boxes.push_back(box_y);
+                    boxes.push_back(box_w);
+                    boxes.push_back(box_h);
+                }
+            }
+        }
+        return validCount;
+    }
+
+    // NHWC布局：一个网格的3个anchor共3*PROP_BOX_SIZE个通道连续存放，cell_stride为相邻网格的间隔（含通道对齐）
+    static int process_nhwc(int8_t *input, int *anchor, int grid_h, int grid_w, int cell_stride, int stride,
+                            std::vector<float> &boxes, std::vector<float> &objProbs, std::vector<int> &classId,
+                            float threshold,
+                            int32_t zp, float scale, const DECODE_LUT &lut)
+    {
+        int validCount = 0;
+        float thres = unsigmoid(threshold);
+        int8_t thres_i8 = qnt_f32_to_affine(thres, zp, scale);
+        for (int i = 0; i < grid_h; i++)
+        {
+            for (int j = 0; j < grid_w; j++)
+            {
+                int8_t *cell_ptr = input + (i * grid_w + j) * cell_stride;
+                for (int a = 0; a < 3; a++)
+                {
+                    int8_t *in_ptr = cell_ptr + PROP_BOX_SIZE * a;
+                    int8_t box_confidence = in_ptr[4];
+                    if (box_confidence < thres_i8)
+                    {
+                        continue;
+                    }
+                    float box_x = lut.xy[in_ptr[0] + 128];
+                    float box_y = lut.xy[in_ptr[1] + 128];
+                    float box_w = lut.wh[in_ptr[2] + 128];
+                    float box_h = lut.wh[in_ptr[3] + 128];
+                    box_x = (box_x + j) * (float)stride;
+                    box_y = (box_y + i) * (float)stride;
+                    box_w = box_w * (float)anchor[a * 2];
+                    box_h = box_h * (float)anchor[a * 2 + 1];
+                    box_x -= (box_w / 2.0);
+                    box_y -= (box_h / 2.0);
+
+                    // 类别分数连续存放
+                    int8_t maxClassProbs = in_ptr[5];
+                    int maxClassId = 0;
+                    for (int k = 1; k < OBJ_CLASS_NUM; ++k)
+                    {
+                        int8_t prob = in_ptr[5 + k];
+                        if (prob > maxClassProbs)
                         {
-                            objProbs.push_back(sigmoid(deqnt_affine_to_f32(maxClassProbs, zp, scale)) *
-                                               sigmoid(deqnt_affine_to_f32(box_confidence, zp, scale)));
-                            classId.push_back(maxClassId);
-                            validCount++;
-                            boxes.push_back(box_x);
-                            boxes.push_back(box_y);
-                            boxes.push_back(box_w);
-                            boxes.push_back(box_h);
+                            maxClassId = k;
+                            maxClassProbs = prob;
                         }
                     }
+                    if (maxClassProbs > thres_i8)
+                    {
+                        objProbs.push_back(lut.sigmoid[maxClassProbs + 128] * lut.sigmoid[box_confidence + 128]);
+                        classId.push_back(maxClassId);
+                        validCount++;
+                        boxes.push_back(box_x);
+                        boxes.push_back(box_y);
+                        boxes.push_back(box_w);
+                        boxes.push_back(box_h);
+                    }
                 }
             }
         }
         return validCount;
     }
 
+    // 对所有候选框排序、按类别NMS，并输出到group
+    int finish_detections(int validCount, PostprocessContext &ctx, int model_in_h, int model_in_w,
+                          float nms_threshold, float scale_w, float scale_h, int top_k, detect_result_group_t *group)
+    {
+        std::vector<float> &filterBoxes = ctx.boxes;
+        std::vector<float> &objProbs = ctx.probs;
+        std::vector<int> &classId = ctx.class_ids;
+        // no object detect
+        if (validCount <= 0)
+        {
+            return 0;
+        }
+
+        auto by_prob = [](const NmsCandidate &a, const NmsCandidate &b)
+        { return a.prob > b.prob || (a.prob == b.prob && a.index < b.index); };
+
+        // 候选框过多时只保留置信度最高的top_k个（nth_element，线性时间），之后的排序和NMS规模有上限
+        std::vector<NmsCandidate> &top = ctx.top;
+        top.resize(validCount);
+        for (int i = 0; i < validCount; ++i)
+        {
+            top[i] = {objProbs[i], i};
+        }
+        if (top_k > 0 && validCount > top_k)
+        {
+            std::nth_element(top.begin(), top.begin() + top_k, top.end(), by_prob);
+            top.resize(top_k);
+        }
+        int cand_count = top.size();
+
+        // 一次遍历按类别分桶（计数排序），桶内按置信度排序
+        int bucket_start[OBJ_CLASS_NUM + 1] = {0};
+        for (int i = 0; i < cand_count; ++i)
+        {
+            bucket_start[classId[top[i].index] + 1]++;
+        }
+        for (int c = 0; c < OBJ_CLASS_NUM; c++)
+        {
+            bucket_start[c + 1] += bucket_start[c];
+        }
+        std::vector<NmsCandidate> &cands = ctx.cands;
+        cands.resize(cand_count);
+        int fill[OBJ_CLASS_NUM];
+        memcpy(fill, bucket_start, sizeof(fill));
+        for (int i = 0; i < cand_count; ++i)
+        {
+            cands[fill[classId[top[i].index]]++] = top[i];
+        }
+
+        // 每个桶单独NMS，任何一个类别最多输出OBJ_NUMB_MAX_SIZE个，达到后不再比较
+        std::vector<NmsCandidate> &kept = ctx.kept;
+        kept.resize(cand_count);
+        int kept_count = 0;
+        for (int c = 0; c < OBJ_CLASS_NUM; c++)
+        {
+            int count = bucket_start[c + 1] - bucket_start[c];
+            if (count == 0)
+            {
+                continue;
+            }
+            NmsCandidate *bucket = cands.data() + bucket_start[c];
+            std::sort(bucket, bucket + count, by_prob);
+            kept_count += nms_bucket(bucket, count, filterBoxes, nms_threshold, OBJ_NUMB_MAX_SIZE,
+                                     kept.data() + kept_count);
+        }
+        // 所有类别保留的框按置信度排序，输出前OBJ_NUMB_MAX_SIZE个
+        int out_count = std::min(kept_count, OBJ_NUMB_MAX_SIZE);
+        std::partial_sort(kept.begin(), kept.begin() + out_count, kept.begin() + kept_count, by_prob);
+
+        int last_count = 0;
+        group->count = 0;
+        /* box valid detect target */
+        for (int i = 0; i < out_count; ++i)
+        {
+            int n = kept[i].index;
+
+            float x1 = filterBoxes[n * 4 + 0];
+            float y1 = filterBoxes[n * 4 + 1];
+            float x2 = x1 + filterBoxes[n * 4 + 2];
+            float y2 = y1 + filterBoxes[n * 4 + 3];
+            int id = classId[n];
+            float obj_conf = kept[i].prob;
+
+            // 在模型输入坐标上截断会放大为原图上1/scale个像素的误差，缩放回原图后再取整
+            group->results[last_count].box.left = (int)lroundf(clamp(x1, 0, model_in_w) / scale_w);
+            group->results[last_count].box.top = (int)lroundf(clamp(y1, 0, model_in_h) / scale_h);
+            group->results[last_count].box.right = (int)lroundf(clamp(x2, 0, model_in_w) / scale_w);
+            group->results[last_count].box.bottom = (int)lroundf(clamp(y2, 0, model_in_h) / scale_h);
+            group->results[last_count].prop = obj_conf;
+            group->results[last_count].id = id;
+            const char *label = labels[id];
+            strncpy(group->results[last_count].name, label, OBJ_NAME_MAX_SIZE);
+
+            // printf("result %2d: (%4d, %4d, %4d, %4d), %s\n", i, group->results[last_count].box.left,
+            // group->results[last_count].box.top,
+            //        group->results[last_count].box.right, group->results[last_count].box.bottom, label);
+            last_count++;
+        }
+        group->count = last_count;
+
+        return 0;
+    }
+
     int
     post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w, float conf_threshold,
                  float nms_threshold, float scale_w, float scale_h, std::vector<int32_t> &qnt_zps,
-                 std::vector<float> &qnt_scales, detect_result_group_t *group)
+                 std::vector<float> &qnt_scales, const DECODE_LUT luts[3], const GRID_SIZE grids[3],
+                 detect_result_group_t *group, int top_k, PostprocessContext *ctx)
     {
         static int init = -1;
         if (init == -1)
@@ -292,93 +525,111 @@ namespace yolov5
         }
         memset(group, 0, sizeof(detect_result_group_t));
 
-        std::vector<float> filterBoxes;
-        std::vector<float> objProbs;
-        std::vector<int> classId;
+        // 没有传入上下文时使用临时的，每次都会分配内存
+        PostprocessContext local_context;
+        PostprocessContext &context = ctx != nullptr ? *ctx : local_context;
+        context.Clear();
+        std::vector<float> &filterBoxes = context.boxes;
+        std::vector<float> &objProbs = context.probs;
+        std::vector<int> &classId = context.class_ids;
 
         // stride 8
         int stride0 = 8;
-        int grid_h0 = model_in_h / stride0;
-        int grid_w0 = model_in_w / stride0;
+        int grid_h0 = grids[0].h;
+        int grid_w0 = grids[0].w;
         int validCount0 = 0;
-        validCount0 = process(input0, (int *)anchor0, grid_h0, grid_w0, model_in_h, model_in_w, stride0, filterBoxes,
+        validCount0 = process(input0, (int *)anchor0, grid_h0, grid_w0, stride0, filterBoxes,
                               objProbs,
-                              classId, conf_threshold, qnt_zps[0], qnt_scales[0]);
+                              classId, conf_threshold, qnt_zps[0], qnt_scales[0], luts[0], context.cells);
 
         // stride 16
         int stride1 = 16;
-        int grid_h1 = model_in_h / stride1;
-        int grid_w1 = model_in_w / stride1;
+        int grid_h1 = grids[1].h;
+        int grid_w1 = grids[1].w;
         int validCount1 = 0;
-        validCount1 = process(input1, (int *)anchor1, grid_h1, grid_w1, model_in_h, model_in_w, stride1, filterBoxes,
+        validCount1 = process(input1, (int *)anchor1, grid_h1, grid_w1, stride1, filterBoxes,
                               objProbs,
-                              classId, conf_threshold, qnt_zps[1], qnt_scales[1]);
+                              classId, conf_threshold, qnt_zps[1], qnt_scales[1], luts[1], context.cells);
 
         // stride 32
         int stride2 = 32;
-        int grid_h2 = model_in_h / stride2;
-        int grid_w2 = model_in_w / stride2;
+        int grid_h2 = grids[2].h;
+        int grid_w2 = grids[2].w;
         int validCount2 = 0;
-        validCount2 = process(input2, (int *)anchor2, grid_h2, grid_w2, model_in_h, model_in_w, stride2, filterBoxes,
+        validCount2 = process(input2, (int *)anchor2, grid_h2, grid_w2, stride2, filterBoxes,
                               objProbs,
-                              classId, conf_threshold, qnt_zps[2], qnt_scales[2]);
+                              classId, conf_threshold, qnt_zps[2], qnt_scales[2], luts[2], context.cells);
 
         int validCount = validCount0 + validCount1 + validCount2;
-        // no object detect
-        if (validCount <= 0)
-        {
-            return 0;
-        }
-
-        std::vector<int> indexArray;
-        for (int i = 0; i < validCount; ++i)
-        {
-            indexArray.push_back(i);
-        }
+        return finish_detections(validCount, context, model_in_h, model_in_w, nms_threshold, scale_w, scale_h, top_k,
+                                 group);
+    }
 
-        quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
+    /**
+     * @brief NHWC布局输出的后处理，每个网格的通道连续存放，其余和post_process相同
+     * @param cell_strides 每个输出相邻网格的间隔（字节），包含通道对齐
+     */
+    int
+    post_process_nhwc(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w,
+                      float conf_threshold, float nms_threshold, float scale_w, float scale_h,
+                      std::vector<int32_t> &qnt_zps, std::vector<float> &qnt_scales, const DECODE_LUT luts[3],
+                      std::vector<int> &cell_strides, const GRID_SIZE grids[3], detect_result_group_t *group,
+                      int top_k, PostprocessContext *ctx)
+    {
+        memset(group, 0, sizeof(detect_result_group_t));
 
-        std::set<int> class_set(std::begin(classId), std::end(classId));
+        // 没有传入上下文时使用临时的，每次都会分配内存
+        PostprocessContext local_context;
+        PostprocessContext &context = ctx != nullptr ? *ctx : local_context;
+        context.Clear();
+        std::vector<float> &filterBoxes = context.boxes;
+        std::vector<float> &objProbs = context.probs;
+        std::vector<int> &classId = context.class_ids;
 
-        for (auto c : class_set)
+        int8_t *inputs[3] = {input0, input1, input2};
+        const int *anchors[3] = {anchor0, anchor1, anchor2};
+        int validCount = 0;
+        for (int i = 0; i < 3; i++)
         {
-            nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
+            // stride 8, 16, 32
+            int stride = 8 << i;
+            validCount += process_nhwc(inputs[i], (int *)anchors[i], grids[i].h, grids[i].w,
+                                       cell_strides[i], stride, filterBoxes, objProbs, classId, conf_threshold,
+                                       qnt_zps[i], qnt_scales[i], luts[i]);
         }
+        return finish_detections(validCount, context, model_in_h, model_in_w, nms_threshold, scale_w, scale_h, top_k,
+                                 group);
+    }
 
-        int last_count = 0;
-        group->count = 0;
-        /* box valid detect target */
-        for (int i = 0; i < validCount; ++i)
+    /**
+     * @brief 按输出网格预分配候选框缓冲区：候选框最多为每个网格3个anchor
+     * @param grids 每个输出的网格尺寸（动态输入模型为最大形状的网格）
+     */
+    void PostprocessContext::Reserve(const GRID_SIZE grids[3])
+    {
+        size_t max_cells = 0;
+        size_t max_candidates = 0;
+        for (int i = 0; i < 3; i++)
         {
-            if (indexArray[i] == -1 || last_count >= OBJ_NUMB_MAX_SIZE)
-            {
-                continue;
-            }
-            int n = indexArray[i];
-
-            float x1 = filterBoxes[n * 4 + 0];
-            float y1 = filterBoxes[n * 4 + 1];
-            float x2 = x1 + filterBoxes[n * 4 + 2];
-            float y2 = y1 + filterBoxes[n * 4 + 3];
-            int id = classId[n];
-            float obj_conf = objProbs[i];
-
-            group->results[last_count].box.left = (int)(clamp(x1, 0, model_in_w) / scale_w);
-            group->results[last_count].box.top = (int)(clamp(y1, 0, model_in_h) / scale_h);
-            group->results[last_count].box.right = (int)(clamp(x2, 0, model_in_w) / scale_w);
-            group->results[last_count].box.bottom = (int)(clamp(y2, 0, model_in_h) / scale_h);
-            group->results[last_count].prop = obj_conf;
-            const char *label = labels[id];
-            strncpy(group->results[last_count].name, label, OBJ_NAME_MAX_SIZE);
-
-            // printf("result %2d: (%4d, %4d, %4d, %4d), %s\n", i, group->results[last_count].box.left,
-            // group->results[last_count].box.top,
-            //        group->results[last_count].box.right, group->results[last_count].box.bottom, label);
-            last_count++;
+            size_t cells = (size_t)grids[i].h * grids[i].w;
+            max_cells = std::max(max_cells, cells);
+            max_candidates += cells * 3;
         }
-        group->count = last_count;
+        boxes.reserve(max_candidates * 4);
+        probs.reserve(max_candidates);
+        class_ids.reserve(max_candidates);
+        cells.reserve(max_cells);
+        top.reserve(max_candidates);
+        cands.reserve(max_candidates);
+        kept.reserve(max_candidates);
+    }
 
-        return 0;
+    // 清空上一帧的候选框，保留容量
+    void PostprocessContext::Clear()
+    {
+        boxes.clear();
+        probs.clear();
+        class_ids.clear();
     }
 
     void deinitPostProcess()
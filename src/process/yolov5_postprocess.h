@@ -10,6 +10,7 @@
 #define NMS_THRESH        0.45
 #define BOX_THRESH        0.45
 #define PROP_BOX_SIZE     (5+OBJ_CLASS_NUM)
+#define PRE_NMS_TOP_K     1000 // NMS前最多保留的候选框数量，<=0表示不限制
 
 namespace yolov5 {
 
@@ -20,6 +21,12 @@ namespace yolov5 {
         int bottom;
     } BOX_RECT;
 
+    // 一个输出的网格尺寸，取自当前的输出张量属性
+    typedef struct _GRID_SIZE {
+        int h;
+        int w;
+    } GRID_SIZE;
+
     typedef struct __detect_result_t {
         char name[OBJ_NAME_MAX_SIZE];
         BOX_RECT box;
@@ -27,16 +34,67 @@ namespace yolov5 {
         float prop;
     } detect_result_t;
 
+    // 一个输出张量的解码查找表，下标为int8值+128；只由zp/scale决定，模型加载后计算一次
+    typedef struct _DECODE_LUT {
+        float sigmoid[256]; // σ(x)，用于置信度
+        float xy[256];      // 2σ(x) - 0.5，用于框中心
+        float wh[256];      // (2σ(x))^2，乘以anchor得到框宽高
+    } DECODE_LUT;
+
     typedef struct _detect_result_group_t {
         int id;
         int count;
         detect_result_t results[OBJ_NUMB_MAX_SIZE];
     } detect_result_group_t;
 
+    // NMS的一个候选框；按类别分桶后，桶内按置信度从高到低排列，置信度相同时按下标，保证结果稳定
+    struct NmsCandidate
+    {
+        float prob;
+        int index; // 在候选框数组中的下标
+    };
+
+    // 后处理的候选框缓冲区（SoA），每个Yolov5实例持有一个，不能在线程间共享
+    // 按最坏情况（每个网格3个候选框）预分配后，解码和NMS不再分配内存
+    class PostprocessContext
+    {
+    public:
+        void Reserve(const GRID_SIZE grids[3]); // 按输出网格预分配
+        void Clear();                           // 清空上一帧的候选框，保留容量
+
+        std::vector<float> boxes;      // 每个候选框的x, y, w, h
+        std::vector<float> probs;      // 置信度
+        std::vector<int> class_ids;    // 类别
+        std::vector<int> cells;        // 预筛选出的网格下标
+        std::vector<NmsCandidate> top;   // top-K筛选
+        std::vector<NmsCandidate> cands; // 按类别分桶
+        std::vector<NmsCandidate> kept;  // NMS保留的候选框
+    };
+
+    void build_decode_lut(int32_t zp, float scale, DECODE_LUT *lut); // 按量化参数计算解码查找表
+
+    // NCHW输出的预筛选：找出objectness不低于thres的网格，indices至少n个，返回候选数量
+    int prescan_objectness(const int8_t *conf, int n, int8_t thres, int *indices);
+    void postprocess_enable_simd(bool enable); // 是否使用NEON/SSE2实现，关闭后只用标量实现（测试、性能对比）
+
+    // grids为每个输出的网格尺寸，动态输入模型下随输入形状变化；luts为每个输出的解码查找表
+    // top_k为NMS前保留的候选框数量上限，拥挤画面下后处理耗时不会失控；ctx为空时每次临时分配缓冲区
     int post_process(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w,
                      float conf_threshold, float nms_threshold, float scale_w, float scale_h,
-                     std::vector<int32_t> &qnt_zps, std::vector<float> &qnt_scales,
-                     detect_result_group_t *group);
+                     std::vector<int32_t> &qnt_zps, std::vector<float> &qnt_scales, const DECODE_LUT luts[3],
+                     const GRID_SIZE grids[3], detect_result_group_t *group, int top_k = PRE_NMS_TOP_K,
+                     PostprocessContext *ctx = nullptr);
+
+    // 解码之后的步骤：ctx中的validCount个候选框经过top-K筛选、按类别NMS，缩放回原图后输出到group
+    int finish_detections(int validCount, PostprocessContext &ctx, int model_in_h, int model_in_w,
+                          float nms_threshold, float scale_w, float scale_h, int top_k, detect_result_group_t *group);
+
+    // 输出为NHWC布局时使用，cell_strides为每个输出相邻网格的间隔（字节）
+    int post_process_nhwc(int8_t *input0, int8_t *input1, int8_t *input2, int model_in_h, int model_in_w,
+                          float conf_threshold, float nms_threshold, float scale_w, float scale_h,
+                          std::vector<int32_t> &qnt_zps, std::vector<float> &qnt_scales, const DECODE_LUT luts[3],
+                          std::vector<int> &cell_strides, const GRID_SIZE grids[3], detect_result_group_t *group,
+                          int top_k = PRE_NMS_TOP_K, PostprocessContext *ctx = nullptr);
 
     void deinitPostProcess();
 }
@@ -1,14 +1,19 @@
 
 #include "yolov5.h"
 
+#include <math.h>
+
+#include <algorithm>
 #include <memory>
 #include <fstream>
+#include <iostream>
 #include <chrono>
 #include <thread>
 
 #include "utils/logging.h"
 #include "process/preprocess.h"
 #include "process/yolov5_postprocess.h"
+#include "process/tiling.h"
 
 #include <ctime>
 
@@ -28,7 +33,7 @@ void DetectionGrp2DetectionArray(yolov5::detect_result_group_t &det_grp, std::ve
                            det_grp.results[i].box.bottom - det_grp.results[i].box.top);
 
         det.confidence = det_grp.results[i].prop;
-        det.class_id = 0;
+        det.class_id = det_grp.results[i].id;
         // generate random cv::Scalar color
         det.color = cv::Scalar(rand() % 255, rand() % 255, rand() % 255);
         objects.push_back(det);
@@ -36,14 +41,42 @@ void DetectionGrp2DetectionArray(yolov5::detect_result_group_t &det_grp, std::ve
 }
 
 // 构造函数
-Yolov5::Yolov5()
+Yolov5::Yolov5(const Yolov5Config &config)
+    : config_(config), zero_copy_(false), output_nhwc_(false), dynamic_shape_index_(-1), last_src_w_(0), last_src_h_(0),
+      async_buffer_index_(0), inflight_valid_(false), tiles_run_(0), tile_busy_us_(0)
 {
-    engine_ = CreateRKNNEngine();
+    switch (config_.backend)
+    {
+    case NN_BACKEND_REPLAY:
+        engine_ = CreateReplayEngine(config_.replay_latency_us);
+        break;
+    case NN_BACKEND_OPENCV_DNN:
+        engine_ = CreateOpenCVDnnEngine(config_.dnn_input_width, config_.dnn_input_height);
+        break;
+    default:
+        engine_ = CreateRKNNEngine();
+        break;
+    }
     input_tensor_.data = nullptr;
+    async_buffers_[0] = nullptr;
+    async_buffers_[1] = nullptr;
 }
 // 析构函数
 Yolov5::~Yolov5()
 {
+    // 在途的推理可能还在读取输入内存，先等它结束
+    if (inflight_valid_)
+    {
+        engine_->Wait(inflight_.handle, output_tensors_);
+        inflight_valid_ = false;
+    }
+    free(async_buffers_[0]);
+    free(async_buffers_[1]);
+    // 零拷贝模式下内存由引擎释放
+    if (zero_copy_)
+    {
+        return;
+    }
     if (input_tensor_.data != nullptr)
     {
         free(input_tensor_.data);
@@ -59,12 +92,89 @@ Yolov5::~Yolov5()
 // 加载模型，获取输入输出属性
 nn_error_e Yolov5::LoadModel(const char *model_path)
 {
+    if (engine_ == nullptr)
+    {
+        NN_LOG_ERROR("yolo engine not available for backend %d", config_.backend);
+        return NN_NOT_SUPPORTED;
+    }
+    if (config_.async_inference && engine_->SetAsyncMode(true) != NN_SUCCESS)
+    {
+        NN_LOG_INFO("yolo engine has no native async mode, use helper thread");
+    }
+    if (!config_.profile_report.empty() && engine_->EnableProfiling(config_.profile_report.c_str()) != NN_SUCCESS)
+    {
+        NN_LOG_WARNING("yolo engine does not support profiling");
+    }
     auto ret = engine_->LoadModelFile(model_path);
     if (ret != NN_SUCCESS)
     {
         NN_LOG_ERROR("yolo load model file failed");
         return ret;
     }
+    ret = InitTensors();
+    if (ret != NN_SUCCESS)
+    {
+        return ret;
+    }
+    EnableCapture();
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 复用另一个实例已加载的模型：通过引擎的Clone共享权重，不再重新读取模型文件
+ * @param source 已经加载好模型的实例
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::ShareModel(Yolov5 &source)
+{
+    if (source.engine_ == nullptr)
+    {
+        return NN_NOT_SUPPORTED;
+    }
+    std::shared_ptr<NNEngine> engine;
+    auto ret = source.engine_->Clone(engine);
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("yolo share model failed, ret=%d", ret);
+        return ret;
+    }
+    engine_ = engine;
+    if (!config_.profile_report.empty() && engine_->EnableProfiling(config_.profile_report.c_str()) != NN_SUCCESS)
+    {
+        NN_LOG_WARNING("yolo shared engine can not be profiled, source was loaded without profiling");
+    }
+    ret = InitTensors();
+    if (ret != NN_SUCCESS)
+    {
+        return ret;
+    }
+    EnableCapture();
+    return NN_SUCCESS;
+}
+
+// 按配置录制推理输出，需要在输入输出形状确定之后开启
+void Yolov5::EnableCapture()
+{
+    if (!config_.capture_path.empty() && engine_->EnableCapture(config_.capture_path.c_str()) != NN_SUCCESS)
+    {
+        NN_LOG_WARNING("yolo engine can not capture outputs");
+    }
+}
+
+// 模型权重大小
+uint64_t Yolov5::GetWeightSize()
+{
+    return engine_->GetWeightSize();
+}
+
+// 根据引擎的输入输出属性分配张量，并应用核心绑定、零拷贝等选项
+nn_error_e Yolov5::InitTensors()
+{
+    // 动态输入模型先切换到最大的形状，输入输出内存按最大形状分配，之后切换形状时复用
+    if (config_.dynamic_input)
+    {
+        InitDynamicShapes();
+    }
     // get input tensor
     auto input_shapes = engine_->GetInputShapes();
 
@@ -77,14 +187,17 @@ nn_error_e Yolov5::LoadModel(const char *model_path)
     nn_tensor_attr_to_cvimg_input_data(input_shapes[0], input_tensor_);
     input_tensor_.data = malloc(input_tensor_.attr.size);
 
+    // 原生布局的输出只能通过零拷贝读取
+    bool native_output = config_.native_output_layout && config_.zero_copy &&
+                         engine_->SetNativeOutputLayout(true) == NN_SUCCESS;
     auto output_shapes = engine_->GetOutputShapes();
 
-    for (int i = 0; i < output_shapes.size(); i++)
+    for (size_t i = 0; i < output_shapes.size(); i++)
     {
         tensor_data_s tensor;
         tensor.attr.n_elems = output_shapes[i].n_elems;
         tensor.attr.n_dims = output_shapes[i].n_dims;
-        for (int j = 0; j < output_shapes[i].n_dims; j++)
+        for (uint32_t j = 0; j < output_shapes[i].n_dims; j++)
         {
             tensor.attr.dims[j] = output_shapes[i].dims[j];
         }
@@ -101,13 +214,265 @@ nn_error_e Yolov5::LoadModel(const char *model_path)
         output_tensors_.push_back(tensor);
         out_zps_.push_back(output_shapes[i].zp);
         out_scales_.push_back(output_shapes[i].scale);
+        // 量化参数在模型加载后不再变化，解码查找表只计算一次
+        yolov5::DECODE_LUT lut;
+        yolov5::build_decode_lut(output_shapes[i].zp, output_shapes[i].scale, &lut);
+        out_luts_.push_back(lut);
+    }
+
+    if (config_.core_mask != NN_NPU_CORE_AUTO)
+    {
+        engine_->SetCoreMask(config_.core_mask);
+    }
+    if (input_tensor_.attr.dims[0] > 1)
+    {
+        NN_LOG_INFO("yolo batch model, batch size: %d", input_tensor_.attr.dims[0]);
+        if (config_.batch_core_num > 0)
+        {
+            engine_->SetBatchCoreNum(config_.batch_core_num);
+        }
+    }
+    if (config_.zero_copy)
+    {
+        EnableZeroCopy();
+    }
+    if (native_output && !zero_copy_)
+    {
+        // 零拷贝开启失败，回到NCHW输出
+        engine_->SetNativeOutputLayout(false);
+        native_output = false;
+    }
+    if (native_output)
+    {
+        output_nhwc_ = true;
+        for (auto &shape : engine_->GetOutputShapes())
+        {
+            // dims为[1, H, W, C]，size包含通道对齐
+            out_cell_strides_.push_back(shape.size / nn_tensor_type_to_size(shape.type) / (shape.dims[1] * shape.dims[2]));
+        }
+        NN_LOG_INFO("yolo native nhwc output enabled");
     }
+    UpdateOutputGrids();
+    // 动态输入模型此时是最大的形状，之后切换形状不需要扩容
+    postprocess_ctx_.Reserve(out_grids_);
+    if (config_.prealloc_outputs && !zero_copy_)
+    {
+        engine_->SetOutputPrealloc(true);
+    }
+    inputs_.resize(1);
     return NN_SUCCESS;
 }
 
+// 从形状中取出高和宽
+static void shape_hw(const tensor_attr_s &shape, int &h, int &w)
+{
+    if (shape.layout == NN_TENSOR_NHWC)
+    {
+        h = shape.dims[1];
+        w = shape.dims[2];
+    }
+    else
+    {
+        h = shape.dims[2];
+        w = shape.dims[3];
+    }
+}
+
+// 动态输入模型：获取支持的输入形状，并切换到最大的形状
+void Yolov5::InitDynamicShapes()
+{
+    dynamic_shapes_.clear();
+    if (config_.zero_copy)
+    {
+        NN_LOG_WARNING("yolo dynamic input is not supported with zero copy, use fixed shape");
+        return;
+    }
+    if (engine_->GetDynamicInputShapes(0, dynamic_shapes_) != NN_SUCCESS || dynamic_shapes_.empty())
+    {
+        NN_LOG_INFO("yolo model has no dynamic input shapes, use fixed shape");
+        dynamic_shapes_.clear();
+        return;
+    }
+    int largest = 0;
+    for (size_t i = 0; i < dynamic_shapes_.size(); i++)
+    {
+        int h, w;
+        shape_hw(dynamic_shapes_[i], h, w);
+        NN_LOG_INFO("yolo dynamic input shape %ld: %dx%d", i, w, h);
+        if (dynamic_shapes_[i].n_elems > dynamic_shapes_[largest].n_elems)
+        {
+            largest = i;
+        }
+    }
+    if (engine_->SetInputShapes({dynamic_shapes_[largest]}) != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("yolo set dynamic input shape failed, use fixed shape");
+        dynamic_shapes_.clear();
+        return;
+    }
+    dynamic_shape_index_ = largest;
+}
+
+/**
+ * @brief 动态输入模型：为原图选择letterbox padding最少的输入形状，padding相近时选能放下原图的最小形状，
+ *        都放不下时选最大的形状；原图尺寸不变时不重新选择
+ * @param src_width 原图宽度
+ * @param src_height 原图高度
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::SelectInputShape(int src_width, int src_height)
+{
+    if (src_width == last_src_w_ && src_height == last_src_h_)
+    {
+        return NN_SUCCESS;
+    }
+    last_src_w_ = src_width;
+    last_src_h_ = src_height;
+
+    const float pad_tolerance = 0.02f; // padding占比相差在此范围内视为相同
+    int best = -1;
+    float best_pad = 0;
+    bool best_covers = false;
+    for (size_t i = 0; i < dynamic_shapes_.size(); i++)
+    {
+        int h, w;
+        shape_hw(dynamic_shapes_[i], h, w);
+        float scale = std::min((float)w / src_width, (float)h / src_height);
+        float pad = 1.f - (src_width * scale) * (src_height * scale) / ((float)w * h);
+        bool covers = w >= src_width && h >= src_height;
+        bool better = false;
+        if (best < 0 || pad < best_pad - pad_tolerance)
+        {
+            better = true;
+        }
+        else if (pad <= best_pad + pad_tolerance)
+        {
+            uint32_t area = dynamic_shapes_[i].n_elems;
+            uint32_t best_area = dynamic_shapes_[best].n_elems;
+            better = (covers && (!best_covers || area < best_area)) || (!covers && !best_covers && area > best_area);
+        }
+        if (better)
+        {
+            best = i;
+            best_pad = pad;
+            best_covers = covers;
+        }
+    }
+    if (best == dynamic_shape_index_)
+    {
+        return NN_SUCCESS;
+    }
+    auto ret = engine_->SetInputShapes({dynamic_shapes_[best]});
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("yolo set dynamic input shape failed, ret=%d", ret);
+        return ret;
+    }
+    dynamic_shape_index_ = best;
+
+    // 内存按最大形状分配，这里只更新形状
+    nn_tensor_attr_to_cvimg_input_data(engine_->GetInputShapes()[0], input_tensor_);
+    auto &output_shapes = engine_->GetOutputShapes();
+    for (size_t i = 0; i < output_tensors_.size(); i++)
+    {
+        output_tensors_[i].attr.n_dims = output_shapes[i].n_dims;
+        for (uint32_t j = 0; j < output_shapes[i].n_dims; j++)
+        {
+            output_tensors_[i].attr.dims[j] = output_shapes[i].dims[j];
+        }
+        output_tensors_[i].attr.n_elems = output_shapes[i].n_elems;
+    }
+    UpdateOutputGrids();
+    NN_LOG_INFO("yolo input shape %dx%d for source %dx%d, padding %.1f%%", input_tensor_.attr.dims[2],
+                input_tensor_.attr.dims[1], src_width, src_height, best_pad * 100);
+    return NN_SUCCESS;
+}
+
+// 根据当前的输出属性更新每个输出的网格尺寸
+void Yolov5::UpdateOutputGrids()
+{
+    auto &output_shapes = engine_->GetOutputShapes();
+    for (size_t i = 0; i < output_shapes.size() && i < 3; i++)
+    {
+        shape_hw(output_shapes[i], out_grids_[i].h, out_grids_[i].w);
+    }
+}
+
+// 开启零拷贝：input_tensor_和output_tensors_改为指向引擎绑定的内存，失败时保持拷贝模式
+nn_error_e Yolov5::EnableZeroCopy()
+{
+    auto ret = engine_->EnableZeroCopy(nullptr);
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_WARNING("yolo zero copy not available, ret=%d, fallback to copy mode", ret);
+        return ret;
+    }
+    auto zero_copy_io = engine_->GetZeroCopyIO();
+    auto &zc_inputs = zero_copy_io->Inputs();
+    auto &zc_outputs = zero_copy_io->Outputs();
+    if (zc_inputs[0].attr.size < input_tensor_.attr.size || zc_outputs.size() != output_tensors_.size())
+    {
+        NN_LOG_WARNING("yolo zero copy io not match, fallback to copy mode");
+        return NN_RKNN_INPUT_ATTR_ERROR;
+    }
+    free(input_tensor_.data);
+    input_tensor_.data = zc_inputs[0].data;
+    for (size_t i = 0; i < output_tensors_.size(); i++)
+    {
+        free(output_tensors_[i].data);
+        output_tensors_[i].data = zc_outputs[i].data;
+    }
+    zero_copy_ = true;
+    NN_LOG_INFO("yolo zero copy enabled");
+    if (config_.async_inference)
+    {
+        // 只绑定了一块输入内存，在途推理还在读取它，RunAsync只能预处理到两块中转内存后再拷贝进去
+        NN_LOG_WARNING("yolo zero copy with async inference: RunAsync inputs are copied into the bound memory, "
+                       "only outputs are zero copy");
+    }
+    return NN_SUCCESS;
+}
+
+// 第一次使用rga预处理时创建；零拷贝的输入内存是dma-buf时登记给预处理，RGA直接写入NPU输入，不再经过中转内存和拷贝
+void Yolov5::InitImageProcessor()
+{
+    if (image_processor_ != nullptr)
+    {
+        return;
+    }
+    image_processor_ = CreateImageProcessor(true, config_.rga_import_src);
+    NN_LOG_INFO("yolo preprocessing: %s", image_processor_->Name());
+    if (zero_copy_)
+    {
+        const tensor_mem_s &mem = engine_->GetZeroCopyIO()->InputMems()[0];
+        if (mem.fd >= 0)
+        {
+            image_processor_->SetTensorDma(mem.fd, mem.virt_addr, mem.size);
+        }
+    }
+}
+
+// 批量模型的输入为[N, H, W, C]，取出第batch_index张图像的一段
+tensor_data_s Yolov5::InputSlice(int batch_index)
+{
+    int batch = input_tensor_.attr.dims[0];
+    tensor_data_s input_slice = input_tensor_;
+    input_slice.attr.dims[0] = 1;
+    input_slice.attr.n_elems /= batch;
+    input_slice.attr.size /= batch;
+    input_slice.data = (uint8_t *)input_tensor_.data + input_slice.attr.size * batch_index;
+    return input_slice;
+}
+
 // 图像预处理
-nn_error_e Yolov5::Preprocess(const cv::Mat &img, const std::string process_type, cv::Mat &image_letterbox)
+nn_error_e Yolov5::Preprocess(const cv::Mat &img, const std::string process_type, int batch_index)
 {
+    if (img.empty() || img.type() != CV_8UC3)
+    {
+        NN_LOG_ERROR("yolo input image is empty or not BGR");
+        return NN_IMG_INPUT_ERROR;
+    }
+    tensor_data_s input_slice = InputSlice(batch_index);
 
     // 预处理包含：letterbox、归一化、BGR2RGB、NCWH
     // 其中RKNN会做：归一化、NCWH转换（详见课程文档），所以这里只需要做letterbox、BGR2RGB
@@ -116,35 +481,89 @@ nn_error_e Yolov5::Preprocess(const cv::Mat &img, const std::string process_type
     float wh_ratio = (float)input_tensor_.attr.dims[2] / (float)input_tensor_.attr.dims[1];
 
     // lettorbox
-
-    if (process_type == "opencv")
+    uint32_t width = input_tensor_.attr.dims[2];
+    uint32_t height = input_tensor_.attr.dims[1];
+    bool resize_pad = config_.letterbox_mode == LETTERBOX_RESIZE_PAD;
+    // 先补边方式的中间图像，引用scratch_中复用的缓冲区
+    cv::Mat image_letterbox;
+    if (process_type == "fused")
     {
-        // BGR2RGB，resize，再放入input_tensor_中
-        letterbox_info_ = letterbox(img, image_letterbox, wh_ratio);
-        cvimg2tensor(image_letterbox, input_tensor_.attr.dims[2], input_tensor_.attr.dims[1], input_tensor_);
+        // padding、resize、BGR2RGB一次完成，直接写入input_tensor_，不生成letterbox图像
+        letterbox_info_ = letterbox_fused(img, width, height, input_slice, config_.letterbox_mode, &scratch_);
+    }
+    else if (process_type == "opencv")
+    {
+        if (resize_pad)
+        {
+            // 只缩放原图内容，直接写入input_tensor_的子区域
+            letterbox_info_ = letterbox_resize(img, width, height, input_slice);
+        }
+        else
+        {
+            // BGR2RGB，resize，再放入input_tensor_中
+            letterbox(img, image_letterbox, wh_ratio, &scratch_);
+            cvimg2tensor(image_letterbox, width, height, input_slice, &scratch_);
+            letterbox_info_ = letterbox_info(img.cols, img.rows, width, height, LETTERBOX_PAD_RESIZE);
+        }
     }
     else if (process_type == "rga")
     {
-        // rga resize
-        letterbox_info_ = letterbox_rga(img, image_letterbox, wh_ratio);
-        // save img
-        // cv::imwrite("rga.jpg", image_letterbox);
-        cvimg2tensor_rga(image_letterbox, input_tensor_.attr.dims[2], input_tensor_.attr.dims[1], input_tensor_);
+        if (resize_pad)
+        {
+            // RGA一次完成转RGB、缩放，零拷贝时直接写入NPU输入内存；没有RGA时使用CPU实现
+            InitImageProcessor();
+            auto ret = image_processor_->Letterbox(img, width, height, input_slice, letterbox_info_);
+            if (ret != NN_SUCCESS)
+            {
+                return ret;
+            }
+        }
+        else
+        {
+            // rga resize
+            letterbox_rga(img, image_letterbox, wh_ratio, &scratch_);
+            // save img
+            // cv::imwrite("rga.jpg", image_letterbox);
+            cvimg2tensor_rga(image_letterbox, width, height, input_slice);
+            letterbox_info_ = letterbox_info(img.cols, img.rows, width, height, LETTERBOX_PAD_RESIZE);
+        }
     }
-   
 
     return NN_SUCCESS;
 }
 
+/**
+ * @brief 解码器输出的YUV420帧预处理：颜色转换、缩放和letterbox一次完成，不经过BGR图像
+ * @param frame YUV420帧（NV12或I420）
+ * @param batch_index 写入批量输入中的第batch_index张
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::PreprocessYuv(const yuv_frame_s &frame, int batch_index)
+{
+    tensor_data_s input_slice = InputSlice(batch_index);
+    uint32_t width = input_tensor_.attr.dims[2];
+    uint32_t height = input_tensor_.attr.dims[1];
+    if (config_.letterbox_mode != LETTERBOX_RESIZE_PAD)
+    {
+        NN_LOG_WARNING("yolo yuv input only supports resize-pad letterbox");
+    }
+    if (config_.rga_preprocess)
+    {
+        // 有dma-buf fd时RGA直接读取解码器的输出
+        InitImageProcessor();
+        return image_processor_->LetterboxYuv(frame, width, height, input_slice, letterbox_info_);
+    }
+    letterbox_info_ = letterbox_fused_yuv(frame, width, height, input_slice, &scratch_);
+    return NN_SUCCESS;
+}
+
 // 推理
 nn_error_e Yolov5::Inference()
 {
-    std::vector<tensor_data_s> inputs;
-    // 将input_tensor_放入inputs中
-    inputs.push_back(input_tensor_);
+    // 将input_tensor_放入inputs_中
+    inputs_[0] = input_tensor_;
     // 运行模型
-    engine_->Run(inputs, output_tensors_, false);
-    return NN_SUCCESS;
+    return engine_->Run(inputs_, output_tensors_, false);
 }
 
 //保存车辆数量
@@ -161,16 +580,195 @@ void SaveDetectionCountToFile(int total_detections) {
 // 运行模型
 nn_error_e Yolov5::Run(const cv::Mat &img, std::vector<Detection> &objects)
 {
-    // letterbox后的图像
-    cv::Mat image_letterbox;
-    // 预处理，支持opencv或rga
-    Preprocess(img, "opencv", image_letterbox);
-    // Preprocess(img, "rga", image_letterbox);
-    // 推理
-    Inference();
+    if (config_.tiled)
+    {
+        return RunTiled(img, objects);
+    }
+    if (!dynamic_shapes_.empty())
+    {
+        SelectInputShape(img.cols, img.rows);
+    }
+    // 预处理，支持fused、opencv或rga
+    auto ret = Preprocess(img, config_.rga_preprocess ? "rga" : "fused");
+    if (ret != NN_SUCCESS)
+    {
+        return ret;
+    }
+    // 推理，失败时输出张量还是上一帧的结果，不能再做后处理
+    ret = Inference();
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("yolo inference failed, ret=%d", ret);
+        objects.clear();
+        return ret;
+    }
     // 后处理
-    Postprocess(image_letterbox, objects);
+    Postprocess(objects);
+
+    ReportDetections(objects);
+
+    return NN_SUCCESS;
+}
+
+// 运行模型，输入为解码器输出的YUV420帧
+nn_error_e Yolov5::Run(const yuv_frame_s &frame, std::vector<Detection> &objects)
+{
+    if (!dynamic_shapes_.empty())
+    {
+        SelectInputShape(frame.width, frame.height);
+    }
+    auto ret = PreprocessYuv(frame);
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("yolo yuv preprocess failed, ret=%d", ret);
+        return ret;
+    }
+    ret = Inference();
+    if (ret != NN_SUCCESS)
+    {
+        NN_LOG_ERROR("yolo yuv inference failed, ret=%d", ret);
+        objects.clear();
+        return ret;
+    }
+    // 后处理
+    Postprocess(objects);
+
+    ReportDetections(objects);
+
+    return NN_SUCCESS;
+}
+// 预处理中间缓冲区的复用次数和重新分配次数，固定分辨率的视频流稳定后misses不再增加
+void Yolov5::GetPreprocessScratchStats(uint64_t &hits, uint64_t &misses)
+{
+    hits = scratch_.Hits();
+    misses = scratch_.Misses();
+}
+
+// 模型一次推理的图像数量
+int Yolov5::BatchSize()
+{
+    return input_tensor_.attr.dims[0];
+}
+
+/**
+ * @brief 批量运行：每BatchSize()张图像分别letterbox后打包进同一个输入张量，一次推理后逐张解码输出
+ * @param imgs 输入图像，数量不是BatchSize()的整数倍时，最后一批空出的位置沿用上一批的数据，结果丢弃
+ * @param results 每张图像的检测结果，有图像预处理失败时清空
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::RunBatch(const std::vector<cv::Mat> &imgs, std::vector<std::vector<Detection>> &results)
+{
+    int batch = BatchSize();
+    results.clear();
+    results.resize(imgs.size());
+    std::vector<LetterBoxInfo> letterbox_infos(batch);
+    for (size_t start = 0; start < imgs.size(); start += batch)
+    {
+        int count = std::min<int>(batch, imgs.size() - start);
+        for (int i = 0; i < count; i++)
+        {
+            // 失败的位置会保留上一批的输入数据，不能继续推理
+            auto ret = Preprocess(imgs[start + i], config_.rga_preprocess ? "rga" : "fused", i);
+            if (ret != NN_SUCCESS)
+            {
+                NN_LOG_ERROR("yolo batch preprocess failed, image %d, ret=%d", (int)(start + i), ret);
+                results.clear();
+                return ret;
+            }
+            letterbox_infos[i] = letterbox_info_;
+        }
+        auto ret = Inference();
+        if (ret != NN_SUCCESS)
+        {
+            NN_LOG_ERROR("yolo batch inference failed, ret=%d", ret);
+            return ret;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            letterbox_info_ = letterbox_infos[i];
+            Postprocess(results[start + i], i);
+            ReportDetections(results[start + i]);
+        }
+    }
+    return NN_SUCCESS;
+}
+
+/**
+ * @brief 切片推理：原图切成相互重叠的切片（可选再加上整帧），按BatchSize打包推理，
+ *        各切片的结果换算到原图坐标后做一次全局NMS，合并切片边界两侧的重复框
+ * @param img 输入图像，切片直接引用原图的区域，不拷贝
+ * @param objects 检测结果（原图坐标）
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::RunTiled(const cv::Mat &img, std::vector<Detection> &objects)
+{
+    auto start_time = std::chrono::steady_clock::now();
+    int tile_w = config_.tile_width > 0 ? config_.tile_width : input_tensor_.attr.dims[2];
+    int tile_h = config_.tile_height > 0 ? config_.tile_height : input_tensor_.attr.dims[1];
+    std::vector<cv::Rect> tiles = make_tiles(img.cols, img.rows, tile_w, tile_h, config_.tile_overlap);
+    if (config_.tile_full_frame && tiles.size() > 1)
+    {
+        tiles.push_back(cv::Rect(0, 0, img.cols, img.rows));
+    }
+
+    int batch = BatchSize();
+    std::vector<LetterBoxInfo> letterbox_infos(batch);
+    std::vector<Detection> tile_objects;
+    std::vector<int> tile_ids;
+    objects.clear();
+    for (size_t start = 0; start < tiles.size(); start += batch)
+    {
+        int count = std::min<int>(batch, tiles.size() - start);
+        for (int i = 0; i < count; i++)
+        {
+            auto ret = Preprocess(img(tiles[start + i]), config_.rga_preprocess ? "rga" : "fused", i);
+            if (ret != NN_SUCCESS)
+            {
+                NN_LOG_ERROR("yolo tile preprocess failed, ret=%d", ret);
+                objects.clear();
+                return ret;
+            }
+            letterbox_infos[i] = letterbox_info_;
+        }
+        auto ret = Inference();
+        if (ret != NN_SUCCESS)
+        {
+            NN_LOG_ERROR("yolo tile inference failed, ret=%d", ret);
+            return ret;
+        }
+        for (int i = 0; i < count; i++)
+        {
+            const cv::Rect &tile = tiles[start + i];
+            letterbox_info_ = letterbox_infos[i];
+            tile_objects.clear();
+            Postprocess(tile_objects, i);
+            for (auto &obj : tile_objects)
+            {
+                obj.box.x += tile.x;
+                obj.box.y += tile.y;
+                objects.push_back(obj);
+                tile_ids.push_back(start + i);
+            }
+        }
+    }
+    merge_tile_detections(objects, tile_ids, NMS_THRESH, config_.tile_merge_thresh);
 
+    tiles_run_ += tiles.size();
+    tile_busy_us_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    ReportDetections(objects);
+    return NN_SUCCESS;
+}
+
+// 切片推理处理的切片数和总耗时，切片/秒 = tiles / busy_us * 1e6
+void Yolov5::GetTileStats(uint64_t &tiles, uint64_t &busy_us)
+{
+    tiles = tiles_run_;
+    busy_us = tile_busy_us_;
+}
+
+// 输出检测数量统计
+void Yolov5::ReportDetections(const std::vector<Detection> &objects)
+{
     // 新增代码：统计每个类别的数量
     // std::unordered_map<std::string, int> class_counts;
     // for (const auto& object : objects) {
@@ -188,44 +786,209 @@ nn_error_e Yolov5::Run(const cv::Mat &img, std::vector<Detection> &objects)
 
     //保存车辆信息到car.txt文件中
     SaveDetectionCountToFile(total_detections);
+}
 
-    return NN_SUCCESS;
+/**
+ * @brief 流水线运行：预处理当前帧（与上一帧的NPU推理重叠），然后取回上一帧的输出并提交当前帧
+ * @param img 输入图像
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::RunAsync(const cv::Mat &img)
+{
+    return RunAsyncFrame([&]() { return Preprocess(img, config_.rga_preprocess ? "rga" : "fused"); });
 }
-void letterbox_decode(std::vector<Detection> &objects, bool hor, int pad)
+
+// 流水线运行，输入为解码器输出的YUV420帧
+nn_error_e Yolov5::RunAsync(const yuv_frame_s &frame)
 {
-    for (auto &obj : objects)
+    return RunAsyncFrame([&]() { return PreprocessYuv(frame); });
+}
+
+// RunAsync的公共部分：preprocess把当前帧写入input_tensor_，之后的提交和取回与输入格式无关
+nn_error_e Yolov5::RunAsyncFrame(const std::function<nn_error_e()> &preprocess)
+{
+    // 两块输入内存交替使用，在途推理读取的那一块不会被覆盖；
+    // 零拷贝时引擎只绑定了一块输入内存，提交时由引擎拷贝进去（EnableZeroCopy中有警告）
+    for (int i = 0; i < 2; i++)
+    {
+        if (async_buffers_[i] == nullptr)
+        {
+            async_buffers_[i] = malloc(input_tensor_.attr.size);
+        }
+    }
+    InflightFrame frame;
+    void *input_data = input_tensor_.data;
+    input_tensor_.data = async_buffers_[async_buffer_index_];
+    auto ret = preprocess();
+    frame.letterbox_info = letterbox_info_;
+    inputs_[0] = input_tensor_;
+    input_tensor_.data = input_data;
+    if (ret != NN_SUCCESS)
+    {
+        // 预处理失败的帧不提交，同样要有结果；在途的上一帧先完成，保证Wait的顺序和RunAsync一致
+        NN_LOG_ERROR("yolo async preprocess failed, ret=%d", ret);
+        DrainInflight();
+        done_.emplace_back();
+        return ret;
+    }
+    async_buffer_index_ = 1 - async_buffer_index_;
+
+    // 取回上一帧的输出
+    bool prev_ready = false;
+    InflightFrame prev = inflight_;
+    if (inflight_valid_)
     {
-        if (hor)
+        inflight_valid_ = false;
+        if (engine_->Wait(prev.handle, output_tensors_) == NN_SUCCESS)
         {
-            obj.box.x -= pad;
+            prev_ready = true;
         }
         else
         {
-            obj.box.y -= pad;
+            NN_LOG_ERROR("yolo async wait failed");
+            done_.emplace_back();
         }
     }
+    // 零拷贝模式下输出内存会被当前帧覆盖，要在提交前完成上一帧的后处理
+    if (prev_ready && zero_copy_)
+    {
+        PostprocessFrame(prev);
+        prev_ready = false;
+    }
+
+    // 提交当前帧
+    ret = engine_->RunAsync(inputs_, false, frame.handle);
+    if (ret == NN_SUCCESS)
+    {
+        inflight_ = frame;
+        inflight_valid_ = true;
+    }
+
+    // 当前帧在NPU上运行时完成上一帧的后处理
+    if (prev_ready)
+    {
+        PostprocessFrame(prev);
+    }
+    if (ret != NN_SUCCESS)
+    {
+        // 提交失败的帧也要有结果，保证Wait的顺序和RunAsync一致
+        NN_LOG_ERROR("yolo async run failed, ret=%d", ret);
+        done_.emplace_back();
+    }
+    return ret;
+}
+
+// 取回在途的一帧并完成后处理，取回失败时放入空结果
+void Yolov5::DrainInflight()
+{
+    if (!inflight_valid_)
+    {
+        return;
+    }
+    inflight_valid_ = false;
+    if (engine_->Wait(inflight_.handle, output_tensors_) == NN_SUCCESS)
+    {
+        PostprocessFrame(inflight_);
+    }
+    else
+    {
+        NN_LOG_ERROR("yolo async wait failed");
+        done_.emplace_back();
+    }
+}
+
+// 对已经取回输出的一帧做后处理，结果放入done_
+void Yolov5::PostprocessFrame(const InflightFrame &frame)
+{
+    std::vector<Detection> objects;
+    letterbox_info_ = frame.letterbox_info;
+    Postprocess(objects);
+    ReportDetections(objects);
+    done_.push_back(objects);
+}
+
+/**
+ * @brief 按RunAsync的提交顺序取回一帧的检测结果，必要时等待推理完成
+ * @param objects 检测结果
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5::Wait(std::vector<Detection> &objects)
+{
+    if (done_.empty())
+    {
+        if (!inflight_valid_)
+        {
+            NN_LOG_ERROR("yolo no inflight frame to wait");
+            return NN_ASYNC_HANDLE_INVALID;
+        }
+        inflight_valid_ = false;
+        auto ret = engine_->Wait(inflight_.handle, output_tensors_);
+        if (ret != NN_SUCCESS)
+        {
+            NN_LOG_ERROR("yolo async wait failed, ret=%d", ret);
+            return ret;
+        }
+        PostprocessFrame(inflight_);
+    }
+    objects = done_.front();
+    done_.pop_front();
+    return NN_SUCCESS;
+}
+
+// 框已经按scale缩放回原图尺度，再减去偏移（换算到原图像素）
+void letterbox_decode(std::vector<Detection> &objects, const LetterBoxInfo &info)
+{
+    int x_pad = lroundf(info.x_pad / info.scale_x);
+    int y_pad = lroundf(info.y_pad / info.scale_y);
+    for (auto &obj : objects)
+    {
+        obj.box.x -= x_pad;
+        obj.box.y -= y_pad;
+    }
 }
 // 后处理
-nn_error_e Yolov5::Postprocess(const cv::Mat &img, std::vector<Detection> &objects)
+nn_error_e Yolov5::Postprocess(std::vector<Detection> &objects, int batch_index)
 {
     int height = input_tensor_.attr.dims[1];
     int width = input_tensor_.attr.dims[2];
-    float scale_w = height * 1.f / img.cols; // 保证为浮点类型
-    float scale_h = width * 1.f / img.rows;
+    // 原图到模型输入的缩放比例
+    float scale_w = letterbox_info_.scale_x;
+    float scale_h = letterbox_info_.scale_y;
+
+    // 批量模型的输出为[N, ...]，取出第batch_index张图像的一段
+    int batch = input_tensor_.attr.dims[0];
+    int8_t *outputs[3];
+    for (int i = 0; i < 3; i++)
+    {
+        size_t image_size = output_nhwc_ ? (size_t)out_cell_strides_[i] * out_grids_[i].h * out_grids_[i].w
+                                         : output_tensors_[i].attr.n_elems / batch;
+        outputs[i] = (int8_t *)output_tensors_[i].data + image_size * batch_index;
+    }
 
     yolov5::detect_result_group_t detections;
 
-    yolov5::post_process((int8_t *)output_tensors_[0].data,
-                         (int8_t *)output_tensors_[1].data,
-                         (int8_t *)output_tensors_[2].data,
-                         height, width,
-                         BOX_THRESH, NMS_THRESH,
-                         scale_w, scale_h,
-                         out_zps_, out_scales_,
-                         &detections);
+    // 解码和NMS使用预分配的缓冲区，第一帧之后不应该再有内存分配（alloc测试postprocess_with_context_allocates_nothing）
+    if (output_nhwc_)
+    {
+        yolov5::post_process_nhwc(outputs[0], outputs[1], outputs[2],
+                                  height, width,
+                                  BOX_THRESH, NMS_THRESH,
+                                  scale_w, scale_h,
+                                  out_zps_, out_scales_, out_luts_.data(), out_cell_strides_,
+                                  out_grids_, &detections, config_.pre_nms_top_k, &postprocess_ctx_);
+    }
+    else
+    {
+        yolov5::post_process(outputs[0], outputs[1], outputs[2],
+                             height, width,
+                             BOX_THRESH, NMS_THRESH,
+                             scale_w, scale_h,
+                             out_zps_, out_scales_, out_luts_.data(),
+                             out_grids_, &detections, config_.pre_nms_top_k, &postprocess_ctx_);
+    }
 
     DetectionGrp2DetectionArray(detections, objects);
-    letterbox_decode(objects, letterbox_info_.hor, letterbox_info_.pad);
+    letterbox_decode(objects, letterbox_info_);
 
     return NN_SUCCESS;
 }
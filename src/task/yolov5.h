@@ -6,27 +6,120 @@
 #include "types/yolo_datatype.h"
 #include "engine/engine.h"
 #include "process/preprocess.h"
+#include "process/image_processor.h"
+#include "process/yolov5_postprocess.h"
+
+#include <deque>
+#include <functional>
+#include <string>
+
+// Yolov5实例的运行选项
+struct Yolov5Config
+{
+    bool zero_copy{false};        // 零拷贝：预处理直接写入NPU输入内存，后处理直接读取NPU输出内存（和async_inference同时开启时输入仍要拷贝）
+    bool prealloc_outputs{false}; // 推理输出直接写入output_tensors_，Run过程中不再分配内存
+    bool async_inference{false};  // 异步推理：RunAsync/Wait流水线，下一帧的预处理和当前帧的NPU推理重叠
+    bool native_output_layout{false}; // 输出使用NPU原生的NHWC布局（需要零拷贝），每个网格的通道连续存放
+    bool dynamic_input{false};        // 动态输入模型：每帧按原图宽高比选择letterbox padding最少的输入形状（不支持零拷贝，RunAsync沿用当前形状）
+    nn_core_mask_e core_mask{NN_NPU_CORE_AUTO}; // 绑定的NPU核心
+    std::string profile_report;                 // 逐层性能统计的输出路径前缀，为空时不统计（开启后会降低帧率）
+    int batch_core_num{0};                      // 批量模型（输入N>1）一批图像使用的NPU核心数，0表示由驱动决定
+    nn_backend_e backend{NN_BACKEND_RKNN};      // 推理后端，回放后端的LoadModel传入录制文件，OpenCV DNN后端传入ONNX模型
+                                                // （三个sigmoid之前的检测头[1, 255, H, W]，不支持[1, 25200, 85]的合并输出；logits超出±16时截断）
+    uint32_t replay_latency_us{0};              // 回放后端模拟的NPU推理耗时（微秒）
+    std::string capture_path;                   // 把推理输出录制到该文件，为空时不录制
+    letterbox_mode_e letterbox_mode{LETTERBOX_RESIZE_PAD}; // letterbox方式，默认只缩放原图内容，不生成原图大小的补边图像
+    bool rga_preprocess{false};                            // 使用RGA预处理（DMA内存，一次improcess），没有RGA时退回CPU实现
+    bool rga_import_src{false};                            // RGA预处理时原图每帧导入虚拟地址直接读取，默认拷贝到复用的DMA内存
+    int dnn_input_width{640};                   // OpenCV DNN后端的模型输入宽度（ONNX模型导出时的尺寸）
+    int dnn_input_height{640};                  // OpenCV DNN后端的模型输入高度
+    bool tiled{false};              // 切片推理：原图切成相互重叠的切片分别检测，合并后输出，用于4K画面中的远处小目标
+    int tile_width{0};              // 切片宽度，0表示使用模型输入宽度（不缩放）
+    int tile_height{0};             // 切片高度，0表示使用模型输入高度
+    float tile_overlap{0.2f};       // 相邻切片的重叠比例
+    bool tile_full_frame{true};     // 另外对整帧做一次检测，避免大目标被切片切开
+    float tile_merge_thresh{0.6f};  // 不同切片的框交集占较小框的比例超过该值时合并为一个框
+    int pre_nms_top_k{PRE_NMS_TOP_K}; // NMS前最多保留的候选框数量（按置信度），<=0表示不限制
+};
 
 class Yolov5
 {
 public:
-    Yolov5();
+    Yolov5(const Yolov5Config &config = Yolov5Config());
     ~Yolov5();
 
-    nn_error_e LoadModel(const char *model_path);                        // 加载模型
+    nn_error_e LoadModel(const char *model_path);                        // 加载模型，文件格式由config.backend决定
+    nn_error_e ShareModel(Yolov5 &source);                               // 复用另一个实例已加载的模型（共享权重）
+    uint64_t GetWeightSize();                                            // 模型权重大小（字节）
     nn_error_e Run(const cv::Mat &img, std::vector<Detection> &objects); // 运行模型
+    nn_error_e Run(const yuv_frame_s &frame, std::vector<Detection> &objects); // 运行模型，输入为解码器输出的YUV420帧
+    int BatchSize();                                                     // 模型一次推理的图像数量
+    void GetTileStats(uint64_t &tiles, uint64_t &busy_us);               // 切片推理处理的切片数和耗时（微秒）
+    void GetPreprocessScratchStats(uint64_t &hits, uint64_t &misses);    // 预处理中间缓冲区的复用/重新分配次数
+    // 批量运行：每N张图像（N为BatchSize）打包成一次推理，results[i]为imgs[i]的检测结果
+    nn_error_e RunBatch(const std::vector<cv::Mat> &imgs, std::vector<std::vector<Detection>> &results);
+
+    // 流水线运行：RunAsync预处理当前帧后提交推理，期间完成上一帧的后处理；Wait按提交顺序取回结果
+    nn_error_e RunAsync(const cv::Mat &img);          // 预处理并提交推理，不等待结果
+    nn_error_e RunAsync(const yuv_frame_s &frame);    // 同上，输入为YUV420帧
+    nn_error_e Wait(std::vector<Detection> &objects); // 取回最早提交的一帧的检测结果
+
+    // 图像预处理（fused、opencv或rga），写入批量输入中的第batch_index张；Run的第一步，单独调用用于测试预处理的内存复用
+    nn_error_e Preprocess(const cv::Mat &img, const std::string process_type, int batch_index = 0);
 
 private:
-    nn_error_e Preprocess(const cv::Mat &img, const std::string process_type,cv::Mat &image_letterbox);   // 图像预处理
-    nn_error_e Inference();                                                      // 推理
-    nn_error_e Postprocess(const cv::Mat &img, std::vector<Detection> &objects); // 后处理
+    nn_error_e PreprocessYuv(const yuv_frame_s &frame, int batch_index = 0);   // YUV420帧预处理，写入批量输入中的第batch_index张
+    tensor_data_s InputSlice(int batch_index);                                // 批量输入中第batch_index张图像的一段
+    nn_error_e Inference();                                                                           // 推理
+    nn_error_e Postprocess(std::vector<Detection> &objects, int batch_index = 0);                     // 后处理，解码批量输出中的第batch_index张
+    nn_error_e RunTiled(const cv::Mat &img, std::vector<Detection> &objects);         // 切片推理
+    nn_error_e InitTensors();                                                    // 模型加载后初始化输入输出张量
+    nn_error_e EnableZeroCopy();                                                 // 开启零拷贝
+    void EnableCapture();                                                        // 按配置录制推理输出
+    void ReportDetections(const std::vector<Detection> &objects);                // 输出检测数量统计
+    void InitDynamicShapes();                                                    // 动态输入模型：获取支持的形状并切换到最大的形状
+    nn_error_e SelectInputShape(int src_width, int src_height);                  // 动态输入模型：为原图选择输入形状
+    void UpdateOutputGrids();                                                    // 根据当前输出属性更新网格尺寸
+    void InitImageProcessor();                                                   // 创建rga预处理，零拷贝时登记输入张量的dma-buf
+
+    // 异步推理中在途的一帧
+    struct InflightFrame
+    {
+        int handle;
+        LetterBoxInfo letterbox_info;
+    };
+    void PostprocessFrame(const InflightFrame &frame); // 对取回输出的一帧做后处理
+    void DrainInflight();                              // 取回在途的一帧并完成后处理
+    nn_error_e RunAsyncFrame(const std::function<nn_error_e()> &preprocess); // RunAsync的公共部分
 
+    Yolov5Config config_;
+    bool zero_copy_; // 零拷贝是否开启成功，开启后输入输出内存归引擎所有
     LetterBoxInfo letterbox_info_;
+    std::shared_ptr<ImageProcessor> image_processor_; // rga预处理，第一次使用时创建，DMA内存按实例复用
+    ScratchArena scratch_;                            // 预处理中间缓冲区，原图尺寸不变时复用
     tensor_data_s input_tensor_;
+    std::vector<tensor_data_s> inputs_; // 传给引擎的输入，复用以避免每帧分配
     std::vector<tensor_data_s> output_tensors_;
     std::vector<int32_t> out_zps_;
     std::vector<float> out_scales_;
+    std::vector<yolov5::DECODE_LUT> out_luts_; // 每个输出的sigmoid/解码查找表，加载模型时计算
+    yolov5::PostprocessContext postprocess_ctx_; // 后处理的候选框缓冲区，按最大输出网格预分配
+    bool output_nhwc_;                   // 输出是否为NHWC布局
+    std::vector<int> out_cell_strides_; // NHWC布局下每个输出相邻网格的间隔（字节）
+    yolov5::GRID_SIZE out_grids_[3];     // 每个输出的网格尺寸
+    std::vector<tensor_attr_s> dynamic_shapes_; // 动态输入模型支持的输入形状，为空表示固定形状
+    int dynamic_shape_index_;                   // 当前使用的输入形状
+    int last_src_w_, last_src_h_;               // 上一次选择形状时的原图尺寸
     std::shared_ptr<NNEngine> engine_;
+
+    void *async_buffers_[2];                     // 异步推理的两块输入内存，交替使用
+    int async_buffer_index_;                     // 下一帧使用的输入内存
+    bool inflight_valid_;                        // 是否有在途的一帧
+    InflightFrame inflight_;                     // 在途的一帧
+    std::deque<std::vector<Detection>> done_;    // 已完成但还未被Wait取走的结果
+
+    uint64_t tiles_run_;     // 切片推理处理的切片数
+    uint64_t tile_busy_us_;  // 切片推理的总耗时（微秒）
 };
 
 #endif // RK3588_DEMO_YOLOV5_H
@@ -1,8 +1,25 @@
 
 #include "yolov5_thread_pool.h"
 #include "draw/cv_draw.h"
+#include "utils/model_cache.h"
+
+// 任务中拷贝的YUV420数据对应的帧描述
+static yuv_frame_s taskYuvFrame(FrameTask &task)
+{
+    yuv_frame_s frame;
+    frame.format = task.yuv_format;
+    frame.width = task.width;
+    frame.height = task.height;
+    frame.hor_stride = task.img.cols;
+    frame.ver_stride = task.img.rows * 2 / 3;
+    frame.data = task.img.data;
+    frame.fd = -1;
+    return frame;
+}
 // 构造函数
-Yolov5ThreadPool::Yolov5ThreadPool() { stop = false; }
+Yolov5ThreadPool::Yolov5ThreadPool()
+    : placement_(NPU_PLACEMENT_AUTO), spill_threads_(0), spill_threshold_(0), spilled_frames_(0),
+      last_detections_id_(-1) { stop = false; }
 
 // 析构函数
 Yolov5ThreadPool::~Yolov5ThreadPool()
@@ -10,6 +27,7 @@ Yolov5ThreadPool::~Yolov5ThreadPool()
     // stop all threads
     stop = true;
     cv_task.notify_all();
+    cv_spill_.notify_all();
     for (auto &thread : threads)
     {
         if (thread.joinable())
@@ -19,26 +37,160 @@ Yolov5ThreadPool::~Yolov5ThreadPool()
     }
 }
 
-// 初始化：加载模型，创建线程，参数：模型路径，线程数量
-nn_error_e Yolov5ThreadPool::setUp(std::string &model_path, int num_threads)
+// 设置NPU核心分配策略，参数：策略，每个实例的掩码（仅NPU_PLACEMENT_EXPLICIT使用，数量不足时循环使用）
+void Yolov5ThreadPool::setNPUPlacement(npu_placement_e placement, const std::vector<nn_core_mask_e> &core_masks)
+{
+    placement_ = placement;
+    core_masks_ = core_masks;
+}
+
+/**
+ * @brief 开启CPU分流：NPU实例处理不过来、任务队列深度超过阈值时，多出的帧交给CPU上的OpenCV DNN实例
+ * @param onnx_path 和RKNN模型等价的ONNX模型（输入尺寸和RKNN模型一致）
+ * @param num_threads CPU实例数量
+ * @param queue_threshold 队列深度阈值，需要小于submitTask的队列上限（10）才会生效
+ */
+void Yolov5ThreadPool::setCPUSpill(const std::string &onnx_path, int num_threads, int queue_threshold)
+{
+    if (queue_threshold >= 10)
+    {
+        NN_LOG_WARNING("cpu spill threshold %d never reached, task queue is capped at 10", queue_threshold);
+    }
+    spill_model_path_ = onnx_path;
+    spill_threads_ = num_threads;
+    spill_threshold_ = queue_threshold < 0 ? 0 : queue_threshold;
+}
+
+/**
+ * @brief 开启运动门限：提交的帧先缩小成灰度图和背景比较，变化很小时不进入任务队列，直接沿用最近一次的检测结果
+ * @param pixel_thresh 单个像素的灰度差超过该值算作变化
+ * @param motion_ratio 变化像素的比例超过该值认为有运动，有运动的帧都会推理
+ * @param max_skip 连续跳过的最大帧数
+ */
+void Yolov5ThreadPool::setMotionGate(int pixel_thresh, float motion_ratio, int max_skip)
+{
+    motion_gate_.reset(new MotionGate(160, pixel_thresh, motion_ratio, max_skip));
+}
+
+// 第index个实例的核心掩码
+nn_core_mask_e Yolov5ThreadPool::coreMaskFor(int index)
 {
+    static const nn_core_mask_e round_robin[g_npu_core_num] = {NN_NPU_CORE_0, NN_NPU_CORE_1, NN_NPU_CORE_2};
+    switch (placement_)
+    {
+    case NPU_PLACEMENT_ROUND_ROBIN:
+        return round_robin[index % g_npu_core_num];
+    case NPU_PLACEMENT_ALL_CORES:
+        return NN_NPU_CORE_0_1_2;
+    case NPU_PLACEMENT_EXPLICIT:
+        if (!core_masks_.empty())
+        {
+            return core_masks_[index % core_masks_.size()];
+        }
+        NN_LOG_WARNING("no explicit core mask given, use auto");
+        return NN_NPU_CORE_AUTO;
+    default:
+        return config_.core_mask;
+    }
+}
+
+// 初始化：加载模型，创建线程，参数：模型路径，线程数量，模型实例选项
+nn_error_e Yolov5ThreadPool::setUp(std::string &model_path, int num_threads, const Yolov5Config &config)
+{
+    config_ = config;
     // 遍历线程数量，创建模型实例，放入vector
-    // 这些线程加载的模型是同一个
-    for (size_t i = 0; i < num_threads; ++i)
+    // 这些线程加载的模型是同一个：只有第一个实例读取模型文件，其余实例复制它的context，共享权重
+    // 初始化期间持有模型文件映射，需要重新加载的实例都复用同一份映射，全部初始化完成后释放
+    auto model_blob = ModelBlobCache::Instance().Acquire(model_path);
+    double load_ms = 0;
+    double share_ms = 0;
+    int shared_count = 0;
+    for (int i = 0; i < num_threads; ++i)
     {
-        // 创建一个Yolov5模型实例
-        std::shared_ptr<Yolov5> yolov5 = std::make_shared<Yolov5>();
-        // 调用Yolov5的LoadModel方法加载模型，传入模型路径
-        yolov5->LoadModel(model_path.c_str());
+        // 创建一个Yolov5模型实例，按分配策略绑定NPU核心
+        Yolov5Config instance_config = config;
+        instance_config.core_mask = coreMaskFor(i);
+        if (!config.profile_report.empty())
+        {
+            // 每个实例写出各自的性能统计
+            instance_config.profile_report = config.profile_report + "_" + std::to_string(i);
+        }
+        if (!config.capture_path.empty())
+        {
+            instance_config.capture_path = config.capture_path + "_" + std::to_string(i);
+        }
+        std::shared_ptr<Yolov5> yolov5 = std::make_shared<Yolov5>(instance_config);
+        auto start = std::chrono::steady_clock::now();
+        if (i > 0 && yolov5->ShareModel(*yolov5_instances[0]) == NN_SUCCESS)
+        {
+            share_ms += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+            shared_count++;
+        }
+        else
+        {
+            // 调用Yolov5的LoadModel方法加载模型，传入模型路径
+            yolov5->LoadModel(model_path.c_str());
+            load_ms += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+        }
         // 将模型实例添加到yolov5_instances向量中
         yolov5_instances.push_back(yolov5);
     }
+    if (shared_count > 0)
+    {
+        double load_avg_ms = load_ms / (num_threads - shared_count);
+        double share_avg_ms = share_ms / shared_count;
+        double weight_mb = yolov5_instances[0]->GetWeightSize() / 1024.0 / 1024.0;
+        NN_LOG_INFO("model load: %.1fms, %d shared instances: %.1fms each", load_avg_ms, shared_count, share_avg_ms);
+        NN_LOG_INFO("shared weights saved about %.1fms startup and %.2fMB memory",
+                    (load_avg_ms - share_avg_ms) * shared_count, weight_mb * shared_count);
+    }
+    // CPU分流实例：只保留和后端无关的选项
+    for (int i = 0; i < spill_threads_; ++i)
+    {
+        Yolov5Config cpu_config;
+        cpu_config.backend = NN_BACKEND_OPENCV_DNN;
+        cpu_config.dnn_input_width = config.dnn_input_width;
+        cpu_config.dnn_input_height = config.dnn_input_height;
+        cpu_config.prealloc_outputs = config.prealloc_outputs;
+        cpu_config.tiled = config.tiled;
+        cpu_config.tile_width = config.tile_width;
+        cpu_config.tile_height = config.tile_height;
+        cpu_config.tile_overlap = config.tile_overlap;
+        cpu_config.tile_full_frame = config.tile_full_frame;
+        cpu_config.tile_merge_thresh = config.tile_merge_thresh;
+        cpu_config.pre_nms_top_k = config.pre_nms_top_k;
+        std::shared_ptr<Yolov5> yolov5 = std::make_shared<Yolov5>(cpu_config);
+        // CPU实例各自持有一份网络，cv::dnn::Net不能在线程间共享推理
+        if (yolov5->LoadModel(spill_model_path_.c_str()) != NN_SUCCESS)
+        {
+            NN_LOG_ERROR("cpu spill model %s load fail, spill disabled", spill_model_path_.c_str());
+            cpu_instances_.clear();
+            break;
+        }
+        cpu_instances_.push_back(yolov5);
+    }
+    if (!cpu_instances_.empty())
+    {
+        NN_LOG_INFO("cpu spill: %ld instances, queue threshold %ld", cpu_instances_.size(), spill_threshold_);
+    }
     // 遍历线程数量，创建线程
-    for (size_t i = 0; i < num_threads; ++i)
+    for (int i = 0; i < num_threads; ++i)
     {
         // 为每个工作线程创建一个新线程，执行worker方法，传入当前线程ID
-        threads.emplace_back(&Yolov5ThreadPool::worker, this, i);
+        if (config.async_inference)
+        {
+            threads.emplace_back(&Yolov5ThreadPool::workerAsync, this, i);
+        }
+        else
+        {
+            threads.emplace_back(&Yolov5ThreadPool::worker, this, i);
+        }
+    }
+    for (size_t i = 0; i < cpu_instances_.size(); ++i)
+    {
+        threads.emplace_back(&Yolov5ThreadPool::workerCPU, this, i);
     }
+    start_time_ = std::chrono::steady_clock::now();
     // 返回成功状态
     return NN_SUCCESS;
 }
@@ -50,7 +202,7 @@ void Yolov5ThreadPool::worker(int id)
     while (!stop)
     {
         // 定义一个用于存放任务的变量
-        std::pair<int, cv::Mat> task;
+        FrameTask task;
         // 获取当前线程对应的Yolov5模型实例
         std::shared_ptr<Yolov5> instance = yolov5_instances[id]; // 获取模型实例
         
@@ -74,25 +226,192 @@ void Yolov5ThreadPool::worker(int id)
         // 运行模型进行推理
         std::vector<Detection> detections;
         // 使用取出的任务中的图像进行推理，并将结果保存在detections中
-        instance->Run(task.second, detections);
+        runTask(*instance, task, detections);
+
+        saveResult(task, detections, true);
+    }
+}
+
+// 异步推理的线程函数：每个实例保持一帧在途，下一帧的预处理和当前帧的NPU推理重叠
+void Yolov5ThreadPool::workerAsync(int id)
+{
+    std::shared_ptr<Yolov5> instance = yolov5_instances[id]; // 获取模型实例
+    std::queue<FrameTask> inflight;                          // 已提交但还未取回结果的任务
+    while (!stop)
+    {
+        FrameTask task;
+        bool has_task = false;
+        {
+            std::unique_lock<std::mutex> lock(mtx1);
+            // 有在途任务时不阻塞，队列为空就先取回在途任务的结果
+            if (inflight.empty())
+            {
+                cv_task.wait(lock, [&]
+                             { return !tasks.empty() || stop; });
+            }
+            if (stop)
+            {
+                return;
+            }
+            if (!tasks.empty())
+            {
+                task = tasks.front();
+                tasks.pop();
+                has_task = true;
+            }
+        }
+
+        if (has_task)
+        {
+            // 预处理当前帧并提交，同时完成上一帧的后处理
+            if (task.is_yuv)
+            {
+                instance->RunAsync(taskYuvFrame(task));
+            }
+            else
+            {
+                instance->RunAsync(task.img);
+            }
+            inflight.push(task);
+        }
+        if (inflight.size() > 1 || (!has_task && !inflight.empty()))
+        {
+            std::vector<Detection> detections;
+            instance->Wait(detections);
+            saveResult(inflight.front(), detections, true);
+            inflight.pop();
+        }
+    }
+}
 
+// CPU分流的线程函数：只在任务队列积压超过阈值时取任务，队列较浅时把帧留给NPU
+void Yolov5ThreadPool::workerCPU(int id)
+{
+    std::shared_ptr<Yolov5> instance = cpu_instances_[id];
+    while (!stop)
+    {
+        FrameTask task;
         {
-            // 锁定用于存储结果的部分
-            std::lock_guard<std::mutex> lock(mtx2);
-            // 将检测结果保存到结果集合中
-            results.insert({task.first, detections});
-            // 使用检测结果对图像进行绘制
-            DrawDetections(task.second, detections);
-            // 将绘制后的图像保存到img_results中
-            img_results.insert({task.first, task.second});
-            // 通知等待结果的线程
-            cv_result.notify_one();
+            std::unique_lock<std::mutex> lock(mtx1);
+            cv_spill_.wait(lock, [&]
+                           { return tasks.size() > spill_threshold_ || stop; });
+            if (stop)
+            {
+                return;
+            }
+            task = tasks.front();
+            tasks.pop();
+            spilled_frames_++;
         }
+        std::vector<Detection> detections;
+        runTask(*instance, task, detections);
+        saveResult(task, detections, true);
     }
 }
 
+// 按任务的格式运行模型
+void Yolov5ThreadPool::runTask(Yolov5 &instance, FrameTask &task, std::vector<Detection> &detections)
+{
+    if (task.is_yuv)
+    {
+        instance.Run(taskYuvFrame(task), detections);
+    }
+    else
+    {
+        instance.Run(task.img, detections);
+    }
+}
+
+// 保存一帧的结果：检测框和绘制后的图片；inferred表示结果来自这一帧的推理，而不是沿用的结果
+void Yolov5ThreadPool::saveResult(FrameTask &task, std::vector<Detection> &detections, bool inferred)
+{
+    if (task.is_yuv)
+    {
+        // 绘制需要BGR图像，推理已经完成，这里的转换不影响模型输入
+        cv::Mat bgr;
+        cv::cvtColor(task.img, bgr, task.yuv_format == NN_YUV_NV12 ? cv::COLOR_YUV2BGR_NV12 : cv::COLOR_YUV2BGR_I420);
+        task.img = bgr(cv::Rect(0, 0, task.width, task.height));
+    }
+    // 锁定用于存储结果的部分
+    std::lock_guard<std::mutex> lock(mtx2);
+    // 静止的帧沿用帧号最大的一次推理结果，乱序完成的旧帧不覆盖；
+    // 沿用结果的帧不更新，否则还在推理的旧帧完成后会被丢弃
+    if (motion_gate_ && inferred && task.id > last_detections_id_)
+    {
+        last_detections_ = detections;
+        last_detections_id_ = task.id;
+    }
+    // 将检测结果保存到结果集合中
+    results.insert({task.id, detections});
+    // 使用检测结果对图像进行绘制
+    DrawDetections(task.img, detections);
+    // 将绘制后的图像保存到img_results中
+    img_results.insert({task.id, task.img});
+    // 通知等待结果的线程
+    cv_result.notify_one();
+}
+
 // 提交任务，参数：图片，id（帧号）
 nn_error_e Yolov5ThreadPool::submitTask(const cv::Mat &img, int id)
+{
+    FrameTask task;
+    task.id = id;
+    task.img = img;
+    task.is_yuv = false;
+    if (motion_gate_ && !motion_gate_->Check(img))
+    {
+        reuseLastResult(task);
+        return NN_SUCCESS;
+    }
+    pushTask(task);
+    return NN_SUCCESS;  // 返回成功状态
+}
+
+/**
+ * @brief 提交YUV420帧：解码器的缓冲区很快会被复用，这里按步长整帧拷贝一份，工作线程直接从YUV做预处理
+ * @param frame YUV420帧（NV12或I420），fd不会被使用
+ * @param id 帧号
+ * @return nn_error_e 错误码
+ */
+nn_error_e Yolov5ThreadPool::submitTask(const yuv_frame_s &frame, int id)
+{
+    if (frame.data == nullptr || frame.ver_stride % 2 != 0)
+    {
+        NN_LOG_ERROR("invalid yuv frame, data=%p, ver_stride=%d", frame.data, frame.ver_stride);
+        return NN_IMG_INPUT_ERROR;
+    }
+    // Y平面就是灰度图，运动门限不需要颜色转换
+    bool motion = !motion_gate_ ||
+                  motion_gate_->Check(cv::Mat(frame.height, frame.width, CV_8UC1, frame.data, frame.hor_stride));
+    FrameTask task;
+    task.id = id;
+    cv::Mat(frame.ver_stride * 3 / 2, frame.hor_stride, CV_8UC1, frame.data).copyTo(task.img);
+    task.is_yuv = true;
+    task.yuv_format = frame.format;
+    task.width = frame.width;
+    task.height = frame.height;
+    if (!motion)
+    {
+        reuseLastResult(task);
+        return NN_SUCCESS;
+    }
+    pushTask(task);
+    return NN_SUCCESS;
+}
+
+// 静止的帧：复制最近一次推理的检测结果，绘制后保存，不占用NPU
+void Yolov5ThreadPool::reuseLastResult(FrameTask &task)
+{
+    std::vector<Detection> detections;
+    {
+        std::lock_guard<std::mutex> lock(mtx2);
+        detections = last_detections_;
+    }
+    saveResult(task, detections, false);
+}
+
+// 任务放入队列并唤醒工作线程
+void Yolov5ThreadPool::pushTask(FrameTask &task)
 {
     // 如果任务队列中的任务数量大于10，等待，避免内存占用过多
     while (tasks.size() > 10)
@@ -101,13 +420,19 @@ nn_error_e Yolov5ThreadPool::submitTask(const cv::Mat &img, int id)
         std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
 
+    bool spill = false;
     {
         // 保存任务
         std::lock_guard<std::mutex> lock(mtx1);  // 使用锁保证线程安全
-        tasks.push({id, img});  // 将任务（帧号和对应的图片）添加到任务队列中
+        tasks.push(task);  // 将任务（帧号和对应的图片）添加到任务队列中
+        spill = !cpu_instances_.empty() && tasks.size() > spill_threshold_;
     }
     cv_task.notify_one();  // 通知一个正在等待的工作线程有新的任务到来
-    return NN_SUCCESS;  // 返回成功状态
+    if (spill)
+    {
+        // NPU处理不过来，唤醒一个CPU线程分担
+        cv_spill_.notify_one();
+    }
 }
 
 // 获取结果，参数：检测框，id（帧号）
@@ -155,4 +480,52 @@ void Yolov5ThreadPool::stopAll()
 {
     stop = true;
     cv_task.notify_all();
-}
\ No newline at end of file
+    cv_spill_.notify_all();
+}
+
+// 打印每个NPU核心的利用率（推理耗时 / setUp以来的时间），用于确认负载是否均衡
+void Yolov5ThreadPool::printNPUUsage()
+{
+    nn_npu_usage_s usage = GetNPUUsage();
+    double elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start_time_)
+                            .count();
+    if (elapsed_us <= 0)
+    {
+        return;
+    }
+    for (int i = 0; i < g_npu_core_num; i++)
+    {
+        NN_LOG_INFO("NPU core %d: runs=%lu, busy=%.1fms, util=%.1f%%", i, (unsigned long)usage.run_count[i],
+                    usage.busy_us[i] / 1000.0, usage.busy_us[i] * 100.0 / elapsed_us);
+    }
+    if (usage.auto_run_count > 0)
+    {
+        NN_LOG_INFO("NPU core auto: runs=%lu, busy=%.1fms", (unsigned long)usage.auto_run_count,
+                    usage.auto_busy_us / 1000.0);
+    }
+    if (!cpu_instances_.empty())
+    {
+        std::lock_guard<std::mutex> lock(mtx1);
+        NN_LOG_INFO("CPU spill: frames=%lu", (unsigned long)spilled_frames_);
+    }
+    if (motion_gate_ && motion_gate_->Frames() > 0)
+    {
+        // 在提交线程中读取，统计值只是近似
+        NN_LOG_INFO("motion gate: frames=%lu, skipped=%.1f%%, cost=%.3fms/frame", (unsigned long)motion_gate_->Frames(),
+                    motion_gate_->Skipped() * 100.0 / motion_gate_->Frames(),
+                    motion_gate_->CostUs() / 1000.0 / motion_gate_->Frames());
+    }
+    if (config_.tiled)
+    {
+        // 所有实例并行处理切片，吞吐按墙钟时间计算
+        uint64_t tiles_total = 0;
+        for (auto &instance : yolov5_instances)
+        {
+            uint64_t tiles, busy_us;
+            instance->GetTileStats(tiles, busy_us);
+            tiles_total += tiles;
+        }
+        NN_LOG_INFO("tiles: %lu, %.1f tiles/s", (unsigned long)tiles_total, tiles_total * 1000000.0 / elapsed_us);
+    }
+}
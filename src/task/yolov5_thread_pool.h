@@ -4,19 +4,42 @@
 #define RK3588_DEMO_YOLOV5_THREAD_POOL_H
 
 #include "yolov5.h"
+#include "process/motion_gate.h"
 
 #include <iostream>
 #include <vector>
 #include <queue>
 #include <map>
+#include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
+
+// 多实例在NPU核心上的分配策略
+typedef enum
+{
+    NPU_PLACEMENT_AUTO = 0,        // 不绑定，由驱动分配
+    NPU_PLACEMENT_ROUND_ROBIN = 1, // 依次绑定到核心0/1/2（吞吐优先）
+    NPU_PLACEMENT_ALL_CORES = 2,   // 每个实例都使用0_1_2三核联合（延迟优先）
+    NPU_PLACEMENT_EXPLICIT = 3,    // 使用setNPUPlacement传入的每个实例的掩码
+} npu_placement_e;
+
+// 线程池中的一个任务：BGR图像，或拷贝进单通道Mat的YUV420帧（hor_stride列，ver_stride*3/2行）
+struct FrameTask
+{
+    int id;                 // 帧号
+    cv::Mat img;            // BGR图像或YUV420数据
+    bool is_yuv;            // img是否为YUV420数据
+    yuv_format_e yuv_format; // YUV420格式
+    int width;              // YUV帧的有效宽度
+    int height;             // YUV帧的有效高度
+};
 
 class Yolov5ThreadPool
 {
 private:
-    std::queue<std::pair<int, cv::Mat>> tasks;             // <id, img>用来存放任务
+    std::queue<FrameTask> tasks;                           // 用来存放任务
     std::vector<std::shared_ptr<Yolov5>> yolov5_instances; // 模型实例
     std::map<int, std::vector<Detection>> results;         // <id, objects>用来存放结果（检测框）
     std::map<int, cv::Mat> img_results;                    // <id, img>用来存放结果（图片）
@@ -25,18 +48,50 @@ private:
     std::mutex mtx2;
     std::condition_variable cv_task, cv_result;
     bool stop;
+    Yolov5Config config_; // 模型实例选项
+    npu_placement_e placement_;             // NPU核心分配策略
+    std::vector<nn_core_mask_e> core_masks_; // NPU_PLACEMENT_EXPLICIT时每个实例的掩码
+    std::chrono::steady_clock::time_point start_time_; // setUp完成的时间，用于计算核心利用率
+    // CPU分流：NPU任务队列积压超过阈值时，由OpenCV DNN实例在CPU上处理多出的帧
+    std::vector<std::shared_ptr<Yolov5>> cpu_instances_; // CPU模型实例
+    std::condition_variable cv_spill_;                    // 唤醒CPU线程，和cv_task分开，避免抢走NPU线程的通知
+    std::string spill_model_path_;                        // CPU实例使用的ONNX模型
+    int spill_threads_;                                   // CPU实例数量，0表示不分流
+    size_t spill_threshold_;                              // 队列深度超过该值时分流
+    uint64_t spilled_frames_;                             // 分流到CPU的帧数（mtx1保护）
+    // 运动门限：静止的帧不推理，沿用最近一次推理的检测结果
+    std::unique_ptr<MotionGate> motion_gate_;             // 为空表示不开启，只在提交任务的线程中使用
+    std::vector<Detection> last_detections_;              // 最近一次推理的检测结果（mtx2保护）
+    int last_detections_id_;                              // last_detections_对应的帧号（推理过的帧）
+
+    nn_core_mask_e coreMaskFor(int index); // 第index个实例的核心掩码
 
     void worker(int id);
+    void workerAsync(int id);                                           // 异步推理的线程函数
+    void workerCPU(int id);                                             // CPU分流的线程函数
+    void pushTask(FrameTask &task);                                     // 任务放入队列并唤醒工作线程
+    void reuseLastResult(FrameTask &task);                              // 静止的帧直接沿用最近一次的检测结果
+    void runTask(Yolov5 &instance, FrameTask &task, std::vector<Detection> &detections); // 按任务的格式运行模型
+    void saveResult(FrameTask &task, std::vector<Detection> &detections, bool inferred); // 保存一帧的结果，inferred表示结果来自推理
 
 public:
     Yolov5ThreadPool();
     ~Yolov5ThreadPool();
 
-    nn_error_e setUp(std::string &model_path, int num_threads = 12);     // 初始化
+    void setNPUPlacement(npu_placement_e placement,
+                         const std::vector<nn_core_mask_e> &core_masks = std::vector<nn_core_mask_e>()); // 设置NPU核心分配策略，需要在setUp之前调用
+    void setCPUSpill(const std::string &onnx_path, int num_threads = 2,
+                     int queue_threshold = 4); // 开启CPU分流，需要在setUp之前调用
+    void setMotionGate(int pixel_thresh = 25, float motion_ratio = 0.002f,
+                       int max_skip = 30); // 开启运动门限，静止画面跳过推理
+    nn_error_e setUp(std::string &model_path, int num_threads = 12,
+                     const Yolov5Config &config = Yolov5Config());       // 初始化
     nn_error_e submitTask(const cv::Mat &img, int id);                   // 提交任务
+    nn_error_e submitTask(const yuv_frame_s &frame, int id);             // 提交任务，输入为解码器输出的YUV420帧（会拷贝一份）
     nn_error_e getTargetResult(std::vector<Detection> &objects, int id); // 获取结果
     nn_error_e getTargetImgResult(cv::Mat &img, int id);                 // 获取结果（图片）
     void stopAll();                                                      // 停止所有线程
+    void printNPUUsage();                                                // 打印每个NPU核心的利用率
 };
 
 #endif // RK3588_DEMO_YOLOV5_THREAD_POOL_H
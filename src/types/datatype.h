@@ -47,6 +47,25 @@ typedef struct
     void *data;
 } tensor_data_s;
 
+// YUV420图像格式
+typedef enum
+{
+    NN_YUV_NV12 = 0, // Y平面 + 交错的UV平面（硬件解码器的常用输出）
+    NN_YUV_I420 = 1, // Y平面 + U平面 + V平面
+} yuv_format_e;
+
+// 一帧YUV420图像，数据由调用者持有；各平面连续存放，UV平面紧跟在Y平面之后（和MPP解码器的输出一致）
+typedef struct
+{
+    yuv_format_e format;
+    int width;      // 图像宽度
+    int height;     // 图像高度
+    int hor_stride; // Y平面每行的字节数，NV12的UV平面相同，I420的U/V平面为一半
+    int ver_stride; // Y平面的行数（对齐后）
+    uint8_t *data;  // Y平面起始地址
+    int fd;         // dma-buf fd，RGA可以直接使用；没有时为-1
+} yuv_frame_s;
+
 
 
 static size_t nn_tensor_type_to_size(tensor_datatype_e type)
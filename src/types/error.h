@@ -18,6 +18,12 @@ typedef enum
     NN_RKNN_MODEL_NOT_LOAD = -10,   // rknn模型未加载
     NN_STOPED = -11,                // 程序已停止
     NN_TIMEOUT = -12,          // 超时
+    NN_NOT_SUPPORTED = -13,         // 当前引擎不支持该操作
+    NN_MEM_ALLOC_FAIL = -14,        // 内存分配失败
+    NN_ASYNC_HANDLE_INVALID = -15,  // 异步推理句柄无效或在途任务已满
+    NN_FILE_WRITE_FAIL = -16,       // 写文件失败
+    NN_RGA_PROCESS_FAIL = -17,      // RGA处理失败
+    NN_IMG_INPUT_ERROR = -18,       // 输入图像数据无效
 } nn_error_e;
 
 #endif // RK3588_DEMO_ERROR_H
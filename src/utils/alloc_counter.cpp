@@ -0,0 +1,159 @@
+// alloc_counter.h的实现
+
+#include "alloc_counter.h"
+
+#include <stdlib.h>
+
+#include <new>
+
+static thread_local uint64_t g_alloc_count = 0; // 当前线程的分配次数
+
+#ifdef NN_ENABLE_ALLOC_COUNTER
+
+// 替换全局operator new/delete，只计数，实际分配仍然交给malloc
+void *operator new(size_t size)
+{
+    g_alloc_count++;
+    void *ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+// nothrow版本：失败时返回空指针
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    g_alloc_count++;
+    return malloc(size == 0 ? 1 : size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    free(ptr);
+}
+
+#ifdef __cpp_aligned_new
+// 对齐版本（C++17，alignas大于16的类型使用），posix_memalign分配的内存同样用free释放
+static void *aligned_malloc(size_t size, std::align_val_t align)
+{
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, (size_t)align, size == 0 ? 1 : size) != 0)
+    {
+        return nullptr;
+    }
+    return ptr;
+}
+
+void *operator new(size_t size, std::align_val_t align)
+{
+    g_alloc_count++;
+    void *ptr = aligned_malloc(size, align);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size, std::align_val_t align)
+{
+    return operator new(size, align);
+}
+
+void *operator new(size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    g_alloc_count++;
+    return aligned_malloc(size, align);
+}
+
+void *operator new[](size_t size, std::align_val_t align, const std::nothrow_t &) noexcept
+{
+    return operator new(size, align, std::nothrow);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    free(ptr);
+}
+#endif // __cpp_aligned_new
+
+bool nn_alloc_counter_enabled()
+{
+    return true;
+}
+
+#else
+
+bool nn_alloc_counter_enabled()
+{
+    return false;
+}
+
+#endif // NN_ENABLE_ALLOC_COUNTER
+
+uint64_t nn_alloc_count()
+{
+    return g_alloc_count;
+}
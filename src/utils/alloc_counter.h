@@ -0,0 +1,24 @@
+// 堆内存分配计数，用于验证热路径上没有内存分配
+
+#ifndef RK3588_DEMO_ALLOC_COUNTER_H
+#define RK3588_DEMO_ALLOC_COUNTER_H
+
+#include <stdint.h>
+
+// 编译时打开ENABLE_ALLOC_COUNTER后，会替换全局operator new，统计每个线程的分配次数
+// 未打开时计数始终为0
+bool nn_alloc_counter_enabled();    // 是否启用了分配计数
+uint64_t nn_alloc_count();          // 当前线程累计的operator new调用次数
+
+// 统计一段代码内当前线程的分配次数
+class AllocCounterScope
+{
+public:
+    AllocCounterScope() : start_(nn_alloc_count()){};
+    uint64_t Count() const { return nn_alloc_count() - start_; } // 构造以来的分配次数
+
+private:
+    uint64_t start_;
+};
+
+#endif // RK3588_DEMO_ALLOC_COUNTER_H
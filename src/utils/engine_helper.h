@@ -14,38 +14,6 @@
 #include "utils/logging.h"
 #include "types/datatype.h"
 
-/**
- * @brief 加载模型文件
- * @param filename 模型文件路径
- * @param model_size 模型文件大小，会在函数内部赋值
- * @return unsigned char* 模型文件数据
- */
-static unsigned char *load_model(const char *filename, int *model_size)
-{
-    FILE *fp = fopen(filename, "rb");
-    if (fp == nullptr)
-    {
-        NN_LOG_ERROR("fopen %s fail!", filename);
-        return nullptr;
-    }
-    fseek(fp, 0, SEEK_END);
-    int model_len = ftell(fp);
-    unsigned char *model = (unsigned char *)malloc(model_len);
-    fseek(fp, 0, SEEK_SET);
-    if (model_len != fread(model, 1, model_len, fp))
-    {
-        NN_LOG_ERROR("fread %s fail!", filename);
-        free(model);
-        return nullptr;
-    }
-    *model_size = model_len;
-    if (fp)
-    {
-        fclose(fp);
-    }
-    return model;
-}
-
 static void print_tensor_attr(rknn_tensor_attr *attr)
 {
     NN_LOG_INFO("  index=%d, name=%s, n_dims=%d, dims=[%d, %d, %d, %d], n_elems=%d, size=%d, fmt=%s, type=%s, qnt_type=%s, "
@@ -0,0 +1,72 @@
+// model_cache.h的实现
+
+#include "model_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utils/logging.h"
+
+ModelBlob::~ModelBlob()
+{
+    if (data_ != nullptr)
+    {
+        munmap(data_, size_);
+        NN_LOG_DEBUG("model %s unmapped", path_.c_str());
+    }
+}
+
+ModelBlobCache &ModelBlobCache::Instance()
+{
+    static ModelBlobCache cache;
+    return cache;
+}
+
+/**
+ * @brief 获取模型文件的只读映射，同一路径在映射存活期间只会映射一次
+ * @param path 模型文件路径
+ * @return std::shared_ptr<ModelBlob> 模型文件映射，失败返回空
+ */
+std::shared_ptr<ModelBlob> ModelBlobCache::Acquire(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto it = blobs_.find(path);
+    if (it != blobs_.end())
+    {
+        auto blob = it->second.lock();
+        if (blob != nullptr)
+        {
+            NN_LOG_DEBUG("model %s cache hit", path.c_str());
+            return blob;
+        }
+        blobs_.erase(it);
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        NN_LOG_ERROR("open %s fail!", path.c_str());
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        NN_LOG_ERROR("stat %s fail!", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后文件描述符就可以关闭了
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        NN_LOG_ERROR("mmap %s fail!", path.c_str());
+        return nullptr;
+    }
+    auto blob = std::make_shared<ModelBlob>(path, data, (size_t)st.st_size);
+    blobs_[path] = blob;
+    NN_LOG_INFO("model %s mapped, size: %.2fMB", path.c_str(), st.st_size / 1024.0 / 1024.0);
+    return blob;
+}
@@ -0,0 +1,45 @@
+// 模型文件缓存：只读mmap模型文件，相同路径的引擎共享同一份映射
+
+#ifndef RK3588_DEMO_MODEL_CACHE_H
+#define RK3588_DEMO_MODEL_CACHE_H
+
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// 一个只读映射的模型文件，最后一个引用释放时解除映射
+class ModelBlob
+{
+public:
+    ModelBlob(const std::string &path, void *data, size_t size) : path_(path), data_(data), size_(size){};
+    ~ModelBlob();
+
+    void *Data() const { return data_; }                 // 模型数据（只读）
+    size_t Size() const { return size_; }                // 模型大小（字节）
+    const std::string &Path() const { return path_; }    // 模型文件路径
+
+private:
+    std::string path_;
+    void *data_;
+    size_t size_;
+};
+
+// 进程内的模型文件缓存：只保存弱引用，使用同一模型的引擎都初始化完成、释放引用后映射即被解除
+class ModelBlobCache
+{
+public:
+    static ModelBlobCache &Instance();
+
+    std::shared_ptr<ModelBlob> Acquire(const std::string &path); // 获取模型文件映射，失败返回空
+
+private:
+    ModelBlobCache(){};
+
+    std::mutex mtx_;
+    std::map<std::string, std::weak_ptr<ModelBlob>> blobs_;
+};
+
+#endif // RK3588_DEMO_MODEL_CACHE_H
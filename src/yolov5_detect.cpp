@@ -46,6 +46,7 @@ void get_results(int width = 1280, int height = 720, int fps = 30)
         if (elapsed_all_2 > 1000)
         {
             NN_LOG_INFO("Method2 Time:%fms, FPS:%f, Frame Count:%d", elapsed_all_2, frame_count / (elapsed_all_2 / 1000.0f), frame_count);
+            g_pool->printNPUUsage();
             frame_count = 0;
             start_all = std::chrono::high_resolution_clock::now();
         }
@@ -96,7 +97,28 @@ int main(int argc, char **argv)
 
     // 创建线程池实例并设置线程池
     g_pool = new Yolov5ThreadPool();
-    g_pool->setUp(model_file, num_threads);
+    // 实例依次绑定到3个NPU核心，避免多个实例挤在同一个核心上
+    g_pool->setNPUPlacement(NPU_PLACEMENT_ROUND_ROBIN);
+    // 传入录制文件（.nncap）时使用回放后端，可以在没有NPU的机器上运行整个流程；传入ONNX模型时在CPU上运行
+    Yolov5Config config;
+    auto has_ext = [](const std::string &path, const std::string &ext)
+    {
+        return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+    };
+    if (has_ext(model_file, ".nncap"))
+    {
+        config.backend = NN_BACKEND_REPLAY;
+    }
+    else if (has_ext(model_file, ".onnx"))
+    {
+        config.backend = NN_BACKEND_OPENCV_DNN;
+    }
+    // 第4个参数为等价的ONNX模型时，NPU处理不过来的帧分流到CPU
+    if (argc > 4)
+    {
+        g_pool->setCPUSpill(argv[4]);
+    }
+    g_pool->setUp(model_file, num_threads, config);
 
     // 创建并启动读取视频流的线程
     std::thread read_stream_thread(read_stream, video_file);
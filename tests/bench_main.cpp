@@ -0,0 +1,38 @@
+// 性能测试入口：nn_bench [name...]，不带参数时运行所有性能测试
+// 只打印耗时，不判断快慢；在板子上和x86上分别运行对比
+
+#include "nn_test.h"
+
+#include <string.h>
+
+static bool selected(int argc, char **argv, const char *name)
+{
+    if (argc <= 1)
+    {
+        return true;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    for (auto &bench : nn_bench_registry())
+    {
+        if (!selected(argc, argv, bench.name))
+        {
+            continue;
+        }
+        printf("[ BENCH ] %s\n", bench.name);
+        fflush(stdout);
+        nn_test_reset();
+        bench.func();
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+// NMS的性能测试：按类别分桶的finish_detections和原来逐类别遍历全部候选框的NMS对比
+
+#include "nn_test.h"
+
+#include <random>
+
+#include "legacy_nms.h"
+#include "process/yolov5_postprocess.h"
+
+static const int g_model_size = 640;
+
+// 拥挤画面的候选框：每个目标在相邻网格和anchor上产生5个抖动的框，类别在class_num个中随机
+static void make_candidates(int object_num, int class_num, yolov5::PostprocessContext &ctx)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> pos(0.f, g_model_size - 80.f);
+    std::uniform_real_distribution<float> size(10.f, 80.f);
+    std::uniform_real_distribution<float> jitter(-3.f, 3.f);
+    std::uniform_real_distribution<float> prob(0.2f, 1.f);
+    std::uniform_int_distribution<int> cls(0, class_num - 1);
+    ctx.Clear();
+    for (int o = 0; o < object_num; o++)
+    {
+        float x = pos(rng);
+        float y = pos(rng);
+        float w = size(rng);
+        float h = size(rng);
+        int class_id = cls(rng);
+        for (int k = 0; k < 5; k++)
+        {
+            float box[4] = {x + jitter(rng), y + jitter(rng), w + jitter(rng), h + jitter(rng)};
+            ctx.boxes.insert(ctx.boxes.end(), box, box + 4);
+            ctx.probs.push_back(prob(rng));
+            ctx.class_ids.push_back(class_id);
+        }
+    }
+}
+
+// 候选框数量从稀疏到拥挤（最多2000个目标、1万个候选框），类别少（如只检测人和车）和COCO 80类两种分布；
+// 原实现会在原地排序置信度，每次先拷贝一份（预分配，不计分配）
+NN_BENCH(nms_bucketed_vs_per_class)
+{
+    const int object_nums[] = {10, 50, 200, 1000, 2000};
+    const int class_nums[] = {2, 80};
+    for (int class_num : class_nums)
+    {
+        for (int object_num : object_nums)
+        {
+            yolov5::PostprocessContext ctx;
+            make_candidates(object_num, class_num, ctx);
+            int valid_count = ctx.probs.size();
+            std::vector<float> probs = ctx.probs;
+            int legacy_count = 0;
+            int iters = object_num >= 2000 ? 2 : (object_num >= 1000 ? 5 : 50);
+            double legacy_us = nn_bench_us(iters, [&]() {
+                std::copy(ctx.probs.begin(), ctx.probs.end(), probs.begin());
+                legacy_count = legacy_finish(valid_count, ctx.boxes, probs, ctx.class_ids, NMS_THRESH);
+            });
+            yolov5::detect_result_group_t group;
+            double bucketed_us = nn_bench_us(iters, [&]() {
+                yolov5::finish_detections(valid_count, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f, 0,
+                                          &group);
+            });
+            double top_k_us = nn_bench_us(iters, [&]() {
+                yolov5::finish_detections(valid_count, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f,
+                                          PRE_NMS_TOP_K, &group);
+            });
+            printf("  %d classes, %d candidates: per-class %.1fus (%d kept), bucketed %.1fus, bucketed top-%d "
+                   "%.1fus (%d kept)\n",
+                   class_num, valid_count, legacy_us, legacy_count, bucketed_us, PRE_NMS_TOP_K, top_k_us,
+                   group.count);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+// 后处理的性能测试：640x640模型的三个int8输出，分别用稀疏和拥挤的合成数据；以及objectness预筛选
+
+#include "nn_test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "process/yolov5_postprocess.h"
+#include "test_util.h"
+
+static const int g_model_size = 640;
+
+// 一组后处理输入：NCHW输出、同样数据的NHWC版本和量化参数
+struct PostprocessInput
+{
+    std::vector<std::vector<int8_t>> nchw;
+    std::vector<std::vector<int8_t>> nhwc;
+    std::vector<int32_t> zps;
+    std::vector<float> scales;
+    std::vector<int> cell_strides;
+    yolov5::DECODE_LUT luts[3];
+    yolov5::GRID_SIZE grids[3];
+};
+
+static void make_input(float hit_ratio, PostprocessInput &input)
+{
+    auto shapes = nn_test_yolo_output_shapes(g_model_size, g_model_size);
+    input.nchw = nn_test_random_yolo_outputs(g_model_size, g_model_size, hit_ratio, 1234);
+    input.nhwc.clear();
+    input.zps.clear();
+    input.scales.clear();
+    input.cell_strides.clear();
+    for (int i = 0; i < 3; i++)
+    {
+        int c = shapes[i].dims[1];
+        int h = shapes[i].dims[2];
+        int w = shapes[i].dims[3];
+        // NPU原生布局的通道按16对齐
+        int cell_stride = (c + 15) / 16 * 16;
+        std::vector<int8_t> nhwc((size_t)h * w * cell_stride, -128);
+        for (int ch = 0; ch < c; ch++)
+        {
+            for (int cell = 0; cell < h * w; cell++)
+            {
+                nhwc[(size_t)cell * cell_stride + ch] = input.nchw[i][(size_t)ch * h * w + cell];
+            }
+        }
+        input.nhwc.push_back(nhwc);
+        input.zps.push_back(shapes[i].zp);
+        input.scales.push_back(shapes[i].scale);
+        input.cell_strides.push_back(cell_stride);
+        yolov5::build_decode_lut(shapes[i].zp, shapes[i].scale, &input.luts[i]);
+        input.grids[i] = {h, w};
+    }
+}
+
+// NHWC布局逐网格读取连续的通道，NCHW布局先在objectness平面上预筛选
+NN_BENCH(postprocess_nchw_vs_nhwc)
+{
+    const float hit_ratios[] = {0.001f, 0.02f};
+    for (float hit_ratio : hit_ratios)
+    {
+        PostprocessInput input;
+        make_input(hit_ratio, input);
+        yolov5::PostprocessContext ctx;
+        ctx.Reserve(input.grids);
+        yolov5::detect_result_group_t group;
+        double nchw_us = nn_bench_us(200, [&]() {
+            yolov5::post_process(input.nchw[0].data(), input.nchw[1].data(), input.nchw[2].data(), g_model_size,
+                                 g_model_size, BOX_THRESH, NMS_THRESH, 1.f, 1.f, input.zps, input.scales, input.luts,
+                                 input.grids, &group, PRE_NMS_TOP_K, &ctx);
+        });
+        int nchw_count = group.count;
+        double nhwc_us = nn_bench_us(200, [&]() {
+            yolov5::post_process_nhwc(input.nhwc[0].data(), input.nhwc[1].data(), input.nhwc[2].data(), g_model_size,
+                                      g_model_size, BOX_THRESH, NMS_THRESH, 1.f, 1.f, input.zps, input.scales,
+                                      input.luts, input.cell_strides, input.grids, &group, PRE_NMS_TOP_K, &ctx);
+        });
+        printf("  hit ratio %.3f: nchw %.1fus, nhwc %.1fus (%d/%d detections)\n", hit_ratio, nchw_us, nhwc_us,
+               nchw_count, group.count);
+    }
+}
+
+// objectness预筛选：80x80的平面，NEON/SSE2一次比较64个字节和逐个比较对比
+NN_BENCH(prescan_simd_vs_scalar)
+{
+    const int n = 80 * 80;
+    const float hit_ratios[] = {0.001f, 0.02f, 0.2f};
+    std::vector<int> indices(n);
+    for (float hit_ratio : hit_ratios)
+    {
+        std::vector<int8_t> conf(n, -128);
+        srand(1234);
+        for (int i = 0; i < n; i++)
+        {
+            if (rand() < hit_ratio * RAND_MAX)
+            {
+                conf[i] = 10;
+            }
+        }
+        int count = 0;
+        double simd_us = nn_bench_us(2000, [&]() { count = yolov5::prescan_objectness(conf.data(), n, 0, indices.data()); });
+        yolov5::postprocess_enable_simd(false);
+        double scalar_us = nn_bench_us(2000, [&]() { yolov5::prescan_objectness(conf.data(), n, 0, indices.data()); });
+        yolov5::postprocess_enable_simd(true);
+        printf("  hit ratio %.3f: simd %.2fus, scalar %.2fus (%d candidates)\n", hit_ratio, simd_us, scalar_us, count);
+    }
+}
@@ -0,0 +1,104 @@
+// 预处理的性能测试：720p/1080p/4K的BGR图像letterbox到640x640，插值表缓存的效果，以及RGA读取原图的方式
+
+#include "nn_test.h"
+
+#include <string.h>
+
+#include "process/image_processor.h"
+#include "process/preprocess.h"
+
+static const int g_model_size = 640;
+
+// letterbox + cvimg2tensor、融合letterbox（标量和NEON/SSE2），都复用scratch，只计稳定视频流的逐帧耗时
+NN_BENCH(letterbox_fused_vs_opencv)
+{
+    const cv::Size image_sizes[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    std::vector<uint8_t> buf((size_t)g_model_size * g_model_size * 3);
+    tensor_data_s tensor;
+    memset(&tensor, 0, sizeof(tensor));
+    tensor.data = buf.data();
+    for (const cv::Size &size : image_sizes)
+    {
+        cv::Mat img(size, CV_8UC3);
+        cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+        ScratchArena scratch;
+        cv::Mat img_letterbox;
+        double opencv_us = nn_bench_us(50, [&]() {
+            letterbox(img, img_letterbox, 1.f, &scratch);
+            cvimg2tensor(img_letterbox, g_model_size, g_model_size, tensor, &scratch);
+        });
+        double resize_us = nn_bench_us(50, [&]() { letterbox_resize(img, g_model_size, g_model_size, tensor); });
+        letterbox_fused_enable_simd(false);
+        double scalar_us = nn_bench_us(50, [&]() {
+            letterbox_fused(img, g_model_size, g_model_size, tensor, LETTERBOX_RESIZE_PAD, &scratch);
+        });
+        letterbox_fused_enable_simd(true);
+        double fused_us = nn_bench_us(50, [&]() {
+            letterbox_fused(img, g_model_size, g_model_size, tensor, LETTERBOX_RESIZE_PAD, &scratch);
+        });
+        double fused_pad_us = nn_bench_us(50, [&]() {
+            letterbox_fused(img, g_model_size, g_model_size, tensor, LETTERBOX_PAD_RESIZE, &scratch);
+        });
+        printf("  %dx%d: letterbox+cvimg2tensor %.1fus, letterbox_resize %.1fus, fused scalar %.1fus, "
+               "fused %.1fus, fused pad_resize %.1fus\n",
+               size.width, size.height, opencv_us, resize_us, scalar_us, fused_us, fused_pad_us);
+    }
+}
+
+// 融合letterbox的插值表缓存：同一个scratch逐帧复用插值表，和每帧新建scratch（重新计算插值表）对比；
+// cv::resize INTER_LINEAR只缩放到内容区域，不含颜色转换和补边
+NN_BENCH(fused_cached_taps_vs_cv_resize)
+{
+    const cv::Size image_sizes[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    std::vector<uint8_t> buf((size_t)g_model_size * g_model_size * 3);
+    tensor_data_s tensor;
+    memset(&tensor, 0, sizeof(tensor));
+    tensor.data = buf.data();
+    for (const cv::Size &size : image_sizes)
+    {
+        cv::Mat img(size, CV_8UC3);
+        cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+        LetterBoxInfo info = letterbox_info(size.width, size.height, g_model_size, g_model_size, LETTERBOX_RESIZE_PAD);
+        cv::Size content = letterbox_content_rect(info, size.width, size.height).size();
+        cv::Mat resized;
+        double cv_resize_us = nn_bench_us(50, [&]() { cv::resize(img, resized, content, 0, 0, cv::INTER_LINEAR); });
+        ScratchArena scratch;
+        double cached_us = nn_bench_us(50, [&]() {
+            letterbox_fused(img, g_model_size, g_model_size, tensor, LETTERBOX_RESIZE_PAD, &scratch);
+        });
+        double rebuilt_us = nn_bench_us(50, [&]() {
+            ScratchArena fresh;
+            letterbox_fused(img, g_model_size, g_model_size, tensor, LETTERBOX_RESIZE_PAD, &fresh);
+        });
+        printf("  %dx%d -> %dx%d: cv::resize %.1fus, fused cached taps %.1fus, fused rebuilt taps %.1fus "
+               "(table hits %llu, misses %llu)\n",
+               size.width, size.height, content.width, content.height, cv_resize_us, cached_us, rebuilt_us,
+               (unsigned long long)scratch.Hits(), (unsigned long long)scratch.Misses());
+    }
+}
+
+// RGA读取原图的两种方式：拷贝到复用的DMA-heap内存（默认），和每帧导入原图的虚拟地址（映射一次页表）
+NN_BENCH(rga_copy_vs_import_src)
+{
+    auto copy = CreateRGAImageProcessor(false);
+    auto import = CreateRGAImageProcessor(true);
+    if (copy == nullptr || import == nullptr)
+    {
+        NN_SKIP("rga not available");
+    }
+    const cv::Size image_sizes[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+    std::vector<uint8_t> buf((size_t)g_model_size * g_model_size * 3);
+    tensor_data_s tensor;
+    memset(&tensor, 0, sizeof(tensor));
+    tensor.data = buf.data();
+    LetterBoxInfo info;
+    for (const cv::Size &size : image_sizes)
+    {
+        cv::Mat img(size, CV_8UC3);
+        cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+        double copy_us = nn_bench_us(50, [&]() { copy->Letterbox(img, g_model_size, g_model_size, tensor, info); });
+        double import_us = nn_bench_us(50, [&]() { import->Letterbox(img, g_model_size, g_model_size, tensor, info); });
+        printf("  %dx%d: dma copy %.1fus, import virtual address %.1fus\n", size.width, size.height, copy_us,
+               import_us);
+    }
+}
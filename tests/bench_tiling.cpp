@@ -0,0 +1,49 @@
+// 切片推理的性能测试：回放引擎不模拟推理耗时，只计切片的预处理、后处理和合并，输出切片/秒
+
+#include "nn_test.h"
+
+#include "task/yolov5.h"
+#include "test_util.h"
+
+NN_BENCH(tiled_tiles_per_second)
+{
+    const int model_size = 640;
+    std::string path = nn_test_temp_path("bench_tiling.cap");
+    // 每个切片两个目标，合并时有框需要比较
+    if (!nn_test_write_yolo_capture(path, model_size, model_size, {{{10, 20, 0}, {40, 40, 2}}}))
+    {
+        printf("  write capture failed\n");
+        return;
+    }
+    const cv::Size frame_sizes[] = {{1920, 1080}, {3840, 2160}};
+    for (const cv::Size &size : frame_sizes)
+    {
+        Yolov5Config config;
+        config.backend = NN_BACKEND_REPLAY;
+        config.tiled = true;
+        Yolov5 yolo(config);
+        if (yolo.LoadModel(path.c_str()) != NN_SUCCESS)
+        {
+            printf("  load capture failed\n");
+            return;
+        }
+        cv::Mat img(size, CV_8UC3);
+        cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+        std::vector<Detection> objects;
+        yolo.Run(img, objects); // 预热：插值表和缓冲区
+        uint64_t tiles_before = 0;
+        uint64_t busy_before = 0;
+        yolo.GetTileStats(tiles_before, busy_before);
+        for (int i = 0; i < 20; i++)
+        {
+            yolo.Run(img, objects);
+        }
+        uint64_t tiles = 0;
+        uint64_t busy_us = 0;
+        yolo.GetTileStats(tiles, busy_us);
+        tiles -= tiles_before;
+        busy_us -= busy_before;
+        printf("  %dx%d: %lu tiles/frame, %.1f tiles/s, %.1fms/frame\n", size.width, size.height,
+               (unsigned long)(tiles / 20), tiles * 1e6 / busy_us, busy_us / 20 / 1000.0);
+    }
+}
@@ -0,0 +1,126 @@
+// legacy_nms.h的实现：改为分桶之前的NMS，除了返回保留的下标外原样保留
+
+#include "legacy_nms.h"
+
+#include <math.h>
+
+#include <set>
+
+#include "process/yolov5_postprocess.h"
+
+static float legacy_overlap(float xmin0, float ymin0, float xmax0, float ymax0, float xmin1, float ymin1, float xmax1,
+                            float ymax1)
+{
+    float w = fmax(0.f, fmin(xmax0, xmax1) - fmax(xmin0, xmin1) + 1.0);
+    float h = fmax(0.f, fmin(ymax0, ymax1) - fmax(ymin0, ymin1) + 1.0);
+    float i = w * h;
+    float u = (xmax0 - xmin0 + 1.0) * (ymax0 - ymin0 + 1.0) + (xmax1 - xmin1 + 1.0) * (ymax1 - ymin1 + 1.0) - i;
+    return u <= 0.f ? 0.f : (i / u);
+}
+
+static int legacy_nms(int validCount, std::vector<float> &outputLocations, std::vector<int> classIds,
+                      std::vector<int> &order, int filterId, float threshold)
+{
+    for (int i = 0; i < validCount; ++i)
+    {
+        if (order[i] == -1 || classIds[i] != filterId)
+        {
+            continue;
+        }
+        int n = order[i];
+        for (int j = i + 1; j < validCount; ++j)
+        {
+            int m = order[j];
+            if (m == -1 || classIds[i] != filterId)
+            {
+                continue;
+            }
+            float xmin0 = outputLocations[n * 4 + 0];
+            float ymin0 = outputLocations[n * 4 + 1];
+            float xmax0 = outputLocations[n * 4 + 0] + outputLocations[n * 4 + 2];
+            float ymax0 = outputLocations[n * 4 + 1] + outputLocations[n * 4 + 3];
+
+            float xmin1 = outputLocations[m * 4 + 0];
+            float ymin1 = outputLocations[m * 4 + 1];
+            float xmax1 = outputLocations[m * 4 + 0] + outputLocations[m * 4 + 2];
+            float ymax1 = outputLocations[m * 4 + 1] + outputLocations[m * 4 + 3];
+
+            float iou = legacy_overlap(xmin0, ymin0, xmax0, ymax0, xmin1, ymin1, xmax1, ymax1);
+
+            if (iou > threshold)
+            {
+                order[j] = -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int legacy_quick_sort_indice_inverse(std::vector<float> &input, int left, int right, std::vector<int> &indices)
+{
+    float key;
+    int key_index;
+    int low = left;
+    int high = right;
+    if (left < right)
+    {
+        key_index = indices[left];
+        key = input[left];
+        while (low < high)
+        {
+            while (low < high && input[high] <= key)
+            {
+                high--;
+            }
+            input[low] = input[high];
+            indices[low] = indices[high];
+            while (low < high && input[low] >= key)
+            {
+                low++;
+            }
+            input[high] = input[low];
+            indices[high] = indices[low];
+        }
+        input[low] = key;
+        indices[low] = key_index;
+        legacy_quick_sort_indice_inverse(input, left, low - 1, indices);
+        legacy_quick_sort_indice_inverse(input, low + 1, right, indices);
+    }
+    return low;
+}
+
+// 排序后对出现过的每个类别遍历全部候选框，返回保留的数量（最多OBJ_NUMB_MAX_SIZE），
+// kept不为空时按置信度从高到低写入保留的候选框下标
+int legacy_finish(int validCount, std::vector<float> &filterBoxes, std::vector<float> &objProbs,
+                  std::vector<int> &classId, float nms_threshold, std::vector<int> *kept)
+{
+    std::vector<int> indexArray;
+    for (int i = 0; i < validCount; ++i)
+    {
+        indexArray.push_back(i);
+    }
+    legacy_quick_sort_indice_inverse(objProbs, 0, validCount - 1, indexArray);
+    std::set<int> class_set(std::begin(classId), std::end(classId));
+    for (auto c : class_set)
+    {
+        legacy_nms(validCount, filterBoxes, classId, indexArray, c, nms_threshold);
+    }
+    if (kept != nullptr)
+    {
+        kept->clear();
+    }
+    int last_count = 0;
+    for (int i = 0; i < validCount; ++i)
+    {
+        if (indexArray[i] == -1 || last_count >= OBJ_NUMB_MAX_SIZE)
+        {
+            continue;
+        }
+        if (kept != nullptr)
+        {
+            kept->push_back(indexArray[i]);
+        }
+        last_count++;
+    }
+    return last_count;
+}
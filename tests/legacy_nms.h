@@ -0,0 +1,14 @@
+// 改为分桶之前的NMS实现，性能测试和结果对比共用
+
+#ifndef RK3588_DEMO_LEGACY_NMS_H
+#define RK3588_DEMO_LEGACY_NMS_H
+
+#include <vector>
+
+// 原实现：置信度原地排序（会改写objProbs），对出现过的每个类别遍历全部候选框做NMS。
+// 注意原实现按排序后的位置取类别（classIds[i]而不是classIds[n]），
+// 并且内层循环不检查被比较框的类别，只有单一类别或重叠的框类别相同时才和按类别NMS一致
+int legacy_finish(int validCount, std::vector<float> &filterBoxes, std::vector<float> &objProbs,
+                  std::vector<int> &classId, float nms_threshold, std::vector<int> *kept = nullptr);
+
+#endif // RK3588_DEMO_LEGACY_NMS_H
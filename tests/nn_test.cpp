@@ -0,0 +1,57 @@
+// nn_test.h的实现，nn_tests和nn_bench共用
+
+#include "nn_test.h"
+
+static int g_failures = 0;   // 当前测试的失败次数
+static bool g_skipped = false; // 当前测试是否被跳过
+
+std::vector<nn_test_case_s> &nn_test_registry()
+{
+    static std::vector<nn_test_case_s> registry;
+    return registry;
+}
+
+std::vector<nn_test_case_s> &nn_bench_registry()
+{
+    static std::vector<nn_test_case_s> registry;
+    return registry;
+}
+
+void nn_test_fail(const char *file, int line, const char *expr)
+{
+    printf("  %s:%d: check failed: %s\n", file, line, expr);
+    g_failures++;
+}
+
+void nn_test_skip(const char *reason)
+{
+    printf("  skipped: %s\n", reason);
+    g_skipped = true;
+}
+
+void nn_test_reset()
+{
+    g_failures = 0;
+    g_skipped = false;
+}
+
+int nn_test_failures()
+{
+    return g_failures;
+}
+
+bool nn_test_skipped()
+{
+    return g_skipped;
+}
+
+double nn_bench_us(int iters, const std::function<void()> &func)
+{
+    func(); // 预热：第一次调用会分配缓冲区、建立查找表
+    NNTimer timer;
+    for (int i = 0; i < iters; i++)
+    {
+        func();
+    }
+    return timer.ElapsedUs() / iters;
+}
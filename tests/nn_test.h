@@ -0,0 +1,94 @@
+// 单元测试和性能测试共用的最小框架，不依赖第三方测试库
+//
+// NN_TEST(suite, name)注册一个测试，nn_tests <suite>只运行该组测试（每组对应一个ctest用例）
+// NN_CHECK失败时打印位置并继续，NN_ASSERT失败时结束当前测试，NN_SKIP跳过当前测试（例如缺少硬件）
+// NN_BENCH(name)注册一个性能测试，由nn_bench运行并打印耗时
+
+#ifndef RK3588_DEMO_NN_TEST_H
+#define RK3588_DEMO_NN_TEST_H
+
+#include <stdio.h>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+typedef void (*nn_test_func)();
+
+typedef struct
+{
+    const char *suite;
+    const char *name;
+    nn_test_func func;
+} nn_test_case_s;
+
+std::vector<nn_test_case_s> &nn_test_registry();  // 所有注册的单元测试
+std::vector<nn_test_case_s> &nn_bench_registry(); // 所有注册的性能测试
+void nn_test_fail(const char *file, int line, const char *expr); // 记录一次检查失败
+void nn_test_skip(const char *reason);                         // 标记当前测试被跳过
+void nn_test_reset();                                          // 开始一个新的测试
+int nn_test_failures();                                        // 当前测试的失败次数
+bool nn_test_skipped();                                        // 当前测试是否被跳过
+
+struct NNTestRegistrar
+{
+    NNTestRegistrar(std::vector<nn_test_case_s> &registry, const char *suite, const char *name, nn_test_func func)
+    {
+        registry.push_back({suite, name, func});
+    }
+};
+
+#define NN_TEST(suite, name)                                                                                  \
+    static void nn_test_##suite##_##name();                                                                   \
+    static NNTestRegistrar nn_test_reg_##suite##_##name(nn_test_registry(), #suite, #name, nn_test_##suite##_##name); \
+    static void nn_test_##suite##_##name()
+
+#define NN_BENCH(name)                                                                            \
+    static void nn_bench_##name();                                                                \
+    static NNTestRegistrar nn_bench_reg_##name(nn_bench_registry(), "bench", #name, nn_bench_##name); \
+    static void nn_bench_##name()
+
+#define NN_CHECK(cond)                                   \
+    do                                                   \
+    {                                                    \
+        if (!(cond))                                     \
+        {                                                \
+            nn_test_fail(__FILE__, __LINE__, #cond);     \
+        }                                                \
+    } while (0)
+
+#define NN_ASSERT(cond)                                  \
+    do                                                   \
+    {                                                    \
+        if (!(cond))                                     \
+        {                                                \
+            nn_test_fail(__FILE__, __LINE__, #cond);     \
+            return;                                      \
+        }                                                \
+    } while (0)
+
+#define NN_SKIP(reason)       \
+    do                        \
+    {                         \
+        nn_test_skip(reason); \
+        return;               \
+    } while (0)
+
+// 计时工具：返回从构造开始经过的微秒数
+class NNTimer
+{
+public:
+    NNTimer() : start_(std::chrono::steady_clock::now()){};
+    double ElapsedUs() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count() / 1000.0;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 性能测试：预热一次后运行iters次，返回每次的平均耗时（微秒）
+double nn_bench_us(int iters, const std::function<void()> &func);
+
+#endif // RK3588_DEMO_NN_TEST_H
@@ -0,0 +1,220 @@
+// 分配计数和推理热路径零分配的测试，nn_tests总是打开NN_ENABLE_ALLOC_COUNTER编译
+
+#include "nn_test.h"
+
+#include <stdlib.h>
+
+#include <new>
+
+#include "engine/engine.h"
+#include "process/yolov5_postprocess.h"
+#include "task/yolov5.h"
+#include "test_util.h"
+#include "utils/alloc_counter.h"
+
+static void *volatile g_sink; // 让编译器不能省掉成对的new/delete
+
+// 所有形式的operator new都被计数
+NN_TEST(alloc, counts_every_operator_new)
+{
+    NN_ASSERT(nn_alloc_counter_enabled());
+    AllocCounterScope scope;
+    int *a = new int(1);
+    g_sink = a;
+    delete a;
+    NN_CHECK(scope.Count() == 1);
+    int *b = new int[4];
+    g_sink = b;
+    delete[] b;
+    NN_CHECK(scope.Count() == 2);
+    int *c = new (std::nothrow) int(1);
+    g_sink = c;
+    delete c;
+    NN_CHECK(scope.Count() == 3);
+    int *d = new (std::nothrow) int[4];
+    g_sink = d;
+    delete[] d;
+    NN_CHECK(scope.Count() == 4);
+#ifdef __cpp_aligned_new
+    struct alignas(64) Aligned
+    {
+        char data[64];
+    };
+    Aligned *e = new Aligned;
+    g_sink = e;
+    NN_CHECK(((uintptr_t)e & 63) == 0);
+    delete e;
+    Aligned *f = new (std::nothrow) Aligned[2];
+    g_sink = f;
+    delete[] f;
+    NN_CHECK(scope.Count() == 6);
+#endif
+}
+
+// 按模型属性准备输入输出缓冲区
+static void alloc_io(std::shared_ptr<NNEngine> engine, std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs)
+{
+    for (auto &shape : engine->GetInputShapes())
+    {
+        tensor_data_s tensor;
+        nn_tensor_attr_to_cvimg_input_data(shape, tensor);
+        tensor.data = calloc(1, tensor.attr.size);
+        inputs.push_back(tensor);
+    }
+    for (auto &shape : engine->GetOutputShapes())
+    {
+        tensor_data_s tensor;
+        tensor.attr = shape;
+        tensor.attr.size = shape.n_elems * nn_tensor_type_to_size(shape.type);
+        tensor.data = calloc(1, tensor.attr.size);
+        outputs.push_back(tensor);
+    }
+}
+
+static void free_io(std::vector<tensor_data_s> &inputs, std::vector<tensor_data_s> &outputs)
+{
+    for (auto &tensor : inputs)
+    {
+        free(tensor.data);
+    }
+    for (auto &tensor : outputs)
+    {
+        free(tensor.data);
+    }
+}
+
+// 预热之后，每次Run不再分配内存
+static void check_run_allocates_nothing(std::shared_ptr<NNEngine> engine)
+{
+    std::vector<tensor_data_s> inputs;
+    std::vector<tensor_data_s> outputs;
+    alloc_io(engine, inputs, outputs);
+    NN_CHECK(engine->Run(inputs, outputs, false) == NN_SUCCESS);
+    AllocCounterScope scope;
+    for (int i = 0; i < 10; i++)
+    {
+        NN_CHECK(engine->Run(inputs, outputs, false) == NN_SUCCESS);
+    }
+    NN_CHECK(scope.Count() == 0);
+    free_io(inputs, outputs);
+}
+
+NN_TEST(alloc, replay_run_allocates_nothing)
+{
+    std::string path = nn_test_temp_path("alloc_replay.cap");
+    std::vector<tensor_attr_s> in_shapes = {nn_test_attr(0, 1, 64, 64, 3, NN_TENSOR_UINT8, NN_TENSOR_NHWC)};
+    std::vector<tensor_attr_s> out_shapes = {nn_test_attr(0, 1, 255, 8, 8, NN_TENSOR_INT8, NN_TENSOR_NCHW),
+                                             nn_test_attr(1, 1, 255, 4, 4, NN_TENSOR_INT8, NN_TENSOR_NCHW)};
+    std::vector<std::vector<std::vector<int8_t>>> frames(3);
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        for (auto &shape : out_shapes)
+        {
+            frames[f].push_back(std::vector<int8_t>(shape.size, (int8_t)f));
+        }
+    }
+    NN_ASSERT(nn_test_write_capture(path, in_shapes, out_shapes, frames));
+    auto engine = CreateReplayEngine(0);
+    NN_ASSERT(engine->LoadModelFile(path.c_str()) == NN_SUCCESS);
+    check_run_allocates_nothing(engine);
+}
+
+// RKNN引擎打开输出预分配后Run不分配内存，需要NPU和模型文件（环境变量NN_TEST_RKNN_MODEL）
+NN_TEST(alloc, rknn_prealloc_run_allocates_nothing)
+{
+#ifdef NN_DISABLE_RKNN
+    NN_SKIP("built without RKNN");
+#else
+    const char *model = getenv("NN_TEST_RKNN_MODEL");
+    if (model == nullptr)
+    {
+        NN_SKIP("NN_TEST_RKNN_MODEL not set");
+    }
+    auto engine = CreateRKNNEngine();
+    NN_ASSERT(engine->LoadModelFile(model) == NN_SUCCESS);
+    NN_ASSERT(engine->SetOutputPrealloc(true) == NN_SUCCESS);
+    check_run_allocates_nothing(engine);
+#endif
+}
+
+// 后处理上下文按网格预分配、预热一帧之后，拥挤画面（直到每个网格都有候选框）的post_process不再分配内存
+NN_TEST(alloc, postprocess_with_context_allocates_nothing)
+{
+    const int model_size = 640;
+    auto shapes = nn_test_yolo_output_shapes(model_size, model_size);
+    std::vector<int32_t> zps;
+    std::vector<float> scales;
+    yolov5::DECODE_LUT luts[3];
+    yolov5::GRID_SIZE grids[3];
+    for (int i = 0; i < 3; i++)
+    {
+        zps.push_back(shapes[i].zp);
+        scales.push_back(shapes[i].scale);
+        yolov5::build_decode_lut(shapes[i].zp, shapes[i].scale, &luts[i]);
+        grids[i] = {(int)shapes[i].dims[2], (int)shapes[i].dims[3]};
+    }
+    yolov5::PostprocessContext ctx;
+    ctx.Reserve(grids);
+    yolov5::detect_result_group_t group;
+    auto run = [&](std::vector<std::vector<int8_t>> &outputs) {
+        yolov5::post_process(outputs[0].data(), outputs[1].data(), outputs[2].data(), model_size, model_size,
+                             BOX_THRESH, NMS_THRESH, 1.f, 1.f, zps, scales, luts, grids, &group, PRE_NMS_TOP_K, &ctx);
+    };
+    auto sparse = nn_test_random_yolo_outputs(model_size, model_size, 0.001f, 1);
+    run(sparse);
+
+    const float hit_ratios[] = {0.05f, 0.2f, 1.f};
+    for (float hit_ratio : hit_ratios)
+    {
+        auto crowded = nn_test_random_yolo_outputs(model_size, model_size, hit_ratio, 2);
+        AllocCounterScope scope;
+        run(crowded);
+        NN_CHECK(scope.Count() == 0);
+        NN_CHECK(group.count == OBJ_NUMB_MAX_SIZE);
+    }
+}
+
+// 固定分辨率的视频流：预热后Preprocess不再重新分配预处理缓冲区（scratch的misses不变）；
+// 融合letterbox完全不分配内存。opencv方式只检查misses：cv::resize每次调用都会用AutoBuffer分配插值表，不受这里控制
+NN_TEST(alloc, preprocess_steady_state_reuses_scratch)
+{
+    const int model_size = 640;
+    std::string path = nn_test_temp_path("alloc_preprocess.cap");
+    NN_ASSERT(nn_test_write_yolo_capture(path, model_size, model_size, std::vector<std::vector<nn_test_object_s>>(1)));
+    const letterbox_mode_e modes[] = {LETTERBOX_PAD_RESIZE, LETTERBOX_RESIZE_PAD};
+    cv::Mat img(720, 1280, CV_8UC3, cv::Scalar(10, 20, 30));
+    for (letterbox_mode_e mode : modes)
+    {
+        Yolov5Config config;
+        config.backend = NN_BACKEND_REPLAY;
+        config.letterbox_mode = mode;
+        Yolov5 yolo(config);
+        NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        NN_ASSERT(yolo.Preprocess(img, "fused") == NN_SUCCESS);
+        yolo.GetPreprocessScratchStats(hits, misses);
+        uint64_t warm_misses = misses;
+        AllocCounterScope scope;
+        for (int i = 0; i < 5; i++)
+        {
+            NN_CHECK(yolo.Preprocess(img, "fused") == NN_SUCCESS);
+        }
+        NN_CHECK(scope.Count() == 0);
+        yolo.GetPreprocessScratchStats(hits, misses);
+        NN_CHECK(misses == warm_misses);
+
+        if (mode == LETTERBOX_PAD_RESIZE)
+        {
+            NN_ASSERT(yolo.Preprocess(img, "opencv") == NN_SUCCESS);
+            yolo.GetPreprocessScratchStats(hits, warm_misses);
+            for (int i = 0; i < 5; i++)
+            {
+                NN_CHECK(yolo.Preprocess(img, "opencv") == NN_SUCCESS);
+            }
+            yolo.GetPreprocessScratchStats(hits, misses);
+            NN_CHECK(misses == warm_misses);
+        }
+    }
+}
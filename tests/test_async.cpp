@@ -0,0 +1,152 @@
+// Yolov5流水线（RunAsync/Wait）的测试：回放引擎用sleep模拟NPU推理耗时
+
+#include "nn_test.h"
+
+#include <algorithm>
+
+#include "task/yolov5.h"
+#include "test_util.h"
+
+static const int g_model_size = 640;
+
+// 第k帧有k+1个目标，检测数量可以区分是哪一帧的结果
+static std::string write_counting_capture(const std::string &name, int frame_count)
+{
+    std::vector<std::vector<nn_test_object_s>> frames(frame_count);
+    for (int k = 0; k < frame_count; k++)
+    {
+        for (int n = 0; n <= k; n++)
+        {
+            frames[k].push_back({4 + n * 6, 4 + n * 6, n});
+        }
+    }
+    std::string path = nn_test_temp_path(name);
+    return nn_test_write_yolo_capture(path, g_model_size, g_model_size, frames) ? path : "";
+}
+
+static cv::Mat random_image(int width, int height)
+{
+    cv::Mat img(height, width, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(255));
+    return img;
+}
+
+// 串行Run的总耗时（微秒）
+static double run_serial(Yolov5 &yolo, const std::vector<cv::Mat> &imgs)
+{
+    std::vector<Detection> objects;
+    NNTimer timer;
+    for (auto &img : imgs)
+    {
+        objects.clear();
+        yolo.Run(img, objects);
+    }
+    return timer.ElapsedUs();
+}
+
+// 流水线的总耗时（微秒），在途最多两帧
+static double run_async(Yolov5 &yolo, const std::vector<cv::Mat> &imgs)
+{
+    std::vector<Detection> objects;
+    NNTimer timer;
+    for (size_t i = 0; i < imgs.size(); i++)
+    {
+        yolo.RunAsync(imgs[i]);
+        if (i > 0)
+        {
+            yolo.Wait(objects);
+        }
+    }
+    yolo.Wait(objects);
+    return timer.ElapsedUs();
+}
+
+// 推理耗时和CPU预处理+后处理耗时相当时，流水线的总耗时明显小于串行
+NN_TEST(async, pipeline_overlaps_inference)
+{
+    std::string path = write_counting_capture("async_timing.cap", 4);
+    NN_ASSERT(!path.empty());
+    const int frame_num = 12;
+    std::vector<cv::Mat> imgs;
+    for (int i = 0; i < frame_num; i++)
+    {
+        imgs.push_back(random_image(1920, 1080));
+    }
+
+    // 先测出每帧的CPU耗时，模拟的推理耗时取相同的值
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    Yolov5 cpu_only(config);
+    NN_ASSERT(cpu_only.LoadModel(path.c_str()) == NN_SUCCESS);
+    run_serial(cpu_only, imgs); // 预热
+    double cpu_us = run_serial(cpu_only, imgs) / frame_num;
+    config.replay_latency_us = std::max(2000, (int)cpu_us);
+
+    Yolov5 serial(config);
+    NN_ASSERT(serial.LoadModel(path.c_str()) == NN_SUCCESS);
+    Yolov5 pipelined(config);
+    NN_ASSERT(pipelined.LoadModel(path.c_str()) == NN_SUCCESS);
+    run_serial(serial, imgs); // 预热
+    run_async(pipelined, imgs);
+    double serial_us = run_serial(serial, imgs);
+    double async_us = run_async(pipelined, imgs);
+    printf("  cpu %.0fus/frame, latency %uus, serial %.0fus, async %.0fus (%.2fx)\n", cpu_us,
+           config.replay_latency_us, serial_us, async_us, serial_us / async_us);
+    // 理想情况下约为串行的一半，留出调度抖动的余量
+    NN_CHECK(async_us < serial_us * 0.8);
+}
+
+// Wait按RunAsync的提交顺序返回结果
+NN_TEST(async, wait_returns_in_submit_order)
+{
+    std::string path = write_counting_capture("async_order.cap", 4);
+    NN_ASSERT(!path.empty());
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    config.replay_latency_us = 5000;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+    cv::Mat img = random_image(1280, 720);
+
+    std::vector<Detection> objects;
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    NN_CHECK(yolo.Wait(objects) == NN_SUCCESS);
+    NN_CHECK(objects.size() == 1);
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    for (size_t expected = 2; expected <= 4; expected++)
+    {
+        NN_CHECK(yolo.Wait(objects) == NN_SUCCESS);
+        NN_CHECK(objects.size() == expected);
+    }
+    // 全部取完后没有结果可等
+    NN_CHECK(yolo.Wait(objects) == NN_ASYNC_HANDLE_INVALID);
+}
+
+// 预处理失败的帧有一个空结果，排在它之前提交、还在途的帧之后
+NN_TEST(async, failed_frame_keeps_order)
+{
+    std::string path = write_counting_capture("async_failed.cap", 3);
+    NN_ASSERT(!path.empty());
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    config.replay_latency_us = 5000;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+    cv::Mat img = random_image(1280, 720);
+
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    NN_CHECK(yolo.RunAsync(cv::Mat()) == NN_IMG_INPUT_ERROR);
+    NN_CHECK(yolo.RunAsync(img) == NN_SUCCESS);
+    // 失败的帧不提交推理，不占用回放的帧
+    const size_t expected[] = {1, 2, 0, 3};
+    std::vector<Detection> objects;
+    for (size_t count : expected)
+    {
+        NN_CHECK(yolo.Wait(objects) == NN_SUCCESS);
+        NN_CHECK(objects.size() == count);
+    }
+    NN_CHECK(yolo.Wait(objects) == NN_ASYNC_HANDLE_INVALID);
+}
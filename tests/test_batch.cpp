@@ -0,0 +1,69 @@
+// 批量推理（RunBatch）的测试：回放引擎按批量模型的形状录制[2, ...]的输入输出
+
+#include "nn_test.h"
+
+#include "task/yolov5.h"
+#include "test_util.h"
+
+static const int g_model_size = 640;
+
+// 批量为2的录制文件：每帧第0张图像有一个类别0的目标，第1张有两个目标
+static std::string write_batch_capture(const std::string &name)
+{
+    std::vector<tensor_attr_s> in_shapes = {
+        nn_test_attr(0, 2, g_model_size, g_model_size, 3, NN_TENSOR_UINT8, NN_TENSOR_NHWC)};
+    auto out_shapes = nn_test_yolo_output_shapes(g_model_size, g_model_size);
+    auto first = nn_test_yolo_outputs(g_model_size, g_model_size, {{10, 20, 0}});
+    auto second = nn_test_yolo_outputs(g_model_size, g_model_size, {{10, 20, 1}, {40, 40, 2}});
+    std::vector<std::vector<int8_t>> outputs;
+    for (size_t i = 0; i < out_shapes.size(); i++)
+    {
+        out_shapes[i].dims[0] = 2;
+        out_shapes[i].n_elems *= 2;
+        out_shapes[i].size *= 2;
+        std::vector<int8_t> data = first[i];
+        data.insert(data.end(), second[i].begin(), second[i].end());
+        outputs.push_back(data);
+    }
+    std::string path = nn_test_temp_path(name);
+    std::vector<std::vector<std::vector<int8_t>>> frames(2, outputs);
+    return nn_test_write_capture(path, in_shapes, out_shapes, frames) ? path : "";
+}
+
+// 图像数量不是批量的整数倍时，最后一批空出的位置结果丢弃
+NN_TEST(batch, results_follow_batch_slots)
+{
+    std::string path = write_batch_capture("batch.cap");
+    NN_ASSERT(!path.empty());
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+    NN_ASSERT(yolo.BatchSize() == 2);
+
+    std::vector<cv::Mat> imgs(3, cv::Mat::zeros(g_model_size, g_model_size, CV_8UC3));
+    std::vector<std::vector<Detection>> results;
+    NN_ASSERT(yolo.RunBatch(imgs, results) == NN_SUCCESS);
+    NN_ASSERT(results.size() == 3);
+    NN_CHECK(results[0].size() == 1 && results[0][0].class_id == 0);
+    NN_CHECK(results[1].size() == 2);
+    NN_CHECK(results[2].size() == 1 && results[2][0].class_id == 0);
+}
+
+// 有图像预处理失败时返回错误，不把上一批留在该位置的输入当作它的结果
+NN_TEST(batch, preprocess_failure_returns_error)
+{
+    std::string path = write_batch_capture("batch_error.cap");
+    NN_ASSERT(!path.empty());
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+
+    std::vector<cv::Mat> imgs = {cv::Mat::zeros(g_model_size, g_model_size, CV_8UC3),
+                                 cv::Mat::zeros(g_model_size, g_model_size, CV_8UC3),
+                                 cv::Mat::zeros(g_model_size, g_model_size, CV_8UC3), cv::Mat()};
+    std::vector<std::vector<Detection>> results;
+    NN_CHECK(yolo.RunBatch(imgs, results) == NN_IMG_INPUT_ERROR);
+    NN_CHECK(results.empty());
+}
@@ -0,0 +1,104 @@
+// OpenCV DNN引擎的测试：输出格式检查、int8量化，以及量化后的输出经过回放引擎走完Yolov5后处理
+
+#include "nn_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "engine/opencv_dnn_engine.h"
+#include "task/yolov5.h"
+#include "test_util.h"
+
+static const float g_dnn_scale = 32.f / 255.f; // 和引擎中的量化参数一致
+
+// 只接受三个检测头[1, 255, H, W]，合并解码后的[1, 25200, 85]给出明确的错误
+NN_TEST(dnn, check_output_shape)
+{
+    int head[4] = {1, 255, 80, 80};
+    NN_CHECK(OpenCVDnnEngine::CheckOutput(cv::Mat(4, head, CV_32F), "head") == NN_SUCCESS);
+    int merged[3] = {1, 25200, 85};
+    NN_CHECK(OpenCVDnnEngine::CheckOutput(cv::Mat(3, merged, CV_32F), "output0") == NN_RKNN_OUTPUT_ATTR_ERROR);
+    int other[4] = {1, 85, 80, 80};
+    NN_CHECK(OpenCVDnnEngine::CheckOutput(cv::Mat(4, other, CV_32F), "other") == NN_RKNN_OUTPUT_ATTR_ERROR);
+}
+
+// [-16, 16)内的logits量化误差不超过半个scale，超出的截断到边界并计数
+NN_TEST(dnn, quantize_clips_outside_16)
+{
+    const float src[] = {0.f, 1.f, -1.f, 7.5f, -15.9f, 15.9f, 20.f, -40.f};
+    int8_t dst[8];
+    NN_CHECK(OpenCVDnnEngine::QuantizeOutput(src, 8, dst) == 2);
+    for (int i = 0; i < 6; i++)
+    {
+        NN_CHECK(fabsf(dst[i] * g_dnn_scale - src[i]) <= g_dnn_scale / 2 + 1e-6f);
+    }
+    NN_CHECK(dst[6] == 127);
+    NN_CHECK(dst[7] == -128);
+}
+
+NN_TEST(dnn, load_missing_model_fails)
+{
+    auto engine = CreateOpenCVDnnEngine(640, 640);
+    NN_CHECK(engine->LoadModelFile(nn_test_temp_path("missing.onnx").c_str()) == NN_LOAD_MODEL_FAIL);
+}
+
+// 按引擎的方式量化合成的float logits，录制后用回放引擎运行：背景的-20被截断后仍远低于阈值，目标正常检出
+NN_TEST(dnn, quantized_logits_through_replay)
+{
+    const int model_size = 640;
+    auto shapes = nn_test_yolo_output_shapes(model_size, model_size);
+    std::vector<std::vector<int8_t>> outputs;
+    for (auto &shape : shapes)
+    {
+        int grid_w = shape.dims[3];
+        int grid_len = shape.dims[2] * grid_w;
+        std::vector<float> logits(shape.n_elems, -20.f);
+        if (shape.index == 0)
+        {
+            // stride 8输出第(10, 20)个网格、第0个anchor：框在网格中心，大小等于anchor，类别2
+            int cell = 10 * grid_w + 20;
+            for (int k = 0; k < 4; k++)
+            {
+                logits[k * grid_len + cell] = 0.f;
+            }
+            logits[4 * grid_len + cell] = 8.f;
+            logits[(5 + 2) * grid_len + cell] = 8.f;
+        }
+        std::vector<int8_t> q(shape.n_elems);
+        uint32_t expected_clipped = shape.index == 0 ? shape.n_elems - 6 : shape.n_elems;
+        NN_CHECK(OpenCVDnnEngine::QuantizeOutput(logits.data(), logits.size(), q.data()) == expected_clipped);
+        outputs.push_back(q);
+        shape.scale = g_dnn_scale;
+    }
+    std::vector<tensor_attr_s> in_shapes = {nn_test_attr(0, 1, model_size, model_size, 3, NN_TENSOR_UINT8, NN_TENSOR_NHWC)};
+    std::string path = nn_test_temp_path("dnn_replay.cap");
+    std::vector<std::vector<std::vector<int8_t>>> frames(1, outputs);
+    NN_ASSERT(nn_test_write_capture(path, in_shapes, shapes, frames));
+
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+    std::vector<Detection> objects;
+    NN_ASSERT(yolo.Run(cv::Mat::zeros(model_size, model_size, CV_8UC3), objects) == NN_SUCCESS);
+    NN_ASSERT(objects.size() == 1);
+    NN_CHECK(objects[0].class_id == 2);
+    NN_CHECK(objects[0].box.x == 159 && objects[0].box.y == 78);
+    NN_CHECK(objects[0].confidence > 0.99f);
+}
+
+// 真实的ONNX模型（环境变量NN_TEST_ONNX_MODEL，三个检测头的导出）能加载并完成一次推理
+NN_TEST(dnn, onnx_model_runs)
+{
+    const char *model = getenv("NN_TEST_ONNX_MODEL");
+    if (model == nullptr)
+    {
+        NN_SKIP("NN_TEST_ONNX_MODEL not set");
+    }
+    Yolov5Config config;
+    config.backend = NN_BACKEND_OPENCV_DNN;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(model) == NN_SUCCESS);
+    std::vector<Detection> objects;
+    NN_CHECK(yolo.Run(cv::Mat::zeros(720, 1280, CV_8UC3), objects) == NN_SUCCESS);
+}
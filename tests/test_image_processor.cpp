@@ -0,0 +1,127 @@
+// 预处理实现的测试：RGA和CPU实现的误差在接口注释的范围内，零拷贝时RGA直接写入张量的dma-buf
+// 没有/dev/rga（或关闭了ENABLE_RKNN）时跳过
+
+#include "nn_test.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "process/dma_buffer.h"
+#include "process/image_processor.h"
+
+static const int g_model_size = 640;
+
+// 平滑的测试图像：随机噪声模糊后叠加渐变，接近真实画面的频率
+static cv::Mat smooth_image(const cv::Size &size)
+{
+    cv::Mat noise(size, CV_8UC3);
+    cv::theRNG().state = 99;
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::Mat img;
+    cv::GaussianBlur(noise, img, cv::Size(0, 0), 4);
+    for (int y = 0; y < img.rows; y++)
+    {
+        uint8_t *row = img.ptr<uint8_t>(y);
+        for (int x = 0; x < img.cols; x++)
+        {
+            row[x * 3 + 0] = cv::saturate_cast<uint8_t>(row[x * 3 + 0] / 2 + x * 127 / img.cols);
+            row[x * 3 + 2] = cv::saturate_cast<uint8_t>(row[x * 3 + 2] / 2 + y * 127 / img.rows);
+        }
+    }
+    return img;
+}
+
+static tensor_data_s make_tensor(void *data)
+{
+    tensor_data_s tensor;
+    memset(&tensor, 0, sizeof(tensor));
+    tensor.data = data;
+    return tensor;
+}
+
+// 几何和边界完全相同，内容区域平均误差不超过1.5、单个像素不超过8
+NN_TEST(rga, matches_software_within_tolerance)
+{
+    auto rga = CreateRGAImageProcessor();
+    if (rga == nullptr)
+    {
+        NN_SKIP("rga not available");
+    }
+    auto software = CreateSoftwareImageProcessor();
+    const cv::Size image_sizes[] = {{1280, 720}, {1920, 1080}, {720, 1280}};
+    for (const cv::Size &size : image_sizes)
+    {
+        cv::Mat img = smooth_image(size);
+        cv::Mat rga_out(g_model_size, g_model_size, CV_8UC3, cv::Scalar::all(0xAA));
+        cv::Mat cpu_out(g_model_size, g_model_size, CV_8UC3, cv::Scalar::all(0x55));
+        tensor_data_s rga_tensor = make_tensor(rga_out.data);
+        tensor_data_s cpu_tensor = make_tensor(cpu_out.data);
+        LetterBoxInfo rga_info;
+        LetterBoxInfo cpu_info;
+        NN_ASSERT(rga->Letterbox(img, g_model_size, g_model_size, rga_tensor, rga_info) == NN_SUCCESS);
+        NN_ASSERT(software->Letterbox(img, g_model_size, g_model_size, cpu_tensor, cpu_info) == NN_SUCCESS);
+        NN_CHECK(rga_info.x_pad == cpu_info.x_pad && rga_info.y_pad == cpu_info.y_pad);
+        NN_CHECK(rga_info.scale_x == cpu_info.scale_x && rga_info.scale_y == cpu_info.scale_y);
+
+        cv::Rect content = letterbox_content_rect(cpu_info, img.cols, img.rows);
+        cv::Mat diff;
+        cv::absdiff(rga_out, cpu_out, diff);
+        // 边界都是0
+        cv::Mat rga_border = rga_out.clone();
+        rga_border(content).setTo(cv::Scalar::all(0));
+        cv::Mat border_diff = diff.clone();
+        border_diff(content).setTo(cv::Scalar::all(0));
+        NN_CHECK(cv::countNonZero(rga_border.reshape(1)) == 0);
+        NN_CHECK(cv::countNonZero(border_diff.reshape(1)) == 0);
+
+        cv::Mat content_diff = diff(content);
+        cv::Scalar mean = cv::mean(content_diff);
+        double max_diff = 0;
+        cv::minMaxLoc(content_diff.reshape(1), nullptr, &max_diff);
+        printf("  %dx%d: mean diff %.2f/%.2f/%.2f, max diff %.0f\n", size.width, size.height, mean[0], mean[1], mean[2],
+               max_diff);
+        NN_CHECK(mean[0] <= 1.5 && mean[1] <= 1.5 && mean[2] <= 1.5);
+        NN_CHECK(max_diff <= 8);
+    }
+}
+
+// 登记张量的dma-buf后，RGA直接写入批量输入中的第二张，结果和经过中转内存拷贝的完全相同，第一张不受影响
+NN_TEST(rga, writes_registered_tensor_dma)
+{
+    auto rga = CreateRGAImageProcessor();
+    auto reference = CreateRGAImageProcessor();
+    if (rga == nullptr || reference == nullptr)
+    {
+        NN_SKIP("rga not available");
+    }
+    const size_t image_size = (size_t)g_model_size * g_model_size * 3;
+    DmaBuffer buffer;
+    if (buffer.Alloc(image_size * 2) != NN_SUCCESS)
+    {
+        NN_SKIP("dma heap not available");
+    }
+    buffer.SyncBegin(true);
+    memset(buffer.Data(), 0x55, buffer.Size());
+    buffer.SyncEnd(true);
+    rga->SetTensorDma(buffer.Fd(), buffer.Data(), buffer.Size());
+
+    cv::Mat img = smooth_image(cv::Size(1920, 1080));
+    tensor_data_s direct = make_tensor((uint8_t *)buffer.Data() + image_size);
+    LetterBoxInfo info;
+    NN_ASSERT(rga->Letterbox(img, g_model_size, g_model_size, direct, info) == NN_SUCCESS);
+
+    std::vector<uint8_t> expected(image_size);
+    tensor_data_s copied = make_tensor(expected.data());
+    NN_ASSERT(reference->Letterbox(img, g_model_size, g_model_size, copied, info) == NN_SUCCESS);
+
+    buffer.SyncBegin(false);
+    const uint8_t *data = (const uint8_t *)buffer.Data();
+    NN_CHECK(memcmp(data + image_size, expected.data(), image_size) == 0);
+    bool first_untouched = true;
+    for (size_t i = 0; i < image_size; i++)
+    {
+        first_untouched = first_untouched && data[i] == 0x55;
+    }
+    NN_CHECK(first_untouched);
+    buffer.SyncEnd(false);
+}
@@ -0,0 +1,221 @@
+// letterbox的测试：融合实现和opencv实现逐像素对比，NEON/SSE2和标量实现逐字节对比，
+// 以及原图上的框经过letterbox和后处理的映射回到原图
+
+#include "nn_test.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "process/preprocess.h"
+#include "task/yolov5.h"
+#include "test_util.h"
+
+// 常见的视频分辨率，以及宽高都是奇数、竖屏的图像
+static const cv::Size g_image_sizes[] = {{1280, 720}, {1920, 1080}, {720, 1280}, {641, 359}, {333, 517}};
+static const cv::Size g_model_sizes[] = {{640, 640}, {640, 384}};
+
+// 一个uint8 NHWC的输入张量，数据由vector持有
+struct TestTensor
+{
+    std::vector<uint8_t> buf;
+    tensor_data_s tensor;
+
+    TestTensor(int width, int height) : buf((size_t)width * height * 3, 0xAA)
+    {
+        memset(&tensor, 0, sizeof(tensor));
+        tensor.data = buf.data();
+    }
+};
+
+static cv::Mat random_image(const cv::Size &size)
+{
+    cv::Mat img(size, CV_8UC3);
+    cv::randu(img, cv::Scalar::all(0), cv::Scalar::all(256));
+    return img;
+}
+
+static int max_abs_diff(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b)
+{
+    int diff = 0;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        diff = std::max(diff, abs((int)a[i] - (int)b[i]));
+    }
+    return diff;
+}
+
+// 先补边方式和letterbox + cvimg2tensor每个像素的误差不超过1
+NN_TEST(letterbox, pad_resize_matches_opencv)
+{
+    cv::theRNG().state = 1234;
+    for (const cv::Size &image_size : g_image_sizes)
+    {
+        cv::Mat img = random_image(image_size);
+        for (const cv::Size &model_size : g_model_sizes)
+        {
+            TestTensor ref(model_size.width, model_size.height);
+            TestTensor fused(model_size.width, model_size.height);
+            cv::Mat img_letterbox;
+            letterbox(img, img_letterbox, (float)model_size.width / model_size.height);
+            cvimg2tensor(img_letterbox, model_size.width, model_size.height, ref.tensor);
+            letterbox_fused(img, model_size.width, model_size.height, fused.tensor, LETTERBOX_PAD_RESIZE);
+            int diff = max_abs_diff(ref.buf, fused.buf);
+            if (diff > 1)
+            {
+                printf("  %dx%d -> %dx%d: max diff %d\n", image_size.width, image_size.height, model_size.width,
+                       model_size.height, diff);
+            }
+            NN_CHECK(diff <= 1);
+        }
+    }
+}
+
+// 先缩放方式和letterbox_resize每个像素的误差不超过1，边界都是0
+NN_TEST(letterbox, resize_pad_matches_opencv)
+{
+    cv::theRNG().state = 5678;
+    for (const cv::Size &image_size : g_image_sizes)
+    {
+        cv::Mat img = random_image(image_size);
+        for (const cv::Size &model_size : g_model_sizes)
+        {
+            TestTensor ref(model_size.width, model_size.height);
+            TestTensor fused(model_size.width, model_size.height);
+            LetterBoxInfo ref_info = letterbox_resize(img, model_size.width, model_size.height, ref.tensor);
+            LetterBoxInfo info = letterbox_fused(img, model_size.width, model_size.height, fused.tensor,
+                                                 LETTERBOX_RESIZE_PAD);
+            NN_CHECK(ref_info.x_pad == info.x_pad && ref_info.y_pad == info.y_pad);
+            int diff = max_abs_diff(ref.buf, fused.buf);
+            if (diff > 1)
+            {
+                printf("  %dx%d -> %dx%d: max diff %d\n", image_size.width, image_size.height, model_size.width,
+                       model_size.height, diff);
+            }
+            NN_CHECK(diff <= 1);
+        }
+    }
+}
+
+// NEON/SSE2和标量实现逐字节相同（BGR和YUV两种输入）
+NN_TEST(letterbox, simd_matches_scalar)
+{
+    cv::theRNG().state = 42;
+    const letterbox_mode_e modes[] = {LETTERBOX_PAD_RESIZE, LETTERBOX_RESIZE_PAD};
+    for (const cv::Size &image_size : g_image_sizes)
+    {
+        cv::Mat img = random_image(image_size);
+        for (const cv::Size &model_size : g_model_sizes)
+        {
+            for (letterbox_mode_e mode : modes)
+            {
+                TestTensor simd(model_size.width, model_size.height);
+                TestTensor scalar(model_size.width, model_size.height);
+                letterbox_fused(img, model_size.width, model_size.height, simd.tensor, mode);
+                letterbox_fused_enable_simd(false);
+                letterbox_fused(img, model_size.width, model_size.height, scalar.tensor, mode);
+                letterbox_fused_enable_simd(true);
+                NN_CHECK(simd.buf == scalar.buf);
+            }
+        }
+
+        // NV12：宽高按2对齐
+        int width = image_size.width & ~1;
+        int height = image_size.height & ~1;
+        cv::Mat yuv(height * 3 / 2, width, CV_8UC1);
+        cv::randu(yuv, cv::Scalar::all(0), cv::Scalar::all(256));
+        yuv_frame_s frame = {NN_YUV_NV12, width, height, width, height, yuv.data, -1};
+        TestTensor simd(640, 640);
+        TestTensor scalar(640, 640);
+        letterbox_fused_yuv(frame, 640, 640, simd.tensor);
+        letterbox_fused_enable_simd(false);
+        letterbox_fused_yuv(frame, 640, 640, scalar.tensor);
+        letterbox_fused_enable_simd(true);
+        NN_CHECK(simd.buf == scalar.buf);
+    }
+}
+
+// 比nn_test_yolo_output_shapes更细的量化，框中心的编码误差约0.1个模型像素
+static const float g_fine_scale = 0.02f;
+
+// stride 8输出上模型输入坐标c的编码：c = (2 * sigmoid(q * scale) - 0.5 + grid) * 8
+static void encode_center(float c, int &grid, int8_t &q)
+{
+    grid = (int)floorf(c / 8);
+    float s = (c / 8 - grid + 0.5f) / 2;
+    q = (int8_t)lroundf(logf(s / (1 - s)) / g_fine_scale);
+}
+
+// 原图上的框按letterbox_info映射到模型输入并写成检测输出，Run映射回原图后，
+// 两种letterbox方式下每条边和原框的误差都不超过1个像素
+NN_TEST(letterbox, box_round_trip)
+{
+    const int model_size = 640;
+    const cv::Size image_sizes[] = {{1280, 720}, {1920, 1080}, {720, 1280}, {1000, 750}, {1280, 719}, {641, 359}};
+    const cv::Point2f centers[] = {{0.5f, 0.5f}, {0.25f, 0.3f}, {0.8f, 0.7f}, {0.1f, 0.9f}};
+    const letterbox_mode_e modes[] = {LETTERBOX_PAD_RESIZE, LETTERBOX_RESIZE_PAD};
+    std::vector<tensor_attr_s> in_shapes = {nn_test_attr(0, 1, model_size, model_size, 3, NN_TENSOR_UINT8, NN_TENSOR_NHWC)};
+    int capture_id = 0;
+    for (const cv::Size &size : image_sizes)
+    {
+        for (letterbox_mode_e mode : modes)
+        {
+            LetterBoxInfo info = letterbox_info(size.width, size.height, model_size, model_size, mode);
+            auto shapes = nn_test_yolo_output_shapes(model_size, model_size);
+            std::vector<std::vector<int8_t>> outputs;
+            for (auto &shape : shapes)
+            {
+                shape.scale = g_fine_scale;
+                outputs.push_back(std::vector<int8_t>(shape.size, -128));
+            }
+            int grid_w = shapes[0].dims[3];
+            int grid_len = shapes[0].dims[2] * grid_w;
+
+            // 第k个框的类别为k，在模型输入中的大小等于第0个anchor（10x13）
+            std::vector<cv::Rect2f> boxes;
+            for (const cv::Point2f &center : centers)
+            {
+                float cx = size.width * center.x;
+                float cy = size.height * center.y;
+                int class_id = boxes.size();
+                boxes.push_back(cv::Rect2f(cx - 5.f / info.scale_x, cy - 6.5f / info.scale_y, 10.f / info.scale_x,
+                                           13.f / info.scale_y));
+                int col, row;
+                int8_t qx, qy;
+                encode_center(cx * info.scale_x + info.x_pad, col, qx);
+                encode_center(cy * info.scale_y + info.y_pad, row, qy);
+                int8_t *cell = outputs[0].data() + row * grid_w + col;
+                cell[0 * grid_len] = qx;
+                cell[1 * grid_len] = qy;
+                cell[2 * grid_len] = 0;
+                cell[3 * grid_len] = 0;
+                cell[4 * grid_len] = 127;
+                cell[(5 + class_id) * grid_len] = 127;
+            }
+
+            std::string path = nn_test_temp_path("round_trip_" + std::to_string(capture_id++) + ".cap");
+            std::vector<std::vector<std::vector<int8_t>>> frames(1, outputs);
+            NN_ASSERT(nn_test_write_capture(path, in_shapes, shapes, frames));
+            Yolov5Config config;
+            config.backend = NN_BACKEND_REPLAY;
+            config.letterbox_mode = mode;
+            Yolov5 yolo(config);
+            NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+            std::vector<Detection> objects;
+            NN_ASSERT(yolo.Run(cv::Mat::zeros(size, CV_8UC3), objects) == NN_SUCCESS);
+            NN_ASSERT(objects.size() == boxes.size());
+            for (const Detection &obj : objects)
+            {
+                const cv::Rect2f &expected = boxes[obj.class_id];
+                float err = std::max(std::max(fabsf(obj.box.x - expected.x), fabsf(obj.box.y - expected.y)),
+                                     std::max(fabsf(obj.box.br().x - expected.br().x),
+                                              fabsf(obj.box.br().y - expected.br().y)));
+                if (err > 1.f)
+                {
+                    printf("  %dx%d mode %d class %d: error %.2f\n", size.width, size.height, mode, obj.class_id, err);
+                }
+                NN_CHECK(err <= 1.f);
+            }
+        }
+    }
+}
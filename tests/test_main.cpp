@@ -0,0 +1,51 @@
+// 单元测试入口：nn_tests [suite]，不带参数时运行所有测试
+// 返回0表示全部通过，1表示有失败，77表示选中的测试全部被跳过（ctest的SKIP_RETURN_CODE）
+
+#include "nn_test.h"
+
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+    const char *suite = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    int skipped = 0;
+    for (auto &test : nn_test_registry())
+    {
+        if (suite != nullptr && strcmp(suite, test.suite) != 0)
+        {
+            continue;
+        }
+        printf("[ RUN  ] %s.%s\n", test.suite, test.name);
+        fflush(stdout);
+        nn_test_reset();
+        test.func();
+        run++;
+        if (nn_test_failures() > 0)
+        {
+            failed++;
+            printf("[ FAIL ] %s.%s\n", test.suite, test.name);
+        }
+        else if (nn_test_skipped())
+        {
+            skipped++;
+            printf("[ SKIP ] %s.%s\n", test.suite, test.name);
+        }
+        else
+        {
+            printf("[  OK  ] %s.%s\n", test.suite, test.name);
+        }
+    }
+    printf("%d tests, %d failed, %d skipped\n", run, failed, skipped);
+    if (run == 0)
+    {
+        printf("no test matches '%s'\n", suite != nullptr ? suite : "");
+        return 1;
+    }
+    if (failed > 0)
+    {
+        return 1;
+    }
+    return skipped == run ? 77 : 0;
+}
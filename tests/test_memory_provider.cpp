@@ -0,0 +1,138 @@
+// ZeroCopyIO和HeapMemoryProvider的测试
+
+#include "nn_test.h"
+
+#include <string.h>
+
+#include "engine/memory_provider.h"
+#include "test_util.h"
+
+// 记录分配和释放的假内存提供者，可以指定第几次分配失败
+class FakeMemoryProvider : public MemoryProvider
+{
+public:
+    nn_error_e AllocInput(const tensor_attr_s &attr, tensor_mem_s &mem) override { return Alloc(attr, mem); }
+    nn_error_e AllocOutput(const tensor_attr_s &attr, tensor_mem_s &mem) override { return Alloc(attr, mem); }
+    void Free(tensor_mem_s &mem) override
+    {
+        free(mem.virt_addr);
+        mem.virt_addr = nullptr;
+        free_count++;
+    }
+
+    int alloc_count{0};
+    int free_count{0};
+    int fail_at{-1}; // 第fail_at次分配返回失败，-1表示不失败
+    std::vector<uint32_t> sizes;
+
+private:
+    nn_error_e Alloc(const tensor_attr_s &attr, tensor_mem_s &mem)
+    {
+        if (alloc_count == fail_at)
+        {
+            return NN_MEM_ALLOC_FAIL;
+        }
+        alloc_count++;
+        sizes.push_back(attr.size);
+        mem.virt_addr = malloc(attr.size);
+        mem.size = attr.size;
+        mem.fd = -1;
+        mem.handle = nullptr;
+        return NN_SUCCESS;
+    }
+};
+
+static tensor_attr_s make_attr(uint32_t index, uint32_t h, uint32_t w, uint32_t c, tensor_datatype_e type)
+{
+    return nn_test_attr(index, 1, h, w, c, type, NN_TENSOR_NHWC);
+}
+
+// 输入按uint8分配，输出按模型属性分配，张量data指向分配的内存
+NN_TEST(zero_copy_io, setup_binds_provider_memory)
+{
+    auto provider = std::make_shared<FakeMemoryProvider>();
+    {
+        ZeroCopyIO io(provider);
+        std::vector<tensor_attr_s> in_shapes = {make_attr(0, 8, 8, 3, NN_TENSOR_INT8)};
+        std::vector<tensor_attr_s> out_shapes = {make_attr(0, 4, 4, 6, NN_TENSOR_INT8), make_attr(1, 2, 2, 6, NN_TENSOR_FLOAT)};
+        NN_ASSERT(io.Setup(in_shapes, out_shapes) == NN_SUCCESS);
+        NN_CHECK(provider->alloc_count == 3);
+        NN_ASSERT(io.Inputs().size() == 1 && io.Outputs().size() == 2);
+        NN_CHECK(io.Inputs()[0].attr.type == NN_TENSOR_UINT8);
+        NN_CHECK(io.Inputs()[0].attr.size == 8 * 8 * 3);
+        NN_CHECK(provider->sizes[2] == 2 * 2 * 6 * sizeof(float));
+        NN_CHECK(io.Inputs()[0].data != nullptr && io.Outputs()[1].data != nullptr);
+        // 重新Setup先释放之前的内存
+        NN_ASSERT(io.Setup(in_shapes, out_shapes) == NN_SUCCESS);
+        NN_CHECK(provider->free_count == 3);
+    }
+    NN_CHECK(provider->free_count == provider->alloc_count);
+}
+
+// 中途分配失败时已经分配的内存全部释放
+NN_TEST(zero_copy_io, setup_failure_releases)
+{
+    auto provider = std::make_shared<FakeMemoryProvider>();
+    provider->fail_at = 1;
+    ZeroCopyIO io(provider);
+    std::vector<tensor_attr_s> in_shapes = {make_attr(0, 8, 8, 3, NN_TENSOR_UINT8)};
+    std::vector<tensor_attr_s> out_shapes = {make_attr(0, 4, 4, 6, NN_TENSOR_INT8)};
+    NN_CHECK(io.Setup(in_shapes, out_shapes) == NN_MEM_ALLOC_FAIL);
+    NN_CHECK(provider->free_count == 1);
+    NN_CHECK(io.Inputs().empty() && io.Outputs().empty());
+}
+
+// 调用者的内存不是绑定内存时，BeforeRun拷进来，AfterRun拷出去；是绑定内存时不拷贝
+NN_TEST(zero_copy_io, heap_provider_copies_foreign_buffers)
+{
+    ZeroCopyIO io(CreateHeapMemoryProvider());
+    std::vector<tensor_attr_s> in_shapes = {make_attr(0, 4, 4, 3, NN_TENSOR_UINT8)};
+    std::vector<tensor_attr_s> out_shapes = {make_attr(0, 2, 2, 4, NN_TENSOR_INT8)};
+    NN_ASSERT(io.Setup(in_shapes, out_shapes) == NN_SUCCESS);
+    auto &bound_in = io.Inputs()[0];
+    auto &bound_out = io.Outputs()[0];
+
+    // 输入：调用者自己的缓冲区
+    std::vector<uint8_t> caller_in(bound_in.attr.size);
+    for (size_t i = 0; i < caller_in.size(); i++)
+    {
+        caller_in[i] = (uint8_t)(i * 7 + 1);
+    }
+    std::vector<tensor_data_s> inputs(1);
+    inputs[0].attr = bound_in.attr;
+    inputs[0].data = caller_in.data();
+    memset(bound_in.data, 0, bound_in.attr.size);
+    NN_ASSERT(io.BeforeRun(inputs) == NN_SUCCESS);
+    NN_CHECK(memcmp(bound_in.data, caller_in.data(), caller_in.size()) == 0);
+
+    // 输入：直接写入绑定内存，BeforeRun不覆盖
+    memset(bound_in.data, 0x5a, bound_in.attr.size);
+    inputs[0].data = bound_in.data;
+    NN_ASSERT(io.BeforeRun(inputs) == NN_SUCCESS);
+    NN_CHECK(((uint8_t *)bound_in.data)[0] == 0x5a);
+
+    // 输入比绑定内存大时报错
+    inputs[0].data = caller_in.data();
+    inputs[0].attr.size = bound_in.attr.size + 1;
+    NN_CHECK(io.BeforeRun(inputs) == NN_RKNN_INPUT_ATTR_ERROR);
+
+    // 输出：模拟推理结果，拷贝到调用者的缓冲区
+    for (uint32_t i = 0; i < bound_out.attr.size; i++)
+    {
+        ((int8_t *)bound_out.data)[i] = (int8_t)(i - 8);
+    }
+    std::vector<int8_t> caller_out(bound_out.attr.size, 0);
+    std::vector<tensor_data_s> outputs(1);
+    outputs[0].attr = bound_out.attr;
+    outputs[0].data = caller_out.data();
+    NN_ASSERT(io.AfterRun(outputs, false) == NN_SUCCESS);
+    NN_CHECK(memcmp(caller_out.data(), bound_out.data, bound_out.attr.size) == 0);
+
+    // 输出缓冲区太小时报错
+    outputs[0].attr.size = bound_out.attr.size - 1;
+    NN_CHECK(io.AfterRun(outputs, false) == NN_RKNN_OUTPUT_ATTR_ERROR);
+
+    // 绑定内存中是量化输出，要求float时报错，不把int8数据当作float交给调用者
+    outputs[0].attr.size = bound_out.attr.size;
+    NN_CHECK(io.AfterRun(outputs, true) == NN_NOT_SUPPORTED);
+}
@@ -0,0 +1,74 @@
+// perf detail逐层耗时表解析的测试，样本按板子上RKNN_QUERY_PERF_DETAIL的输出整理
+
+#include "nn_test.h"
+
+#include "engine/perf_profiler.h"
+
+// rknn 1.5之后的格式：CPU算子的MacUsage为空，WorkLoad单元格中有空格
+static const char *g_perf_detail_v15 =
+    "---------------------------------------------------------------------------------------------------------------\n"
+    "                                 Network Layer Information Table\n"
+    "---------------------------------------------------------------------------------------------------------------\n"
+    "ID   OpType           DataType Target InputShape                      OutputShape            Cycles(DDR/NPU/Total)    Time(us)     MacUsage(%)          WorkLoad(0/1/2)-ImproveTherical        Task Number   Lut Number   RW(KB)       FullName\n"
+    "---------------------------------------------------------------------------------------------------------------\n"
+    "1    InputOperator    UINT8    CPU    \\                               (1,3,640,640)          0/0/0                    12                                0.0%/0.0%/0.0% - Up:0.0%               0             0            1200.00      InputOperator:images\n"
+    "2    ConvRelu         UINT8    NPU    (1,3,640,640),(32,3,6,6),(32)   (1,32,320,320)         123/456/789              321          12.34/34.56/56.78    100.0%/0.0%/0.0% - Up:0.0%             14            0            3400.50      Conv:/model.0/conv/Conv\n"
+    "3    Sigmoid          INT8     NPU    (1,255,80,80)                   (1,255,80,80)          0/0/0                    45           \\                    100.0%/0.0%/0.0% - Up:0.0%             2             1            3200.00      Sigmoid:/model.24/Sigmoid\n"
+    "4    OutputOperator   INT8     CPU    (1,255,80,80)                   \\                      0/0/0                    7                                 0.0%/0.0%/0.0% - Up:0.0%               0             0            1600.00      OutputOperator:output\n"
+    "---------------------------------------------------------------------------------------------------------------\n"
+    "Total Operator Elapsed Per Frame Time(us): 385\n"
+    "Total Memory Read/Write Per Frame Size(KB): 9400.50\n"
+    "---------------------------------------------------------------------------------------------------------------\n"
+    "                                 Operator Time Consuming Ranking Table\n"
+    "OpType           CallNumber   CPUTime(us)  GPUTime(us)  NPUTime(us)  TotalTime(us)  TimeRatio(%)\n"
+    "ConvRelu         1            0            0            321          321            83.38%\n";
+
+// 较早的格式：Cycles分成三列，没有WorkLoad列，CPU算子的MacUsage为空
+static const char *g_perf_detail_v14 =
+    "ID   OpType           DataType Target InputShape            OutputShape       DDR Cycles   NPU Cycles   Total Cycles   Time(us)   MacUsage(%)   Task Number   Lut Number   RW(KB)     FullName\n"
+    "1    InputOperator    UINT8    CPU    \\                     (1,3,640,640)     0            0            0              10                       0             0            1200.00    InputOperator:images\n"
+    "2    Conv             INT8     NPU    (1,3,640,640)         (1,32,320,320)    100          200          300            250        35.20         12            0            3400.00    Conv:/model.0/conv/Conv\n"
+    "Total Operator Elapsed Per Frame Time(us): 260\n";
+
+NN_TEST(perf, parse_workload_with_spaces)
+{
+    std::vector<perf_layer_s> layers;
+    NN_ASSERT(PerfProfiler::ParsePerfDetail(g_perf_detail_v15, layers) == 4);
+    NN_CHECK(layers[0].id == 1 && layers[0].op_type == "InputOperator" && layers[0].target == "CPU");
+    NN_CHECK(layers[0].time_us == 12);
+    NN_CHECK(layers[0].name == "InputOperator:images");
+    NN_CHECK(layers[1].op_type == "ConvRelu" && layers[1].target == "NPU" && layers[1].time_us == 321);
+    NN_CHECK(layers[1].name == "Conv:/model.0/conv/Conv");
+    NN_CHECK(layers[2].name == "Sigmoid:/model.24/Sigmoid" && layers[2].time_us == 45);
+    NN_CHECK(layers[3].id == 4 && layers[3].name == "OutputOperator:output" && layers[3].time_us == 7);
+}
+
+NN_TEST(perf, parse_split_cycle_columns)
+{
+    std::vector<perf_layer_s> layers;
+    NN_ASSERT(PerfProfiler::ParsePerfDetail(g_perf_detail_v14, layers) == 2);
+    NN_CHECK(layers[0].time_us == 10 && layers[0].name == "InputOperator:images");
+    NN_CHECK(layers[1].time_us == 250 && layers[1].name == "Conv:/model.0/conv/Conv");
+}
+
+NN_TEST(perf, parse_without_header)
+{
+    std::vector<perf_layer_s> layers;
+    NN_CHECK(PerfProfiler::ParsePerfDetail("1 Conv INT8 NPU 100\n", layers) == -1);
+    NN_CHECK(layers.empty());
+}
+
+// 多帧汇总：每层的min/mean/max
+NN_TEST(perf, summarize_frames)
+{
+    PerfProfiler profiler;
+    NN_ASSERT(profiler.AddFrame(g_perf_detail_v15, 400) == NN_SUCCESS);
+    NN_ASSERT(profiler.AddFrame(g_perf_detail_v15, 500) == NN_SUCCESS);
+    NN_CHECK(profiler.FrameCount() == 2);
+    auto stats = profiler.LayerStats();
+    NN_ASSERT(stats.size() == 4);
+    NN_CHECK(stats[1].count == 2 && stats[1].min_us == 321 && stats[1].max_us == 321);
+    NN_CHECK(stats[1].name == "Conv:/model.0/conv/Conv");
+    auto run = profiler.RunStats();
+    NN_CHECK(run.min_us == 400 && run.max_us == 500 && run.mean_us == 450);
+}
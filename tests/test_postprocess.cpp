@@ -0,0 +1,289 @@
+// 后处理的测试：objectness预筛选的NEON/SSE2和标量实现逐个下标对比，解码查找表和直接计算对比，
+// 分桶NMS和原来逐类别的NMS对比，NMS前的top-K截断
+
+#include "nn_test.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <random>
+
+#include "legacy_nms.h"
+#include "process/yolov5_postprocess.h"
+
+// 逐个比较的参考实现
+static std::vector<int> prescan_reference(const int8_t *conf, int n, int8_t thres)
+{
+    std::vector<int> indices;
+    for (int i = 0; i < n; i++)
+    {
+        if (conf[i] >= thres)
+        {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+static std::vector<int> prescan(const int8_t *conf, int n, int8_t thres, bool simd)
+{
+    std::vector<int> indices(n);
+    yolov5::postprocess_enable_simd(simd);
+    int count = yolov5::prescan_objectness(conf, n, thres, indices.data());
+    yolov5::postprocess_enable_simd(true);
+    indices.resize(count);
+    return indices;
+}
+
+// 随机的int8平面（均匀分布和稀疏分布），长度不是64的倍数、起始地址不对齐、阈值取到边界时，
+// NEON/SSE2和标量实现的结果都和逐个比较相同
+NN_TEST(postprocess, prescan_simd_matches_scalar)
+{
+    std::mt19937 rng(2024);
+    std::uniform_int_distribution<int> value(-128, 127);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    const int lengths[] = {0, 1, 63, 64, 65, 127, 400, 1600, 6400, 6401};
+    const int thresholds[] = {-128, -1, 0, 1, 50, 127};
+    const float hit_ratios[] = {1.f, 0.01f};
+    for (int n : lengths)
+    {
+        for (float hit_ratio : hit_ratios)
+        {
+            // 多分配3个字节，用于错开起始地址
+            std::vector<int8_t> buf(n + 3);
+            for (int8_t &v : buf)
+            {
+                v = uniform(rng) < hit_ratio ? (int8_t)value(rng) : -128;
+            }
+            for (int offset = 0; offset < 4; offset++)
+            {
+                const int8_t *conf = buf.data() + offset;
+                int len = std::min(n, (int)buf.size() - offset);
+                for (int t : thresholds)
+                {
+                    std::vector<int> expected = prescan_reference(conf, len, (int8_t)t);
+                    NN_CHECK(prescan(conf, len, (int8_t)t, true) == expected);
+                    NN_CHECK(prescan(conf, len, (int8_t)t, false) == expected);
+                }
+            }
+        }
+    }
+}
+
+// 查找表的每一项和直接反量化后求sigmoid相同：覆盖全部256个int8值，zp和scale取常见的范围
+NN_TEST(postprocess, decode_lut_matches_sigmoid)
+{
+    const int32_t zps[] = {-128, -60, 0, 37, 127};
+    const float scales[] = {0.003f, 0.0254f, 0.1f, 0.5f};
+    yolov5::DECODE_LUT lut;
+    for (int32_t zp : zps)
+    {
+        for (float scale : scales)
+        {
+            yolov5::build_decode_lut(zp, scale, &lut);
+            float max_err = 0;
+            for (int q = -128; q <= 127; q++)
+            {
+                // sigmoid(deqnt_affine_to_f32(q, zp, scale))
+                float x = ((float)q - (float)zp) * scale;
+                float s = 1.f / (1.f + expf(-x));
+                max_err = std::max(max_err, fabsf(lut.sigmoid[q + 128] - s));
+                max_err = std::max(max_err, fabsf(lut.xy[q + 128] - (s * 2.f - 0.5f)));
+                // wh的范围是[0, 4]，按相对误差比较
+                max_err = std::max(max_err, fabsf(lut.wh[q + 128] - (s * 2.f) * (s * 2.f)) / 4.f);
+            }
+            if (max_err > 1e-6f)
+            {
+                printf("  zp %d scale %.4f: max error %g\n", zp, scale, max_err);
+            }
+            NN_CHECK(max_err <= 1e-6f);
+        }
+    }
+}
+
+static const int g_model_size = 640;
+
+// 每个目标在相邻网格和anchor上产生5个抖动的框，类别相同；置信度互不相同，排序没有歧义。
+// spacing大于0时目标排成间隔spacing的网格，不同目标的框互不重叠；否则位置随机，目标之间也会重叠
+static void make_nms_candidates(int object_num, int class_num, float spacing, yolov5::PostprocessContext &ctx)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(0.f, g_model_size - 80.f);
+    std::uniform_real_distribution<float> size(10.f, 40.f);
+    std::uniform_real_distribution<float> jitter(-3.f, 3.f);
+    std::uniform_int_distribution<int> cls(0, class_num - 1);
+    int per_row = spacing > 0 ? (int)(g_model_size / spacing) : 1;
+    ctx.Clear();
+    for (int o = 0; o < object_num; o++)
+    {
+        float x = spacing > 0 ? (o % per_row) * spacing : pos(rng);
+        float y = spacing > 0 ? (o / per_row) * spacing : pos(rng);
+        float w = size(rng);
+        float h = size(rng);
+        int class_id = cls(rng);
+        for (int k = 0; k < 5; k++)
+        {
+            float box[4] = {x + jitter(rng), y + jitter(rng), w + jitter(rng), h + jitter(rng)};
+            ctx.boxes.insert(ctx.boxes.end(), box, box + 4);
+            ctx.class_ids.push_back(class_id);
+        }
+    }
+    int n = ctx.class_ids.size();
+    for (int i = 0; i < n; i++)
+    {
+        ctx.probs.push_back(0.2f + 0.8f * (i + 1) / (n + 1));
+    }
+    std::shuffle(ctx.probs.begin(), ctx.probs.end(), rng);
+}
+
+// 按置信度从高到低重排候选框，排序后的位置和下标一致，原实现按位置取类别的问题不影响结果
+static void sort_nms_candidates(yolov5::PostprocessContext &ctx)
+{
+    int n = ctx.probs.size();
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return ctx.probs[a] > ctx.probs[b]; });
+    yolov5::PostprocessContext sorted;
+    for (int i : order)
+    {
+        sorted.boxes.insert(sorted.boxes.end(), ctx.boxes.begin() + i * 4, ctx.boxes.begin() + i * 4 + 4);
+        sorted.probs.push_back(ctx.probs[i]);
+        sorted.class_ids.push_back(ctx.class_ids[i]);
+    }
+    ctx.boxes.swap(sorted.boxes);
+    ctx.probs.swap(sorted.probs);
+    ctx.class_ids.swap(sorted.class_ids);
+}
+
+// 分桶NMS（不限制候选框数量）和原实现保留同样的框，顺序和数量上限（OBJ_NUMB_MAX_SIZE）一致
+static void check_matches_legacy(yolov5::PostprocessContext &ctx)
+{
+    int valid_count = ctx.probs.size();
+    std::vector<float> legacy_probs = ctx.probs;
+    std::vector<int> legacy_kept;
+    int legacy_count =
+        legacy_finish(valid_count, ctx.boxes, legacy_probs, ctx.class_ids, NMS_THRESH, &legacy_kept);
+
+    yolov5::detect_result_group_t group;
+    yolov5::finish_detections(valid_count, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f, 0, &group);
+    NN_ASSERT(group.count == legacy_count);
+    for (int i = 0; i < group.count; i++)
+    {
+        int n = legacy_kept[i];
+        NN_CHECK(group.results[i].prop == ctx.probs[n]);
+        NN_CHECK(group.results[i].id == ctx.class_ids[n]);
+    }
+}
+
+// 单一类别：原实现按类别遍历的问题都不出现，目标之间相互重叠时结果也应一致
+NN_TEST(postprocess, bucketed_nms_matches_legacy_single_class)
+{
+    const int object_nums[] = {5, 40, 300};
+    for (int object_num : object_nums)
+    {
+        yolov5::PostprocessContext ctx;
+        make_nms_candidates(object_num, 1, 0.f, ctx);
+        check_matches_legacy(ctx);
+    }
+}
+
+// 多类别：原实现的内层循环不区分类别，只在重叠的框类别相同时等价，所以目标之间互不重叠
+NN_TEST(postprocess, bucketed_nms_matches_legacy_separated_classes)
+{
+    const int object_nums[] = {10, 60, 100};
+    for (int object_num : object_nums)
+    {
+        yolov5::PostprocessContext ctx;
+        make_nms_candidates(object_num, OBJ_CLASS_NUM, 60.f, ctx);
+        sort_nms_candidates(ctx);
+        check_matches_legacy(ctx);
+    }
+}
+
+// 互不重叠的候选框，每个目标一个框，NMS不抑制任何框；置信度互不相同
+static void make_separated_candidates(int num, yolov5::PostprocessContext &ctx)
+{
+    std::mt19937 rng(7);
+    ctx.Clear();
+    for (int i = 0; i < num; i++)
+    {
+        float box[4] = {(i % 10) * 60.f, (i / 10) * 60.f, 40.f, 40.f};
+        ctx.boxes.insert(ctx.boxes.end(), box, box + 4);
+        ctx.probs.push_back(0.2f + 0.8f * (i + 1) / (num + 1));
+        ctx.class_ids.push_back(i % OBJ_CLASS_NUM);
+    }
+    std::shuffle(ctx.probs.begin(), ctx.probs.end(), rng);
+}
+
+static bool same_results(const yolov5::detect_result_group_t &a, const yolov5::detect_result_group_t &b)
+{
+    if (a.count != b.count)
+    {
+        return false;
+    }
+    for (int i = 0; i < a.count; i++)
+    {
+        const yolov5::detect_result_t &ra = a.results[i];
+        const yolov5::detect_result_t &rb = b.results[i];
+        if (ra.prop != rb.prop || ra.id != rb.id || ra.box.left != rb.box.left || ra.box.top != rb.box.top ||
+            ra.box.right != rb.box.right || ra.box.bottom != rb.box.bottom)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// top_k截断后只有置信度最高的K个候选框进入NMS
+NN_TEST(postprocess, top_k_keeps_highest_scores)
+{
+    const int num = 50;
+    const int top_k = 20;
+    yolov5::PostprocessContext ctx;
+    make_separated_candidates(num, ctx);
+    std::vector<float> sorted = ctx.probs;
+    std::sort(sorted.begin(), sorted.end(), [](float a, float b) { return a > b; });
+
+    yolov5::detect_result_group_t group;
+    yolov5::finish_detections(num, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f, top_k, &group);
+    NN_ASSERT(group.count == top_k);
+    for (int i = 0; i < top_k; i++)
+    {
+        NN_CHECK(group.results[i].prop == sorted[i]);
+    }
+}
+
+// top_k为0或负数时不截断
+NN_TEST(postprocess, top_k_non_positive_is_unlimited)
+{
+    const int num = 50;
+    yolov5::PostprocessContext ctx;
+    make_separated_candidates(num, ctx);
+    const int top_ks[] = {0, -1};
+    for (int top_k : top_ks)
+    {
+        yolov5::detect_result_group_t group;
+        yolov5::finish_detections(num, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f, top_k, &group);
+        NN_CHECK(group.count == num);
+    }
+}
+
+// 候选框不多于K个时截断不改变结果（包括NMS抑制的框）
+NN_TEST(postprocess, top_k_above_candidates_changes_nothing)
+{
+    yolov5::PostprocessContext ctx;
+    make_nms_candidates(40, 4, 0.f, ctx);
+    int valid_count = ctx.probs.size();
+    yolov5::detect_result_group_t unlimited;
+    yolov5::finish_detections(valid_count, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f, 0, &unlimited);
+    const int top_ks[] = {valid_count, valid_count + 1, PRE_NMS_TOP_K};
+    for (int top_k : top_ks)
+    {
+        yolov5::detect_result_group_t group;
+        yolov5::finish_detections(valid_count, ctx, g_model_size, g_model_size, NMS_THRESH, 1.f, 1.f, top_k, &group);
+        NN_CHECK(same_results(group, unlimited));
+    }
+}
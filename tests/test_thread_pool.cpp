@@ -0,0 +1,42 @@
+// 线程池的测试：运动门限跳过的帧沿用最近一次推理完成的结果
+
+#include "nn_test.h"
+
+#include "task/yolov5_thread_pool.h"
+#include "test_util.h"
+
+static const int g_model_size = 640;
+
+// 帧1在推理时提交静止的帧2，帧2沿用帧0的结果；帧1完成后，静止的帧3拿到帧1的结果，
+// 不会因为帧2的帧号更大而一直沿用帧0的结果
+NN_TEST(thread_pool, skipped_frame_gets_newest_inferred_result)
+{
+    // 回放的第k次推理有k+1个目标
+    std::vector<std::vector<nn_test_object_s>> frames = {{{4, 4, 0}}, {{4, 4, 0}, {10, 10, 1}}};
+    std::string path = nn_test_temp_path("thread_pool_gate.cap");
+    NN_ASSERT(nn_test_write_yolo_capture(path, g_model_size, g_model_size, frames));
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    config.replay_latency_us = 200000;
+    Yolov5ThreadPool pool;
+    pool.setMotionGate();
+    NN_ASSERT(pool.setUp(path, 1, config) == NN_SUCCESS);
+
+    cv::Mat still = cv::Mat::zeros(720, 1280, CV_8UC3);
+    cv::Mat moving = still.clone();
+    cv::rectangle(moving, cv::Rect(400, 200, 400, 300), cv::Scalar::all(255), cv::FILLED);
+    std::vector<Detection> objects;
+    NN_ASSERT(pool.submitTask(still, 0) == NN_SUCCESS); // 第一帧总是推理
+    pool.getTargetResult(objects, 0);
+    NN_CHECK(objects.size() == 1);
+    NN_ASSERT(pool.submitTask(moving, 1) == NN_SUCCESS); // 画面变化，推理
+    NN_ASSERT(pool.submitTask(still, 2) == NN_SUCCESS);  // 静止，帧1还在推理
+    pool.getTargetResult(objects, 2);
+    NN_CHECK(objects.size() == 1);
+    pool.getTargetResult(objects, 1);
+    NN_CHECK(objects.size() == 2);
+    NN_ASSERT(pool.submitTask(still, 3) == NN_SUCCESS); // 静止
+    pool.getTargetResult(objects, 3);
+    NN_CHECK(objects.size() == 2);
+    pool.stopAll();
+}
@@ -0,0 +1,117 @@
+// 切片推理的测试：切片划分、切片边界两侧结果的合并，以及RunTiled把切片坐标换算回原图
+
+#include "nn_test.h"
+
+#include "process/tiling.h"
+#include "task/yolov5.h"
+#include "test_util.h"
+
+static Detection make_detection(int class_id, float confidence, const cv::Rect &box)
+{
+    Detection det;
+    det.class_id = class_id;
+    det.confidence = confidence;
+    det.box = box;
+    return det;
+}
+
+// 切片覆盖整个画面，相邻切片至少重叠overlap，最后一个切片贴齐边缘
+NN_TEST(tiling, tiles_cover_frame)
+{
+    auto tiles = make_tiles(1280, 720, 640, 640, 0.2f);
+    NN_ASSERT(tiles.size() == 6);
+    const int xs[] = {0, 512, 640};
+    const int ys[] = {0, 80};
+    for (size_t i = 0; i < tiles.size(); i++)
+    {
+        NN_CHECK(tiles[i].x == xs[i % 3] && tiles[i].y == ys[i / 3]);
+        NN_CHECK(tiles[i].width == 640 && tiles[i].height == 640);
+    }
+    // 画面比切片小的方向只有一个切片，切片不超出画面
+    tiles = make_tiles(500, 300, 640, 640, 0.2f);
+    NN_ASSERT(tiles.size() == 1);
+    NN_CHECK(tiles[0] == cv::Rect(0, 0, 500, 300));
+    NN_CHECK(make_tiles(0, 720, 640, 640, 0.2f).empty());
+}
+
+// 目标跨过切片边界：左边切片只看到一部分（IoU低于NMS阈值），右边切片看到整个目标，合并为两者的并集
+NN_TEST(tiling, merge_object_cut_by_seam)
+{
+    std::vector<Detection> objects = {
+        make_detection(0, 0.9f, cv::Rect(600, 100, 30, 50)), // 切片0，右边被切掉
+        make_detection(0, 0.8f, cv::Rect(600, 100, 80, 50)), // 切片1，完整
+    };
+    std::vector<int> tile_ids = {0, 1};
+    merge_tile_detections(objects, tile_ids, 0.45f, 0.6f);
+    NN_ASSERT(objects.size() == 1);
+    // 保留置信度高的一个，框扩展为并集
+    NN_CHECK(objects[0].confidence == 0.9f);
+    NN_CHECK(objects[0].box == cv::Rect(600, 100, 80, 50));
+}
+
+// 同一切片内互相重叠的目标（IoU低于阈值）、不同类别的目标都不合并；IoU超过阈值的重复框只保留一个
+NN_TEST(tiling, merge_keeps_distinct_objects)
+{
+    std::vector<Detection> objects = {
+        make_detection(0, 0.9f, cv::Rect(600, 100, 30, 50)),
+        make_detection(0, 0.8f, cv::Rect(600, 100, 80, 50)),  // 同一切片，被前一个覆盖但IoU低
+        make_detection(1, 0.7f, cv::Rect(600, 100, 30, 50)),  // 不同类别
+        make_detection(0, 0.6f, cv::Rect(602, 101, 30, 50)),  // 和第一个重复
+        make_detection(0, 0.5f, cv::Rect(900, 300, 40, 40)),  // 不相交
+    };
+    std::vector<int> tile_ids = {0, 0, 0, 1, 1};
+    merge_tile_detections(objects, tile_ids, 0.45f, 0.6f);
+    NN_ASSERT(objects.size() == 4);
+    NN_CHECK(objects[0].confidence == 0.9f && objects[0].box == cv::Rect(600, 100, 30, 50));
+    NN_CHECK(objects[1].confidence == 0.8f && objects[1].box == cv::Rect(600, 100, 80, 50));
+    NN_CHECK(objects[2].class_id == 1);
+    NN_CHECK(objects[3].confidence == 0.5f);
+}
+
+// 回放的每个切片输出同一个目标，结果是每个切片中的目标平移到原图坐标
+NN_TEST(tiling, run_tiled_maps_tiles_to_frame)
+{
+    const int model_size = 640;
+    std::string path = nn_test_temp_path("tiling.cap");
+    NN_ASSERT(nn_test_write_yolo_capture(path, model_size, model_size, {{{10, 20, 0}}}));
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    config.tiled = true;
+    config.tile_full_frame = false;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+
+    std::vector<Detection> objects;
+    NN_ASSERT(yolo.Run(cv::Mat::zeros(720, 1280, CV_8UC3), objects) == NN_SUCCESS);
+    auto tiles = make_tiles(1280, 720, model_size, model_size, config.tile_overlap);
+    NN_ASSERT(objects.size() == tiles.size());
+    for (const cv::Rect &tile : tiles)
+    {
+        cv::Rect expected(tile.x + 159, tile.y + 78, 10, 13);
+        bool found = false;
+        for (const Detection &obj : objects)
+        {
+            found = found || obj.box == expected;
+        }
+        NN_CHECK(found);
+    }
+    uint64_t tiles_run = 0;
+    uint64_t busy_us = 0;
+    yolo.GetTileStats(tiles_run, busy_us);
+    NN_CHECK(tiles_run == tiles.size());
+}
+
+// 切片预处理失败时RunTiled返回错误
+NN_TEST(tiling, run_tiled_propagates_preprocess_error)
+{
+    std::string path = nn_test_temp_path("tiling_error.cap");
+    NN_ASSERT(nn_test_write_yolo_capture(path, 640, 640, std::vector<std::vector<nn_test_object_s>>(1)));
+    Yolov5Config config;
+    config.backend = NN_BACKEND_REPLAY;
+    config.tiled = true;
+    Yolov5 yolo(config);
+    NN_ASSERT(yolo.LoadModel(path.c_str()) == NN_SUCCESS);
+    std::vector<Detection> objects;
+    NN_CHECK(yolo.Run(cv::Mat::zeros(720, 1280, CV_8UC1), objects) == NN_IMG_INPUT_ERROR);
+    NN_CHECK(objects.empty());
+}
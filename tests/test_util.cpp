@@ -0,0 +1,171 @@
+// test_util.h的实现
+
+#include "test_util.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <random>
+
+#include "engine/capture_file.h"
+
+static std::vector<std::string> g_temp_paths; // 退出时删除的临时文件
+
+static void remove_temp_files()
+{
+    for (auto &path : g_temp_paths)
+    {
+        unlink(path.c_str());
+    }
+}
+
+std::string nn_test_temp_path(const std::string &name)
+{
+    if (g_temp_paths.empty())
+    {
+        atexit(remove_temp_files);
+    }
+    const char *dir = getenv("TMPDIR");
+    std::string path = std::string(dir != nullptr ? dir : "/tmp") + "/nn_test_" + std::to_string(getpid()) + "_" + name;
+    g_temp_paths.push_back(path);
+    return path;
+}
+
+tensor_attr_s nn_test_attr(uint32_t index, uint32_t d0, uint32_t d1, uint32_t d2, uint32_t d3, tensor_datatype_e type,
+                           tensor_layout_e layout)
+{
+    tensor_attr_s attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.index = index;
+    attr.n_dims = 4;
+    attr.dims[0] = d0;
+    attr.dims[1] = d1;
+    attr.dims[2] = d2;
+    attr.dims[3] = d3;
+    attr.n_elems = d0 * d1 * d2 * d3;
+    attr.size = attr.n_elems * nn_tensor_type_to_size(type);
+    attr.type = type;
+    attr.layout = layout;
+    attr.zp = 0;
+    attr.scale = 1.f;
+    return attr;
+}
+
+bool nn_test_write_capture(const std::string &path, const std::vector<tensor_attr_s> &in_shapes,
+                           const std::vector<tensor_attr_s> &out_shapes,
+                           const std::vector<std::vector<std::vector<int8_t>>> &frames)
+{
+    CaptureWriter writer;
+    if (writer.Open(path, in_shapes, out_shapes) != NN_SUCCESS)
+    {
+        return false;
+    }
+    for (auto &frame : frames)
+    {
+        std::vector<tensor_data_s> outputs(frame.size());
+        for (size_t i = 0; i < frame.size(); i++)
+        {
+            outputs[i].attr = out_shapes[i];
+            outputs[i].data = (void *)frame[i].data();
+        }
+        if (writer.WriteFrame(outputs) != NN_SUCCESS)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static const int g_yolo_strides[3] = {8, 16, 32};
+static const float g_yolo_scale = 0.1f;
+static const int g_yolo_prop_size = 85; // 每个anchor的通道数：4个框坐标、objectness、80个类别
+
+std::vector<tensor_attr_s> nn_test_yolo_output_shapes(int model_w, int model_h)
+{
+    std::vector<tensor_attr_s> shapes;
+    for (int i = 0; i < 3; i++)
+    {
+        tensor_attr_s attr = nn_test_attr(i, 1, 255, model_h / g_yolo_strides[i], model_w / g_yolo_strides[i],
+                                          NN_TENSOR_INT8, NN_TENSOR_NCHW);
+        attr.scale = g_yolo_scale;
+        shapes.push_back(attr);
+    }
+    return shapes;
+}
+
+std::vector<std::vector<int8_t>> nn_test_yolo_outputs(int model_w, int model_h, const std::vector<nn_test_object_s> &objects)
+{
+    auto shapes = nn_test_yolo_output_shapes(model_w, model_h);
+    std::vector<std::vector<int8_t>> outputs;
+    for (auto &shape : shapes)
+    {
+        // 背景：所有通道为-128，sigmoid(-12.8)远低于阈值
+        outputs.push_back(std::vector<int8_t>(shape.size, -128));
+    }
+    int grid_w = shapes[0].dims[3];
+    int grid_len = shapes[0].dims[2] * grid_w;
+    for (auto &obj : objects)
+    {
+        int8_t *cell = outputs[0].data() + obj.row * grid_w + obj.col;
+        // xy和wh为0：中心在网格中心，宽高等于anchor；objectness和类别分数为10
+        cell[0 * grid_len] = 0;
+        cell[1 * grid_len] = 0;
+        cell[2 * grid_len] = 0;
+        cell[3 * grid_len] = 0;
+        cell[4 * grid_len] = 100;
+        cell[(5 + obj.class_id) * grid_len] = 100;
+    }
+    return outputs;
+}
+
+std::vector<std::vector<int8_t>> nn_test_random_yolo_outputs(int model_w, int model_h, float hit_ratio, unsigned seed)
+{
+    auto shapes = nn_test_yolo_output_shapes(model_w, model_h);
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> any_q(-128, 127);
+    std::uniform_int_distribution<int> low_q(-128, -10);
+    std::uniform_int_distribution<int> high_q(0, 60);
+    std::uniform_int_distribution<int> class_dist(0, 79);
+    std::uniform_real_distribution<float> hit_dist(0.f, 1.f);
+    std::vector<std::vector<int8_t>> outputs;
+    for (auto &shape : shapes)
+    {
+        int grid_len = shape.dims[2] * shape.dims[3];
+        std::vector<int8_t> data(shape.size);
+        for (auto &v : data)
+        {
+            v = (int8_t)low_q(rng);
+        }
+        for (int a = 0; a < 3; a++)
+        {
+            int8_t *base = data.data() + g_yolo_prop_size * a * grid_len;
+            for (int cell = 0; cell < grid_len; cell++)
+            {
+                if (hit_dist(rng) >= hit_ratio)
+                {
+                    continue;
+                }
+                for (int k = 0; k < 4; k++)
+                {
+                    base[k * grid_len + cell] = (int8_t)any_q(rng) / 4;
+                }
+                base[4 * grid_len + cell] = (int8_t)high_q(rng);
+                base[(5 + class_dist(rng)) * grid_len + cell] = (int8_t)high_q(rng);
+            }
+        }
+        outputs.push_back(data);
+    }
+    return outputs;
+}
+
+bool nn_test_write_yolo_capture(const std::string &path, int model_w, int model_h,
+                                const std::vector<std::vector<nn_test_object_s>> &frames)
+{
+    std::vector<tensor_attr_s> in_shapes = {nn_test_attr(0, 1, model_h, model_w, 3, NN_TENSOR_UINT8, NN_TENSOR_NHWC)};
+    std::vector<std::vector<std::vector<int8_t>>> frame_outputs;
+    for (auto &objects : frames)
+    {
+        frame_outputs.push_back(nn_test_yolo_outputs(model_w, model_h, objects));
+    }
+    return nn_test_write_capture(path, in_shapes, nn_test_yolo_output_shapes(model_w, model_h), frame_outputs);
+}
@@ -0,0 +1,42 @@
+// 测试共用的工具：临时文件、张量属性、回放引擎的录制文件
+
+#ifndef RK3588_DEMO_TEST_UTIL_H
+#define RK3588_DEMO_TEST_UTIL_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "types/datatype.h"
+
+std::string nn_test_temp_path(const std::string &name); // 本进程独占的临时文件路径，退出时删除（回放文件按路径缓存，每个测试使用不同的名字）
+
+// 4维张量属性，n_elems和size按类型计算
+tensor_attr_s nn_test_attr(uint32_t index, uint32_t d0, uint32_t d1, uint32_t d2, uint32_t d3, tensor_datatype_e type,
+                           tensor_layout_e layout);
+
+// 写出回放引擎使用的录制文件，frames[f][i]为第f帧第i个输出的数据
+bool nn_test_write_capture(const std::string &path, const std::vector<tensor_attr_s> &in_shapes,
+                           const std::vector<tensor_attr_s> &out_shapes,
+                           const std::vector<std::vector<std::vector<int8_t>>> &frames);
+
+// 合成的YOLOv5输出：三个NCHW int8输出[1, 255, h/stride, w/stride]，zp=0，scale=0.1
+// 每个目标放在stride 8输出第(row, col)个网格的第0个anchor上，解码后是模型输入中
+// 中心为((col + 0.5) * 8, (row + 0.5) * 8)、大小为10x13、置信度约为1的框
+typedef struct
+{
+    int row;
+    int col;
+    int class_id;
+} nn_test_object_s;
+
+std::vector<tensor_attr_s> nn_test_yolo_output_shapes(int model_w, int model_h);
+std::vector<std::vector<int8_t>> nn_test_yolo_outputs(int model_w, int model_h, const std::vector<nn_test_object_s> &objects);
+// 拥挤画面：每个网格的每个anchor以hit_ratio的概率超过置信度阈值，类别和框随机；seed相同时结果相同
+std::vector<std::vector<int8_t>> nn_test_random_yolo_outputs(int model_w, int model_h, float hit_ratio, unsigned seed);
+// 写出Yolov5回放后端使用的录制文件，第f帧包含frames[f]中的目标
+bool nn_test_write_yolo_capture(const std::string &path, int model_w, int model_h,
+                                const std::vector<std::vector<nn_test_object_s>> &frames);
+
+#endif // RK3588_DEMO_TEST_UTIL_H